@@ -0,0 +1,189 @@
+#include <cstddef>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <board_state.h>
+#include <game_mechanics.h>
+#include <move_generator.h>
+#include <negamax_solver.h>
+#include <preset_positions.h>
+#include <solver.h>
+
+namespace
+{
+
+//! Small enough that constructing a solver does not dominate the endgame solves below
+constexpr std::size_t kBenchTranspositionTableSizeBytes{ std::size_t{ 4 } << 20 };
+
+//! Default-sized board where pit 0 of player 0 holds `num_stones` stones and every other pit holds two
+BoardState makeSowingBoardState(const int num_stones)
+{
+    std::vector<int> player_0_pits(6, 2);
+    player_0_pits[0] = num_stones;
+
+    return BoardState{ SinglePlayerBoardState{ player_0_pits, 0 }, SinglePlayerBoardState{ std::vector<int>(6, 2), 0 } };
+}
+
+void BM_PlayTurn(benchmark::State& state)
+{
+    const BoardState board_state{ makeSowingBoardState(static_cast<int>(state.range(0))) };
+    const TurnExecutor turn_executor{};
+
+    for (auto _ : state)
+    {
+        BoardState board_state_i{ board_state };
+        benchmark::DoNotOptimize(turn_executor.playTurn(/*player_index*/ 0, /*pit_index*/ 0, board_state_i));
+        benchmark::DoNotOptimize(board_state_i);
+    }
+}
+BENCHMARK(BM_PlayTurn)->Arg(1)->Arg(4)->Arg(8)->Arg(13)->Arg(26)->Arg(52);
+
+//! Kalah with captures from empty opposing pits, which should cost the same as `BM_PlayTurn`
+struct EmptyCaptureKalahRules : KalahRules
+{
+    static constexpr bool kCapturesFromEmptyOpposingPit{ true };
+};
+
+void BM_PlayTurnEmptyCaptureRules(benchmark::State& state)
+{
+    const BoardState board_state{ makeSowingBoardState(static_cast<int>(state.range(0))) };
+    const BasicTurnExecutor<EmptyCaptureKalahRules> turn_executor{};
+
+    for (auto _ : state)
+    {
+        BoardState board_state_i{ board_state };
+        benchmark::DoNotOptimize(turn_executor.playTurn(/*player_index*/ 0, /*pit_index*/ 0, board_state_i));
+        benchmark::DoNotOptimize(board_state_i);
+    }
+}
+BENCHMARK(BM_PlayTurnEmptyCaptureRules)->Arg(1)->Arg(4)->Arg(8)->Arg(13)->Arg(26)->Arg(52);
+
+void BM_MakeUnmakeMove(benchmark::State& state)
+{
+    BoardState board_state{ makeSowingBoardState(static_cast<int>(state.range(0))) };
+    const TurnExecutor turn_executor{};
+
+    for (auto _ : state)
+    {
+        MoveUndo undo{};
+        benchmark::DoNotOptimize(turn_executor.makeMove(/*player_index*/ 0, /*pit_index*/ 0, board_state, undo));
+        turn_executor.unmakeMove(undo, board_state);
+        benchmark::DoNotOptimize(board_state);
+    }
+}
+BENCHMARK(BM_MakeUnmakeMove)->Arg(1)->Arg(4)->Arg(8)->Arg(13)->Arg(26)->Arg(52);
+
+void BM_BoardCopy(benchmark::State& state)
+{
+    const BoardState board_state{ makeDefaultBoardState() };
+
+    for (auto _ : state)
+    {
+        BoardState board_state_i{ board_state };
+        benchmark::DoNotOptimize(board_state_i);
+    }
+}
+BENCHMARK(BM_BoardCopy);
+
+void BM_ExpandChildren(benchmark::State& state)
+{
+    const Position position{ makeMidGameBoardState(static_cast<std::size_t>(state.range(0))) };
+    const MoveGenerator move_generator{};
+    std::vector<ExpandedChild> children{};
+
+    for (auto _ : state)
+    {
+        children.clear();
+        benchmark::DoNotOptimize(move_generator.expand(position.board_state, position.active_player_index, children));
+        benchmark::DoNotOptimize(children.data());
+    }
+}
+BENCHMARK(BM_ExpandChildren)->Arg(0)->Arg(20)->Arg(40);
+
+void BM_IsGameFinished(benchmark::State& state)
+{
+    const Position position{ makeMidGameBoardState(static_cast<std::size_t>(state.range(0))) };
+    const GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, position.active_player_index };
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(game_mechanics_executor.isGameFinished(position.board_state));
+    }
+}
+BENCHMARK(BM_IsGameFinished)->Arg(0)->Arg(40);
+
+void BM_GetWinnerPlayerIndex(benchmark::State& state)
+{
+    // Player 1's side is empty, so the game is finished and has to be scored
+    const BoardState board_state{ SinglePlayerBoardState{ std::vector<int>{ 1, 2, 0, 3, 0, 4 }, 14 },
+                                  SinglePlayerBoardState{ std::vector<int>(6, 0), 24 } };
+    const GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, /*starting_player_index*/ 0 };
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(game_mechanics_executor.getWinnerPlayerIndex(board_state));
+    }
+}
+BENCHMARK(BM_GetWinnerPlayerIndex);
+
+void runSolverBenchmark(benchmark::State& state, const Position& position)
+{
+    const GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, position.active_player_index };
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        Solver solver{ kBenchTranspositionTableSizeBytes };
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(solver.solve(position.board_state, game_mechanics_executor));
+    }
+}
+
+void BM_SolverSolveTestBoard(benchmark::State& state)
+{
+    runSolverBenchmark(state, Position{ makeTestBoardState(), /*active_player_index*/ 0 });
+}
+BENCHMARK(BM_SolverSolveTestBoard)->Unit(benchmark::kMillisecond);
+
+void BM_SolverSolveMidGame(benchmark::State& state)
+{
+    runSolverBenchmark(state, makeMidGameBoardState(static_cast<std::size_t>(state.range(0))));
+}
+BENCHMARK(BM_SolverSolveMidGame)->Arg(45)->Arg(50)->Unit(benchmark::kMillisecond);
+
+void runNegamaxSolverBenchmark(benchmark::State& state, const Position& position)
+{
+    const GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, position.active_player_index };
+
+    std::size_t num_nodes{ 0 };
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        NegamaxSolver solver{ kBenchTranspositionTableSizeBytes };
+        state.ResumeTiming();
+
+        const NegamaxResult result{ solver.solve(position.board_state, game_mechanics_executor) };
+        num_nodes += result.num_nodes;
+        benchmark::DoNotOptimize(result.value);
+    }
+
+    state.counters["nodes/s"] = benchmark::Counter(static_cast<double>(num_nodes), benchmark::Counter::kIsRate);
+}
+
+void BM_NegamaxSolveTestBoard(benchmark::State& state)
+{
+    runNegamaxSolverBenchmark(state, Position{ makeTestBoardState(), /*active_player_index*/ 0 });
+}
+BENCHMARK(BM_NegamaxSolveTestBoard)->Unit(benchmark::kMillisecond);
+
+void BM_NegamaxSolveMidGame(benchmark::State& state)
+{
+    runNegamaxSolverBenchmark(state, makeMidGameBoardState(static_cast<std::size_t>(state.range(0))));
+}
+BENCHMARK(BM_NegamaxSolveMidGame)->Arg(45)->Arg(50)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
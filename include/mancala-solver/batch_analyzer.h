@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+
+#include <negamax_solver.h>
+#include <opening_book.h>
+#include <solver.h>
+
+//! Encoding of the positions read and the results written by `BatchAnalyzer`
+//!
+//! Text input has one position per line as read by `parseTextPosition()`. Blank lines and lines starting with `#` are
+//! skipped. Each text result is a line `<index> ` followed by `formatTextResult()`, or `<index> error <message>` for a
+//! line that is not a valid position. `index` counts positions from `0` in input order, so results written out of
+//! order can be matched up again.
+//!
+//! Binary input is a record file of `PositionRecord`s and binary output a record file of `ResultRecord`s, see
+//! `RecordWriter`.
+enum class BatchFormat
+{
+    kText,
+    kBinary
+};
+
+struct BatchAnalyzerOptions
+{
+    //! Worker threads solving positions. Input is read on the calling thread.
+    std::size_t num_threads{ 1 };
+    //! Positions read ahead of the workers. Together with the per-worker tables this bounds memory use regardless of
+    //! the input size.
+    std::size_t queue_capacity{ 1024 };
+    //! Size of each worker's transposition table, which is kept across the positions that worker solves
+    std::size_t transposition_table_size_bytes{ kDefaultTranspositionTableSizeBytes };
+    //! See `TranspositionTable::TranspositionTable()`
+    bool use_huge_pages{ false };
+    //! If set, positions that are not solved within this time get the estimate of the last completed iteration
+    std::optional<std::chrono::milliseconds> time_limit_per_position{};
+    const OpeningBook* opening_book{ nullptr };
+};
+
+struct BatchSummary
+{
+    std::uint64_t num_positions{ 0 };
+    std::uint64_t num_invalid_positions{ 0 };
+    std::chrono::duration<double> elapsed{};
+};
+
+//! Streams positions from an input stream through a bounded queue to a pool of `NegamaxSolver` workers and writes each
+//! result as soon as it is solved, so results come out in completion order rather than input order
+class BatchAnalyzer
+{
+public:
+    explicit BatchAnalyzer(const BatchAnalyzerOptions& options) : options_{ options }
+    {
+    }
+
+    //! Reads `input` until it ends and returns once every position has been written to `output`. Invalid positions are
+    //! reported in the output and do not stop the run; binary input that is not a positions file or ends with a
+    //! truncated record throws `std::runtime_error`.
+    BatchSummary run(std::istream& input, std::ostream& output, const BatchFormat format) const;
+
+private:
+    BatchAnalyzerOptions options_;
+};
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <board_state.h>
+#include <move_generator.h>
+#include <negamax_solver.h>
+
+//! Kind of fixed-size record in a record file
+enum class RecordType : std::uint8_t
+{
+    kPosition = 1,
+    kResult = 2
+};
+
+//! A position: the pits and banks of both players and the player to move
+struct PositionRecord
+{
+    static constexpr RecordType kRecordType{ RecordType::kPosition };
+
+    std::uint8_t num_pits;
+    std::uint8_t active_player_index;
+    std::uint8_t banks[2];
+    std::uint8_t pits[2][kMaxNumPits];
+    std::uint8_t reserved[4];
+};
+
+static_assert(sizeof(PositionRecord) == 32);
+
+//! The solve result of the position with the same `index` in a positions file
+struct ResultRecord
+{
+    static constexpr RecordType kRecordType{ RecordType::kResult };
+
+    static constexpr std::uint8_t kNoPitIndex{ 0xff };
+
+    static constexpr std::uint8_t kProvenFlag{ 1 << 0 };
+    static constexpr std::uint8_t kInvalidPositionFlag{ 1 << 1 };
+
+    std::uint64_t index;
+    std::uint64_t num_nodes;
+    std::int16_t value;
+    //! `kNoPitIndex` if the game is finished or the position is invalid
+    std::uint8_t best_pit_index;
+    std::uint8_t flags;
+    std::uint8_t reserved[4];
+};
+
+static_assert(sizeof(ResultRecord) == 24);
+
+//! Starts every record file. Readers reject files with a different magic, version, record type or record size, so a
+//! layout change only needs a new `kRecordFormatVersion`.
+struct RecordFileHeader
+{
+    char magic[8];
+    std::uint16_t format_version;
+    RecordType record_type;
+    std::uint8_t reserved;
+    std::uint32_t record_size;
+};
+
+static_assert(sizeof(RecordFileHeader) == 16);
+
+constexpr std::uint16_t kRecordFormatVersion{ 1 };
+
+RecordFileHeader makeRecordFileHeader(const RecordType record_type, const std::size_t record_size);
+
+//! Throws `std::runtime_error` if `header` does not start a file of `record_type` records of `record_size` bytes
+void checkRecordFileHeader(const RecordFileHeader& header, const RecordType record_type, const std::size_t record_size);
+
+PositionRecord makePositionRecord(const Position& position);
+
+//! Throws `std::invalid_argument` if the record does not hold a valid position
+Position parsePositionRecord(const PositionRecord& record);
+
+ResultRecord makeResultRecord(const std::uint64_t index, const NegamaxResult& result);
+
+//! Records read or written per call to the underlying stream
+constexpr std::size_t kRecordsPerBlock{ 4096 };
+
+//! Writes a record file: the header, then the records in host byte order, buffered into blocks of `kRecordsPerBlock`
+template <typename Record>
+class RecordWriter
+{
+public:
+    explicit RecordWriter(std::ostream& output) : output_{ output }
+    {
+        const RecordFileHeader header{ makeRecordFileHeader(Record::kRecordType, sizeof(Record)) };
+        output_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        buffer_.reserve(kRecordsPerBlock);
+    }
+
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+    //! Flushes, but cannot report write errors, so call `flush()` first to see them
+    ~RecordWriter()
+    {
+        try
+        {
+            flush();
+        }
+        catch (const std::exception&)
+        {
+        }
+    }
+
+    void write(const Record& record)
+    {
+        buffer_.push_back(record);
+        if (buffer_.size() == kRecordsPerBlock)
+        {
+            flush();
+        }
+    }
+
+    //! Writes the buffered records and flushes the stream. Throws `std::runtime_error` if the stream fails.
+    void flush()
+    {
+        output_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size() * sizeof(Record)));
+        buffer_.clear();
+        output_.flush();
+        if (!output_)
+        {
+            throw std::runtime_error("Could not write records");
+        }
+    }
+
+private:
+    std::ostream& output_;
+    std::vector<Record> buffer_{};
+};
+
+//! Reads a record file written by `RecordWriter`, a block of `kRecordsPerBlock` records at a time
+template <typename Record>
+class RecordReader
+{
+public:
+    //! Throws `std::runtime_error` if the input does not start with a header for `Record`
+    explicit RecordReader(std::istream& input) : input_{ input }
+    {
+        RecordFileHeader header{};
+        input_.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (static_cast<std::size_t>(input_.gcount()) != sizeof(header))
+        {
+            throw std::runtime_error("Input ends before the record file header");
+        }
+        checkRecordFileHeader(header, Record::kRecordType, sizeof(Record));
+
+        buffer_.resize(kRecordsPerBlock);
+    }
+
+    //! Reads the next record into `record`. Returns false at the end of the input; throws `std::runtime_error` if it
+    //! ends with a truncated record.
+    bool read(Record& record)
+    {
+        if ((next_ == size_) && !readBlock())
+        {
+            return false;
+        }
+
+        record = buffer_[next_++];
+        return true;
+    }
+
+private:
+    bool readBlock()
+    {
+        input_.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size() * sizeof(Record)));
+        const std::size_t num_bytes{ static_cast<std::size_t>(input_.gcount()) };
+        if ((num_bytes % sizeof(Record)) != 0)
+        {
+            throw std::runtime_error("Input ends with a truncated record");
+        }
+
+        next_ = 0;
+        size_ = num_bytes / sizeof(Record);
+        return size_ > 0;
+    }
+
+    std::istream& input_;
+    std::vector<Record> buffer_{};
+    std::size_t next_{ 0 };
+    std::size_t size_{ 0 };
+};
@@ -1,51 +1,137 @@
 #pragma once
 
-#include <exception>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
-class SinglePlayerBoardState
+//! Maximum number of pits per player supported by the packed board representation
+constexpr std::size_t kMaxNumPits{ 12 };
+
+//! Pits and banks are stored as `uint8_t`, which bounds the total number of stones on the board
+constexpr int kMaxNumStones{ std::numeric_limits<std::uint8_t>::max() };
+
+//! Pits and bank for one player packed into a single fixed-size block, so copying a board never touches the
+//! allocator. Aligned so that each side occupies exactly one 16-byte block. A spare byte of the block keeps the running
+//! total of stones in the pits, so checking for an empty side or scoring a finished game never scans the pits.
+class alignas(16) SinglePlayerBoardState
 {
 public:
-    SinglePlayerBoardState(const std::vector<int> pits, const int bank) : pits_{ pits }, bank_{ bank }
+    //! Byte offset of the bank within the packed block, for vectorized kernels that operate on the raw bytes. Pits are
+    //! always the first `kMaxNumPits` bytes.
+    static constexpr std::size_t kBankByteOffset{ kMaxNumPits };
+    //! Byte offset of the running total of stones in the pits, which vectorized kernels must keep up to date
+    static constexpr std::size_t kNumStonesInPitsByteOffset{ kMaxNumPits + 2 };
+
+    SinglePlayerBoardState(const std::vector<int> pits, const int bank) : pits_{}, bank_{}, num_pits_{}, num_stones_in_pits_{}
     {
+        static_assert(offsetof(SinglePlayerBoardState, bank_) == kBankByteOffset);
+        static_assert(offsetof(SinglePlayerBoardState, num_stones_in_pits_) == kNumStonesInPitsByteOffset);
+
+        if (pits.empty() || (pits.size() > kMaxNumPits))
+        {
+            std::stringstream msg{};
+            msg << "Number of pits (" << pits.size() << ") must be in the range [1-" << kMaxNumPits << "]";
+
+            throw std::invalid_argument(msg.str());
+        }
+
+        for (std::size_t i = 0; i < pits.size(); ++i)
+        {
+            pits_[i] = toStoneCount(pits[i]);
+        }
+        num_stones_in_pits_ = toStoneCount(std::accumulate(pits.begin(), pits.end(), 0));
+
+        bank_ = toStoneCount(bank);
+        num_pits_ = static_cast<std::uint8_t>(pits.size());
     }
 
     void addStoneToPit(const std::size_t pit_id)
     {
-        pits_.at(pit_id)++;
+        ++pits_[checkPitId(pit_id)];
+        ++num_stones_in_pits_;
     }
 
     void clearStonesFromPit(const std::size_t pit_id)
     {
-        pits_.at(pit_id) = 0;
+        clearStonesFromPitUnchecked(checkPitId(pit_id));
     }
 
     std::size_t getNumPits() const
     {
-        return pits_.size();
+        return num_pits_;
     }
 
     int getNumStonesInPit(const std::size_t pit_id) const
     {
-        return pits_.at(pit_id);
+        return pits_[checkPitId(pit_id)];
     }
 
+    //! Constant time, the total is kept up to date by every pit mutator
     int sumOfStonesInPits() const
     {
-        int sum{ 0 };
-        for (const int num_stones : pits_)
+        return num_stones_in_pits_;
+    }
+
+    //! Unchecked pit accessors for the sowing kernels in `TurnExecutor`, which guarantee `pit_id < getNumPits()`
+    //! themselves.
+    void addStonesToPitUnchecked(const std::size_t pit_id, const int num_stones)
+    {
+        pits_[pit_id] = static_cast<std::uint8_t>(pits_[pit_id] + num_stones);
+        num_stones_in_pits_ = static_cast<std::uint8_t>(num_stones_in_pits_ + num_stones);
+    }
+
+    //! Adds `num_stones` to each pit in `[begin_pit_id, end_pit_id)`, updating the running total once
+    void addStonesToPitRangeUnchecked(const std::size_t begin_pit_id, const std::size_t end_pit_id, const int num_stones)
+    {
+        if (begin_pit_id >= end_pit_id)
+        {
+            return;
+        }
+
+        for (std::size_t i = begin_pit_id; i < end_pit_id; ++i)
+        {
+            pits_[i] = static_cast<std::uint8_t>(pits_[i] + num_stones);
+        }
+        num_stones_in_pits_ = static_cast<std::uint8_t>(num_stones_in_pits_ + (num_stones * static_cast<int>(end_pit_id - begin_pit_id)));
+    }
+
+    //! Same as `addStonesToPitRangeUnchecked()`, but loops over a compile-time number of pits with the range as a mask,
+    //! so the loop has a constant trip count and unrolls fully. `NumPits` must be `getNumPits()`.
+    template <std::size_t NumPits>
+    void addStonesToPitRangeUncheckedFor(const std::size_t begin_pit_id, const std::size_t end_pit_id, const int num_stones)
+    {
+        static_assert(NumPits <= kMaxNumPits);
+
+        for (std::size_t i = 0; i < NumPits; ++i)
         {
-            sum += num_stones;
+            const bool in_range{ (i >= begin_pit_id) && (i < end_pit_id) };
+            pits_[i] = static_cast<std::uint8_t>(pits_[i] + (in_range ? num_stones : 0));
         }
+        const int num_pits_in_range{ (begin_pit_id < end_pit_id) ? static_cast<int>(end_pit_id - begin_pit_id) : 0 };
+        num_stones_in_pits_ = static_cast<std::uint8_t>(num_stones_in_pits_ + (num_stones * num_pits_in_range));
+    }
 
-        return sum;
+    void clearStonesFromPitUnchecked(const std::size_t pit_id)
+    {
+        num_stones_in_pits_ = static_cast<std::uint8_t>(num_stones_in_pits_ - pits_[pit_id]);
+        pits_[pit_id] = 0;
+    }
+
+    int getNumStonesInPitUnchecked(const std::size_t pit_id) const
+    {
+        return pits_[pit_id];
     }
 
     void addStonesToBank(const int num_stones)
     {
-        bank_ += num_stones;
+        bank_ = static_cast<std::uint8_t>(bank_ + num_stones);
     }
 
     int getNumStonesInBank() const
@@ -56,12 +142,12 @@ public:
     std::string print() const
     {
         std::stringstream ss{};
-        for (const int stone_count : pits_)
+        for (std::size_t i = 0; i < num_pits_; ++i)
         {
-            ss << "(" << stone_count << ") ";
+            ss << "(" << static_cast<int>(pits_[i]) << ") ";
         }
 
-        ss << "[" << bank_ << "]";
+        ss << "[" << static_cast<int>(bank_) << "]";
 
         return ss.str();
     }
@@ -71,21 +157,49 @@ public:
     {
         std::stringstream ss{};
 
-        ss << "[" << bank_ << "]";
+        ss << "[" << static_cast<int>(bank_) << "]";
 
-        for (auto it = pits_.crbegin(); it != pits_.crend(); ++it)
+        for (std::size_t i = num_pits_; i > 0; --i)
         {
-            ss << " (" << *it << ")";
+            ss << " (" << static_cast<int>(pits_[i - 1]) << ")";
         }
 
         return ss.str();
     }
 
 private:
-    std::vector<int> pits_;
-    int bank_;
+    static std::uint8_t toStoneCount(const int num_stones)
+    {
+        if ((num_stones < 0) || (num_stones > kMaxNumStones))
+        {
+            std::stringstream msg{};
+            msg << "Stone count (" << num_stones << ") must be in the range [0-" << kMaxNumStones << "]";
+
+            throw std::invalid_argument(msg.str());
+        }
+
+        return static_cast<std::uint8_t>(num_stones);
+    }
+
+    std::size_t checkPitId(const std::size_t pit_id) const
+    {
+        if (pit_id >= num_pits_)
+        {
+            throw std::out_of_range("`SinglePlayerBoardState`: `pit_id` out of range");
+        }
+
+        return pit_id;
+    }
+
+    std::array<std::uint8_t, kMaxNumPits> pits_;
+    std::uint8_t bank_;
+    std::uint8_t num_pits_;
+    std::uint8_t num_stones_in_pits_;
 };
 
+static_assert(std::is_trivially_copyable_v<SinglePlayerBoardState>);
+static_assert(sizeof(SinglePlayerBoardState) == 16);
+
 class BoardState
 {
 public:
@@ -95,6 +209,7 @@ public:
                 player_0_board_state_{ std::vector<int>(num_pits, num_stones_per_pit), /*bank*/ 0 },
                 player_1_board_state_{ std::vector<int>(num_pits, num_stones_per_pit), /*bank*/ 0 }
     {
+        checkTotalNumStones();
     }
 
     BoardState(const SinglePlayerBoardState& player_0_board_state, const SinglePlayerBoardState& player_1_board_state) :
@@ -109,6 +224,8 @@ public:
 
             throw std::invalid_argument(msg.str());
         }
+
+        checkTotalNumStones();
     }
 
     std::size_t getNumPits() const
@@ -137,6 +254,20 @@ public:
         return player_1_board_state_;
     }
 
+    //! The same board with the players' sides exchanged, i.e. player 0's pits and bank become player 1's and vice versa
+    BoardState getMirrored() const
+    {
+        return BoardState{ player_1_board_state_, player_0_board_state_ };
+    }
+
+    //! Canonical form of the position with `active_player_index` to move: the board seen from the side of the player to
+    //! move, so that they are player 0. The rules treat both sides alike, so a position and its mirror with the other
+    //! player to move are the same position and share one canonical form (with player 0 to move).
+    BoardState getCanonical(const std::size_t active_player_index) const
+    {
+        return (active_player_index == 0) ? *this : getMirrored();
+    }
+
     std::string printForPlayer0() const
     {
         std::stringstream ss{};
@@ -156,6 +287,23 @@ public:
     }
 
 private:
+    void checkTotalNumStones() const
+    {
+        const int total_num_stones{ player_0_board_state_.sumOfStonesInPits() + player_0_board_state_.getNumStonesInBank() +
+                                    player_1_board_state_.sumOfStonesInPits() + player_1_board_state_.getNumStonesInBank() };
+        if (total_num_stones > kMaxNumStones)
+        {
+            std::stringstream msg{};
+            msg << "Total number of stones (" << total_num_stones << ") must not exceed " << kMaxNumStones;
+
+            throw std::invalid_argument(msg.str());
+        }
+    }
+
     SinglePlayerBoardState player_0_board_state_;
     SinglePlayerBoardState player_1_board_state_;
 };
+
+//! Both sides live in one contiguous 32-byte block, so copying a node in the solver is a plain memcpy
+static_assert(std::is_trivially_copyable_v<BoardState>);
+static_assert(sizeof(BoardState) == 2 * sizeof(SinglePlayerBoardState));
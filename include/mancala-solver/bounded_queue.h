@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+//! Multi-producer, multi-consumer FIFO holding at most `capacity` items. Producers block while it is full, so a fast
+//! producer cannot run arbitrarily far ahead of its consumers.
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(const std::size_t capacity) : capacity_{ (capacity == 0) ? 1 : capacity }
+    {
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    //! Blocks until there is room. Returns false without queueing `item` if the queue has been closed.
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock{ mutex_ };
+        not_full_condition_.wait(lock, [this]() { return closed_ || (items_.size() < capacity_); });
+        if (closed_)
+        {
+            return false;
+        }
+
+        items_.push_back(std::move(item));
+        lock.unlock();
+        not_empty_condition_.notify_one();
+
+        return true;
+    }
+
+    //! Blocks until an item is available. Returns an empty optional once the queue is closed and drained.
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> lock{ mutex_ };
+        not_empty_condition_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+        if (items_.empty())
+        {
+            return std::nullopt;
+        }
+
+        std::optional<T> item{ std::move(items_.front()) };
+        items_.pop_front();
+        lock.unlock();
+        not_full_condition_.notify_one();
+
+        return item;
+    }
+
+    //! Wakes every waiting thread. Items already queued can still be popped; further pushes fail.
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            closed_ = true;
+        }
+        not_full_condition_.notify_all();
+        not_empty_condition_.notify_all();
+    }
+
+private:
+    const std::size_t capacity_;
+
+    std::mutex mutex_{};
+    std::condition_variable not_full_condition_{};
+    std::condition_variable not_empty_condition_{};
+    std::deque<T> items_{};
+    bool closed_{ false };
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <board_state.h>
+#include <game_mechanics.h>
+
+struct DistributedSolverOptions
+{
+    //! Turns (extra turns count as turns) expanded by the coordinator. The positions reached after this many turns are
+    //! the jobs.
+    std::size_t split_ply{ 4 };
+    //! `SolverServer`s solving the jobs, each as `tcp:<ipv4_address>:<port>` or `unix:<socket_path>`
+    std::vector<std::string> worker_addresses{};
+    //! Jobs sent to each worker at a time. Each takes its own connection, since a connection is answered in order.
+    std::size_t connections_per_worker{ 1 };
+    //! If not empty, every solved job is appended to this file, and jobs already in it are not sent again
+    std::string checkpoint_path{};
+    //! A connection that fails this many times in a row is given up on
+    std::size_t max_connect_attempts{ 5 };
+    std::chrono::milliseconds retry_interval{ 1000 };
+    //! If set, a worker that has not answered a job within this long counts as a failed connection, and the job is
+    //! handed to another one. Must be longer than the slowest job. TCP connections also use keepalive, which catches
+    //! worker hosts that go away without a timeout.
+    std::optional<std::chrono::milliseconds> response_timeout{};
+};
+
+struct DistributedSolveResult
+{
+    //! Final bank differential for the player to move with perfect play by both players
+    int value{ 0 };
+    //! Not set if the game is already finished
+    std::optional<std::size_t> best_pit_index{};
+    //! Positions after `split_ply` turns, and how many distinct jobs they came down to
+    std::size_t num_frontier_positions{ 0 };
+    std::size_t num_jobs{ 0 };
+    //! Jobs answered by the checkpoint instead of a worker
+    std::size_t num_checkpointed_jobs{ 0 };
+    //! Jobs sent again after their worker connection failed
+    std::size_t num_retried_jobs{ 0 };
+};
+
+//! Solves a position too large for one machine by splitting the game tree at a fixed depth and farming the subtrees
+//! out to `SolverServer` workers (see the `serve` command), then merging their values back up with negamax.
+//!
+//! Jobs are keyed by `ZobristHasher::hashPits()`, so transpositions, mirrored positions and positions that only
+//! differ in their banks are solved once; workers answer with the final bank differential, which is stored relative to
+//! the banks. Jobs are sent with the line protocol of `SolverServer`. A job whose connection fails is handed to the
+//! next free connection, and the failed connection reconnects after `retry_interval`, so a worker that goes away only
+//! costs the jobs it was solving. A connection fails when it is closed, when TCP keepalive finds the worker host gone,
+//! or when `response_timeout` passes.
+//!
+//! The checkpoint file is a versioned header followed by one 16-byte record per solved job. It is flushed
+//! after every record, and a torn record at the end is dropped on load, so a coordinator that is killed resumes from
+//! the jobs that were done. Since jobs do not depend on the root, a checkpoint can also be reused for other roots and
+//! split depths on the same board size.
+class DistributedSolver
+{
+public:
+    //! Throws `std::invalid_argument` if there are no workers
+    explicit DistributedSolver(const DistributedSolverOptions& options);
+
+    //! Throws `std::runtime_error` if every worker connection has been given up on before all jobs were solved, or if a
+    //! worker answers with an error. Jobs solved until then are kept in the checkpoint.
+    DistributedSolveResult solve(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor) const;
+
+private:
+    //! A distinct position to be solved by a worker, with the player to move as player 0
+    struct Job
+    {
+        std::uint64_t key;
+        BoardState board_state;
+    };
+
+    //! Adds the positions after `num_plies` more turns to `jobs`, skipping finished games and keys already in `keys`
+    void collectJobs(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor, const std::size_t num_plies,
+                     std::unordered_set<std::uint64_t>& keys, std::vector<Job>& jobs,
+                     std::size_t& num_frontier_positions) const;
+
+    //! Sends `jobs` without a value in `values` to the workers and adds their values relative to the banks. Each solved
+    //! job is appended to `checkpoint` if it is given.
+    void runJobs(const std::vector<Job>& jobs, std::unordered_map<std::uint64_t, int>& values, std::ostream* checkpoint,
+                 std::size_t& num_retried_jobs) const;
+
+    //! Negamax over the first `num_plies` turns, taking the values after them from `values`. Sets `best_pit_index` at
+    //! the top if given.
+    int mergeValues(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor, const std::size_t num_plies,
+                    const std::unordered_map<std::uint64_t, int>& values, std::optional<std::size_t>* best_pit_index) const;
+
+    DistributedSolverOptions options_;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <board_state.h>
+#include <mapped_file.h>
+#include <position_indexer.h>
+
+//! Exact values of every position with at most `max_stones` stones left in the pits, for a fixed number of pits.
+//!
+//! Positions are stored in canonical form (see `BoardState::getCanonical()`): the active player's pits followed by the
+//! opposing player's pits, so both players share one table. Banks do not affect the future of a position, so each entry holds
+//! the final bank differential the player to move can still gain from this point on (i.e. relative to the current
+//! banks). Positions are indexed densely: all positions with `s` stones come after those with fewer stones and are
+//! ranked within their layer by `PositionIndexer`.
+//!
+//! On disk, the header fills the first page and the values follow page-aligned, one byte per position in index order.
+//! Loading maps the file instead of reading it, so startup cost does not depend on the size of the table and processes
+//! on the same host share one copy through the page cache.
+class EndgameTablebase
+{
+public:
+    //! Generates the table by solving layers of increasing stone count, so every capture or bank move looks up an
+    //! already solved smaller layer. Moves within a layer only carry stones forward on the active player's side, so
+    //! they cannot cycle and are resolved recursively.
+    static EndgameTablebase generate(const std::size_t num_pits, const int max_stones);
+
+    //! Maps a table written by `save()`. Throws `std::runtime_error` for missing or malformed files.
+    static EndgameTablebase load(const std::string& path);
+
+    EndgameTablebase(const EndgameTablebase&) = delete;
+    EndgameTablebase& operator=(const EndgameTablebase&) = delete;
+
+    EndgameTablebase(EndgameTablebase&&) = default;
+    EndgameTablebase& operator=(EndgameTablebase&&) = default;
+
+    void save(const std::string& path) const;
+
+    std::size_t getNumPits() const
+    {
+        return num_pits_;
+    }
+
+    int getMaxStones() const
+    {
+        return max_stones_;
+    }
+
+    //! Final bank differential for the active player with perfect play by both players, if the position is covered by
+    //! the table (same number of pits and at most `getMaxStones()` stones in the pits)
+    std::optional<int> probe(const BoardState& board_state, const std::size_t active_player_index) const;
+
+    //! Number of positions with exactly `num_stones` stones in `num_cells` pits
+    static std::uint64_t getNumPositions(const int num_stones, const std::size_t num_cells);
+
+private:
+    static constexpr std::uint32_t kFormatVersion{ 3 };
+    //! Largest supported `max_stones`, so every value fits in an `int8_t`
+    static constexpr int kMaxSupportedStones{ 127 };
+    //! Marks entries that have not been solved yet during generation
+    static constexpr std::int8_t kUnknownValue{ -128 };
+
+    using Cells = PositionIndexer::Cells;
+
+    EndgameTablebase(const std::size_t num_pits, const int max_stones);
+
+    std::uint64_t getIndex(const Cells& cells, const int num_stones) const;
+    Cells getCells(std::uint64_t index, int& num_stones) const;
+
+    int solvePosition(const std::uint64_t index);
+
+    std::size_t num_pits_;
+    int max_stones_;
+    PositionIndexer position_indexer_;
+    //! Index of the first position of each layer, indexed by number of stones
+    std::vector<std::uint64_t> layer_offsets_;
+    std::uint64_t num_entries_;
+
+    //! Backing storage for `values_`: one of these is populated, depending on whether the table was generated or loaded
+    std::vector<std::int8_t> generated_values_;
+    std::optional<MappedFile> mapped_file_;
+    const std::int8_t* values_;
+};
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <ostream>
+#include <stdexcept>
 
 #include <board_state.h>
 
@@ -41,13 +44,131 @@ struct TurnResult
 
 std::ostream& operator<<(std::ostream& os, const TurnResult& turn_result);
 
-class TurnExecutor
+//! Sentinel for `TurnExecutor::playTurnFor()` meaning the number of pits is only known at runtime
+constexpr std::size_t kDynamicNumPits{ 0 };
+
+//! Everything `TurnExecutor::unmakeMove()` needs to restore the board after a turn. Filled in by `makeMove()`.
+struct MoveUndo
+{
+    TurnResult result{ TurnResult::makeInvalidResult() };
+    std::uint8_t player_index{ 0 };
+    std::uint8_t pit_index{ 0 };
+    //! Stones that were picked up from `pit_index` and sown
+    std::uint8_t num_stones{ 0 };
+    //! Pit on the active player's side where the final stone captured, or `kNoCapture`
+    std::uint8_t capture_pit_index{ kNoCapture };
+    //! Stones taken from the opposing pit by the capture (the capturing stone itself is not included)
+    std::uint8_t num_captured_stones{ 0 };
+
+    static constexpr std::uint8_t kNoCapture{ 0xff };
+};
+
+//! Where the stones left in the pits go once a side is empty
+enum class EndOfGameSweep
+{
+    //! Each player banks the stones left on their own side
+    kToOwner,
+    //! The stones left on the side that still has some are banked by the player whose side is empty
+    kToOpponent,
+};
+
+//! Rules of Kalah, and the compile-time policy interface for `BasicTurnExecutor` and `BasicGameMechanicsExecutor`.
+//! Variants derive from `KalahRules` and redefine the rules that differ. The rules are `static constexpr`, so every
+//! ruleset gets its own kernels with the rule checks folded away.
+//!
+//! The turn and game mechanics, `BasicReferenceTurnExecutor`, `BasicMoveGenerator` and `BasicNegamaxSolver` take the
+//! policy, so a variant is solved by the same search as Kalah. `Solver`, `ProofNumberSolver`, the tablebases and the
+//! opening book are written for `KalahRules` and use the `TurnExecutor` / `GameMechanicsExecutor` aliases.
+struct KalahRules
+{
+    //! Whether a final stone in an empty pit on the mover's side is banked even if the opposing pit is empty, taking
+    //! nothing with it. Kalah only captures when there are opposing stones to take.
+    static constexpr bool kCapturesFromEmptyOpposingPit{ false };
+    //! Whether sowing drops stones into the opposing player's bank too. A turn ending there passes to the opponent.
+    //! Kalah skips it.
+    static constexpr bool kSowsIntoOpposingBank{ false };
+    static constexpr EndOfGameSweep kEndOfGameSweep{ EndOfGameSweep::kToOwner };
+    //! Player to move first when `BasicGameMechanicsExecutor` is not given a starting player
+    static constexpr std::size_t kStartingPlayerIndex{ 0 };
+};
+
+//! Every rule of `KalahRules` flipped. Not a variant anyone plays, but together the two rulesets take both sides of
+//! every rule check, so it is the ruleset `Perft::verifyRuleVariant()` and the `solve-variant` command run under.
+struct FlippedKalahRules : KalahRules
+{
+    static constexpr bool kCapturesFromEmptyOpposingPit{ true };
+    static constexpr bool kSowsIntoOpposingBank{ true };
+    static constexpr EndOfGameSweep kEndOfGameSweep{ EndOfGameSweep::kToOpponent };
+    static constexpr std::size_t kStartingPlayerIndex{ 1 };
+};
+
+//! Turn rules for `Rules` (see `KalahRules`)
+template <typename Rules>
+class BasicTurnExecutor
 {
 public:
     // Attempts to execute a turn, returning true if the turn was valid and executed. Returns false if
     // the turn was invalid.
     TurnResult playTurn(const std::size_t player_index, const std::size_t pit_index, BoardState& board_state) const
     {
+        // Dispatch once per turn to a kernel with a compile-time pit count for the common board sizes
+        switch (board_state.getNumPits())
+        {
+            case 4:
+                return playTurnFor<4>(player_index, pit_index, board_state);
+            case 6:
+                return playTurnFor<6>(player_index, pit_index, board_state);
+            default:
+                return playTurnFor<kDynamicNumPits>(player_index, pit_index, board_state);
+        }
+    }
+
+    //! Same as `playTurn()`, but records what changed in `undo` so `unmakeMove()` can revert the turn in place without
+    //! keeping a copy of the board
+    TurnResult makeMove(const std::size_t player_index, const std::size_t pit_index, BoardState& board_state, MoveUndo& undo) const
+    {
+        switch (board_state.getNumPits())
+        {
+            case 4:
+                return playTurnFor<4>(player_index, pit_index, board_state, &undo);
+            case 6:
+                return playTurnFor<6>(player_index, pit_index, board_state, &undo);
+            default:
+                return playTurnFor<kDynamicNumPits>(player_index, pit_index, board_state, &undo);
+        }
+    }
+
+    //! Reverts a valid turn made by `makeMove()`. Turns must be unmade in the reverse order they were made.
+    void unmakeMove(const MoveUndo& undo, BoardState& board_state) const
+    {
+        switch (board_state.getNumPits())
+        {
+            case 4:
+                return unmakeMoveFor<4>(undo, board_state);
+            case 6:
+                return unmakeMoveFor<6>(undo, board_state);
+            default:
+                return unmakeMoveFor<kDynamicNumPits>(undo, board_state);
+        }
+    }
+
+    //! Same as `playTurn()`, but with the number of pits fixed at compile time so that the sowing loops have constant
+    //! bounds and the opposing pit index math folds away. `NumPits` must match `board_state.getNumPits()` unless it is
+    //! `kDynamicNumPits`. If `undo` is given, it is filled in for `unmakeMoveFor()`.
+    template <std::size_t NumPits>
+    TurnResult playTurnFor(const std::size_t player_index, const std::size_t pit_index, BoardState& board_state,
+                           MoveUndo* undo = nullptr) const
+    {
+        static_assert(NumPits <= kMaxNumPits, "`NumPits` exceeds the capacity of `SinglePlayerBoardState`");
+
+        if constexpr (NumPits != kDynamicNumPits)
+        {
+            if (board_state.getNumPits() != NumPits)
+            {
+                throw std::invalid_argument("`TurnExecutor::playTurnFor()`: `NumPits` does not match `board_state`");
+            }
+        }
+
         // There is only support for two players with indices `0` and `1`
         if ((player_index != 0) && (player_index != 1))
         {
@@ -64,124 +185,185 @@ public:
         SinglePlayerBoardState& opposing_player_board_state{ (player_index == 0) ? board_state.getPlayer1BoardState()
                                                                                : board_state.getPlayer0BoardState()};
 
-        int num_stones{ active_player_board_state.getNumStonesInPit(pit_index) };
-        active_player_board_state.clearStonesFromPit(pit_index);
+        const int num_stones{ active_player_board_state.getNumStonesInPitUnchecked(pit_index) };
         if (num_stones <= 0)
         {
             return TurnResult::makeInvalidResult();
         }
+        active_player_board_state.clearStonesFromPitUnchecked(pit_index);
+
+        const std::size_t num_pits{ getNumPits<NumPits>(active_player_board_state) };
+        const std::size_t final_position{ sowStones<NumPits>(pit_index, num_stones, /*direction*/ 1, active_player_board_state,
+                                                             opposing_player_board_state) };
 
-        // Special case for the first turn since the starting pit index is nonzero
-        const std::optional<TurnResult> result{ dropStonesOnActivePlayerBoard(/*starting_pit_index*/ pit_index + 1,
-                                                    active_player_board_state, opposing_player_board_state, num_stones) };
-        if (result.has_value())
+        TurnResult result{ TurnResult::makeNotEndedInBankResult() };
+        std::uint8_t capture_pit_index{ MoveUndo::kNoCapture };
+        int num_captured_stones{ 0 };
+        if (final_position == num_pits)
         {
-            return result.value();
+            result = TurnResult::makeEndedInBankResult();
         }
-
-        while (num_stones > 0)
+        // Check if we ended in an empty pit (would now contain one stone) on the active player's board
+        else if (final_position < num_pits)
         {
-            {
-                const std::optional<TurnResult> result{
-                    dropStonesOnOpposingPlayerBoard(opposing_player_board_state, num_stones) };
-                if (result.has_value())
-                {
-                    return result.value();
-                }
-            }
+            const std::size_t final_pit_index{ final_position };
+            const std::size_t opposing_pit_index{ num_pits - final_pit_index - 1 };
+            const int num_stones_in_opposing_pit{ opposing_player_board_state.getNumStonesInPitUnchecked(opposing_pit_index) };
 
+            if ((active_player_board_state.getNumStonesInPitUnchecked(final_pit_index) == 1) &&
+                (Rules::kCapturesFromEmptyOpposingPit || (num_stones_in_opposing_pit > 0)))
             {
-                const std::optional<TurnResult> result{ dropStonesOnActivePlayerBoard(/*starting_pit_index*/ 0,
-                                                            active_player_board_state, opposing_player_board_state, num_stones) };
-                if (result.has_value())
-                {
-                    return result.value();
-                }
+                active_player_board_state.addStonesToBank(1 + num_stones_in_opposing_pit);
+                active_player_board_state.clearStonesFromPitUnchecked(final_pit_index);
+                opposing_player_board_state.clearStonesFromPitUnchecked(opposing_pit_index);
+
+                capture_pit_index = static_cast<std::uint8_t>(final_pit_index);
+                num_captured_stones = num_stones_in_opposing_pit;
             }
         }
 
-        throw std::logic_error("Error: exited subroutine with zero stones without returning successfully.");
+        if (undo != nullptr)
+        {
+            undo->result = result;
+            undo->player_index = static_cast<std::uint8_t>(player_index);
+            undo->pit_index = static_cast<std::uint8_t>(pit_index);
+            undo->num_stones = static_cast<std::uint8_t>(num_stones);
+            undo->capture_pit_index = capture_pit_index;
+            undo->num_captured_stones = static_cast<std::uint8_t>(num_captured_stones);
+        }
+
+        return result;
     }
 
-private:
-    std::optional<TurnResult> dropStonesOnActivePlayerBoard(const std::size_t starting_pit_index,
-                SinglePlayerBoardState& active_player_board_state, SinglePlayerBoardState& opposing_player_board_state, int& num_stones) const
+    //! Compile-time pit count version of `unmakeMove()`, see `playTurnFor()`
+    template <std::size_t NumPits>
+    void unmakeMoveFor(const MoveUndo& undo, BoardState& board_state) const
     {
-        std::size_t current_pit_index{ starting_pit_index };
-        while (num_stones > 0)
+        if (!undo.result.valid)
         {
-            if (current_pit_index == active_player_board_state.getNumPits())
-            {
-                active_player_board_state.addStonesToBank(/*num_stones*/ 1);
-                --num_stones;
+            return;
+        }
 
-                if (num_stones == 0)
-                {
-                    return TurnResult::makeEndedInBankResult();
-                }
+        SinglePlayerBoardState& active_player_board_state{ (undo.player_index == 0) ? board_state.getPlayer0BoardState()
+                                                                                    : board_state.getPlayer1BoardState()};
+        SinglePlayerBoardState& opposing_player_board_state{ (undo.player_index == 0) ? board_state.getPlayer1BoardState()
+                                                                                      : board_state.getPlayer0BoardState()};
 
-                // Break out of the loop since we need to switch to the other player's pits
-                break;
-            }
+        if (undo.capture_pit_index != MoveUndo::kNoCapture)
+        {
+            const std::size_t opposing_pit_index{ getNumPits<NumPits>(active_player_board_state) - undo.capture_pit_index - 1 };
+            active_player_board_state.addStonesToBank(-(1 + undo.num_captured_stones));
+            active_player_board_state.addStonesToPitUnchecked(undo.capture_pit_index, 1);
+            opposing_player_board_state.addStonesToPitUnchecked(opposing_pit_index, undo.num_captured_stones);
+        }
+
+        sowStones<NumPits>(undo.pit_index, undo.num_stones, /*direction*/ -1, active_player_board_state, opposing_player_board_state);
+        active_player_board_state.addStonesToPitUnchecked(undo.pit_index, undo.num_stones);
+    }
 
-            active_player_board_state.addStoneToPit(current_pit_index);
-            ++current_pit_index;
-            --num_stones;
+private:
+    template <std::size_t NumPits>
+    static constexpr std::size_t getNumPits(const SinglePlayerBoardState& single_player_board_state)
+    {
+        if constexpr (NumPits == kDynamicNumPits)
+        {
+            return single_player_board_state.getNumPits();
         }
+        else
+        {
+            return NumPits;
+        }
+    }
 
-        // Check if we ended in an empty pit (would now contain one stone) on the active player's board
-        if (num_stones == 0)
+    //! Drops (`direction == 1`) or takes back (`direction == -1`) the `num_stones` stones sown from `pit_index`, which
+    //! must already have been emptied. Returns the sowing position of the final stone.
+    //!
+    //! Sowing positions are numbered relative to the active player: their pits are `[0, num_pits)`, their bank is
+    //! `num_pits` and the opposing pits are `(num_pits, 2 * num_pits]`. Unless the rules sow into the opposing player's
+    //! bank (at `2 * num_pits + 1`), it is skipped, so one lap of the board covers `2 * num_pits + 1` positions.
+    template <std::size_t NumPits>
+    static std::size_t sowStones(const std::size_t pit_index, const int num_stones, const int direction,
+                                 SinglePlayerBoardState& active_player_board_state, SinglePlayerBoardState& opposing_player_board_state)
+    {
+        const std::size_t num_pits{ getNumPits<NumPits>(active_player_board_state) };
+        const std::size_t opposing_bank_position{ 2 * num_pits + 1 };
+        const std::size_t lap_length{ Rules::kSowsIntoOpposingBank ? (opposing_bank_position + 1) : opposing_bank_position };
+        const std::size_t num_laps{ static_cast<std::size_t>(num_stones) / lap_length };
+        const std::size_t num_remaining_stones{ static_cast<std::size_t>(num_stones) % lap_length };
+
+        // Every position receives one stone per full lap
+        if (num_laps > 0)
         {
-            const std::size_t final_pit_index{ current_pit_index - 1 };
-            const std::size_t opposing_pit_index{ opposing_player_board_state.getNumPits() - final_pit_index - 1 };
-            const int num_stones_in_opposing_pit{ opposing_player_board_state.getNumStonesInPit(opposing_pit_index) };
+            const int num_lap_stones{ direction * static_cast<int>(num_laps) };
+            addStonesToPits<NumPits>(/*begin_pit_index*/ 0, /*end_pit_index*/ num_pits, num_lap_stones, active_player_board_state);
+            addStonesToPits<NumPits>(/*begin_pit_index*/ 0, /*end_pit_index*/ num_pits, num_lap_stones, opposing_player_board_state);
+            active_player_board_state.addStonesToBank(num_lap_stones);
+            if constexpr (Rules::kSowsIntoOpposingBank)
+            {
+                opposing_player_board_state.addStonesToBank(num_lap_stones);
+            }
+        }
 
-            // Need to check against the previous pit because `current_pit_index` was incremented
-            if ((active_player_board_state.getNumStonesInPit(final_pit_index) == 1) &&
-                (num_stones_in_opposing_pit > 0))
+        // The final partial lap covers positions `(pit_index, final_position]` without wrapping the position index, so
+        // it can extend past the opposing pits back onto the start of the active player's pits
+        const std::size_t final_position{ pit_index + num_remaining_stones };
+        addStonesToPits<NumPits>(/*begin_pit_index*/ pit_index + 1, /*end_pit_index*/ std::min(final_position + 1, num_pits),
+                                 direction, active_player_board_state);
+        if (final_position >= num_pits)
+        {
+            active_player_board_state.addStonesToBank(direction);
+        }
+        if (final_position > num_pits)
+        {
+            addStonesToPits<NumPits>(/*begin_pit_index*/ 0, /*end_pit_index*/ std::min(final_position - num_pits, num_pits),
+                                     direction, opposing_player_board_state);
+        }
+        if constexpr (Rules::kSowsIntoOpposingBank)
+        {
+            if (final_position >= opposing_bank_position)
             {
-                active_player_board_state.addStonesToBank(1 + num_stones_in_opposing_pit);
-                active_player_board_state.clearStonesFromPit(final_pit_index);
-                opposing_player_board_state.clearStonesFromPit(opposing_pit_index);
+                opposing_player_board_state.addStonesToBank(direction);
             }
-            
-            return TurnResult::makeNotEndedInBankResult();
+        }
+        if (final_position >= lap_length)
+        {
+            addStonesToPits<NumPits>(/*begin_pit_index*/ 0, /*end_pit_index*/ final_position - lap_length + 1, direction,
+                                     active_player_board_state);
         }
 
-        return std::nullopt;
+        return final_position % lap_length;
     }
 
-    std::optional<TurnResult> dropStonesOnOpposingPlayerBoard(SinglePlayerBoardState& opposing_player_board_state, int& num_stones) const
+    //! Adds `num_stones` to each pit in `[begin_pit_index, end_pit_index)`. Does nothing for an empty range. With a
+    //! compile-time pit count the loop runs over all `NumPits` pits with the range as a mask.
+    template <std::size_t NumPits>
+    static void addStonesToPits(const std::size_t begin_pit_index, const std::size_t end_pit_index, const int num_stones,
+                                SinglePlayerBoardState& single_player_board_state)
     {
-        std::size_t current_pit_index{ 0 };
-        while (num_stones > 0)
+        if constexpr (NumPits == kDynamicNumPits)
         {
-            if (current_pit_index == opposing_player_board_state.getNumPits())
-            {
-                // Break out of the loop since we need to switch to the other player's pits
-                break;
-            }
-
-            opposing_player_board_state.addStoneToPit(current_pit_index);
-            ++current_pit_index;
-            --num_stones;
+            single_player_board_state.addStonesToPitRangeUnchecked(begin_pit_index, end_pit_index, num_stones);
         }
-
-        if (num_stones == 0)
+        else
         {
-            return TurnResult::makeNotEndedInBankResult();
+            single_player_board_state.addStonesToPitRangeUncheckedFor<NumPits>(begin_pit_index, end_pit_index, num_stones);
         }
-
-        return std::nullopt;
     }
 };
 
+using TurnExecutor = BasicTurnExecutor<KalahRules>;
+
 //! Runs the core game mechanics, storing any persistent state about which player is active.
 //! Assumes that the turn input corresponds to the active player.
-class GameMechanicsExecutor
+template <typename Rules>
+class BasicGameMechanicsExecutor
 {
 public:
-    GameMechanicsExecutor(const TurnExecutor& turn_executor, const std::size_t starting_player_index) :
+    static_assert((Rules::kStartingPlayerIndex == 0) || (Rules::kStartingPlayerIndex == 1),
+                  "`Rules::kStartingPlayerIndex` must be 0 or 1");
+
+    explicit BasicGameMechanicsExecutor(const BasicTurnExecutor<Rules>& turn_executor,
+                                        const std::size_t starting_player_index = Rules::kStartingPlayerIndex) :
                     turn_executor_{ turn_executor }, active_player_index_{ starting_player_index }
     {
         if ((active_player_index_ != 0) && (active_player_index_ != 1))
@@ -208,81 +390,129 @@ public:
         return true;
     }
 
+    //! Same as `playTurn()`, but fills in `undo` so the turn can be reverted in place with `unmakeMove()`
+    bool makeMove(const std::size_t pit_index, BoardState& board_state, MoveUndo& undo)
+    {
+        const TurnResult result{ turn_executor_.makeMove(active_player_index_, pit_index, board_state, undo) };
+        if (!result.valid)
+        {
+            return false;
+        }
+
+        if (!result.ended_in_bank)
+        {
+            active_player_index_ = (active_player_index_ + 1) % 2;
+        }
+
+        return true;
+    }
+
+    //! Reverts a valid turn made by `makeMove()`, including which player is active
+    void unmakeMove(const MoveUndo& undo, BoardState& board_state)
+    {
+        turn_executor_.unmakeMove(undo, board_state);
+        active_player_index_ = undo.player_index;
+    }
+
     std::size_t getActivePlayerIndex() const
     {
         return active_player_index_;
     }
 
+    //! Constant time: a side is empty exactly when its running total of stones in the pits is zero
     bool isGameFinished(const BoardState& board_state) const
     {
-        const SinglePlayerBoardState& player_0_board_state{ board_state.getPlayer0BoardState() };
-        if (isSinglePlayerBoardFinished(player_0_board_state))
+        return (board_state.getPlayer0BoardState().sumOfStonesInPits() == 0) ||
+               (board_state.getPlayer1BoardState().sumOfStonesInPits() == 0);
+    }
+
+    //! Only returns with a value if the game is finished. Scores the game as if `finalize()` had swept the remaining
+    //! stones into the banks, without modifying `board_state`. Returns `2` if the game ended in a tie.
+    std::optional<std::size_t> getWinnerPlayerIndex(const BoardState& board_state) const
+    {
+        if (!isGameFinished(board_state))
         {
-            return true;
+            return std::nullopt;
         }
 
-        const SinglePlayerBoardState& player_1_board_state{ board_state.getPlayer1BoardState() };
-        if (isSinglePlayerBoardFinished(player_1_board_state))
+        const int player_0_final_num_stones{ getFinalNumStonesInBank(board_state.getPlayer0BoardState(),
+                                                                     board_state.getPlayer1BoardState()) };
+        const int player_1_final_num_stones{ getFinalNumStonesInBank(board_state.getPlayer1BoardState(),
+                                                                     board_state.getPlayer0BoardState()) };
+        if (player_0_final_num_stones > player_1_final_num_stones)
         {
-            return true;
+            return 0;
         }
+        else if (player_1_final_num_stones > player_0_final_num_stones)
+        {
+            return 1;
+        }
+        else
+        {
+            return 2;
+        }
+    }
+
+    //! Final bank differential for `player_index` (their final bank minus the opposing player's) once `finalize()` has
+    //! swept the remaining stones into the banks, without modifying `board_state`
+    static int getFinalBankDifferential(const BoardState& board_state, const std::size_t player_index)
+    {
+        const SinglePlayerBoardState& player_0_board_state{ board_state.getPlayer0BoardState() };
+        const SinglePlayerBoardState& player_1_board_state{ board_state.getPlayer1BoardState() };
+        const int player_0_differential{ getFinalNumStonesInBank(player_0_board_state, player_1_board_state) -
+                                         getFinalNumStonesInBank(player_1_board_state, player_0_board_state) };
 
-        return false;
+        return (player_index == 0) ? player_0_differential : -player_0_differential;
     }
 
-    //! Only returns with a value if the game is finished. Automatically cleans up `board_state` so
-    //! that all stones end up in the banks. Returns `2` if the game ended in a tie.
-    std::optional<std::size_t> getWinnerPlayerIndex(BoardState& board_state)
+    //! Cleans up a finished game so that all stones end up in the banks. Does nothing if the game is not finished.
+    void finalize(BoardState& board_state) const
     {
         if (!isGameFinished(board_state))
         {
-            return std::nullopt;
+            return;
         }
 
         SinglePlayerBoardState& player_0_board_state{ board_state.getPlayer0BoardState() };
-        player_0_board_state.addStonesToBank(player_0_board_state.sumOfStonesInPits());
-        for (std::size_t i = 0; i < player_0_board_state.getNumPits(); ++i)
-        {
-            player_0_board_state.clearStonesFromPit(i);
-        }
-
         SinglePlayerBoardState& player_1_board_state{ board_state.getPlayer1BoardState() };
-        player_1_board_state.addStonesToBank(player_1_board_state.sumOfStonesInPits());
-        for (std::size_t i = 0; i < player_1_board_state.getNumPits(); ++i)
+        if constexpr (Rules::kEndOfGameSweep == EndOfGameSweep::kToOwner)
         {
-            player_1_board_state.clearStonesFromPit(i);
+            sweepPits(player_0_board_state, player_0_board_state);
+            sweepPits(player_1_board_state, player_1_board_state);
         }
-
-        if (player_0_board_state.getNumStonesInBank() > player_1_board_state.getNumStonesInBank())
+        else
         {
-            return 0;
+            sweepPits(player_0_board_state, player_1_board_state);
+            sweepPits(player_1_board_state, player_0_board_state);
         }
-        else if (player_1_board_state.getNumStonesInBank() > player_0_board_state.getNumStonesInBank())
+    }
+
+private:
+    static int getFinalNumStonesInBank(const SinglePlayerBoardState& single_player_board_state,
+                                       const SinglePlayerBoardState& opposing_player_board_state)
+    {
+        if constexpr (Rules::kEndOfGameSweep == EndOfGameSweep::kToOwner)
         {
-            return 1;
+            return single_player_board_state.getNumStonesInBank() + single_player_board_state.sumOfStonesInPits();
         }
         else
         {
-            return 2;
+            return single_player_board_state.getNumStonesInBank() + opposing_player_board_state.sumOfStonesInPits();
         }
     }
 
-private:
-    bool isSinglePlayerBoardFinished(const SinglePlayerBoardState& single_player_board_state) const
+    //! Moves the stones in the pits of `pits_board_state` to the bank of `bank_board_state`
+    static void sweepPits(SinglePlayerBoardState& pits_board_state, SinglePlayerBoardState& bank_board_state)
     {
-        bool pits_are_clear{ true };
-        for (std::size_t i = 0; i < single_player_board_state.getNumPits(); ++i)
+        bank_board_state.addStonesToBank(pits_board_state.sumOfStonesInPits());
+        for (std::size_t i = 0; i < pits_board_state.getNumPits(); ++i)
         {
-            if(single_player_board_state.getNumStonesInPit(i) != 0)
-            {
-                pits_are_clear = false;
-                break;
-            }
+            pits_board_state.clearStonesFromPitUnchecked(i);
         }
-
-        return pits_are_clear;
     }
 
-    TurnExecutor turn_executor_;
+    BasicTurnExecutor<Rules> turn_executor_;
     std::size_t active_player_index_;
-};
\ No newline at end of file
+};
+
+using GameMechanicsExecutor = BasicGameMechanicsExecutor<KalahRules>;
\ No newline at end of file
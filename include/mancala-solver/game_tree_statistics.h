@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <board_state.h>
+#include <game_mechanics.h>
+
+//! Finished games below a position from the perspective of the player to move there. A game is one distinct sequence
+//! of turns, so a position reached by several lines of play counts its games once per line.
+struct GameCounts
+{
+    std::uint64_t num_wins{ 0 };
+    std::uint64_t num_draws{ 0 };
+    std::uint64_t num_losses{ 0 };
+
+    //! Throws `std::overflow_error` if the total does not fit in 64 bits
+    std::uint64_t getNumGames() const;
+};
+
+struct GameTreeStatisticsResult
+{
+    //! Games after each root move from the perspective of the player to move at the root, with zero counts for
+    //! invalid moves
+    std::vector<GameCounts> game_counts_per_pit{};
+    //! Unfinished positions below the root, with mirrored positions counted once
+    std::uint64_t num_distinct_positions{ 0 };
+};
+
+//! Enough for the full tree of a 4-pit board with 4 stones per pit, at roughly 100 bytes of memory per position
+constexpr std::uint64_t kDefaultMaxNumDistinctPositions{ std::uint64_t{ 1 } << 25 };
+
+//! Exact win / draw / loss counts over the full game tree, for the statistics a pruned search cannot collect.
+//!
+//! The tree is counted as a DAG: the counts of each distinct position are computed once and memoized, and every
+//! parent adds up its children's counts, so a transposition costs one lookup however many lines reach it. Mirrored
+//! positions share counts. The memo keys on the full canonical position rather than just its hash, so the counts are
+//! exact. It holds every distinct unfinished position, so this is only practical on boards whose full tree can be
+//! enumerated anyway, and a count that needs more than `max_num_distinct_positions` of them is given up on.
+class GameTreeStatistics
+{
+public:
+    //! With more than one thread, the distinct positions a few turns below the root are counted on a work-stealing
+    //! pool sharing one memo, and the root moves are then added up from the memo. Throws `std::overflow_error` if a
+    //! count does not fit in 64 bits, or `std::runtime_error` if there are more than `max_num_distinct_positions`
+    //! positions to memoize.
+    static GameTreeStatisticsResult count(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+                                          const std::size_t num_threads = 1,
+                                          const std::uint64_t max_num_distinct_positions = kDefaultMaxNumDistinctPositions);
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+//! Read-only memory mapping of a whole file. Pages are loaded lazily by the OS and shared through the page cache with
+//! every other process mapping the same file, so opening a file costs the same regardless of its size.
+class MappedFile
+{
+public:
+    //! Throws `std::runtime_error` if the file cannot be opened or mapped
+    explicit MappedFile(const std::string& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    ~MappedFile();
+
+    const unsigned char* getData() const
+    {
+        return data_;
+    }
+
+    std::size_t getSize() const
+    {
+        return size_;
+    }
+
+    //! Hints that the mapping will be accessed in random order, so the OS does not read ahead
+    void adviseRandomAccess() const;
+
+private:
+    void unmap();
+
+    const unsigned char* data_{ nullptr };
+    std::size_t size_{ 0 };
+};
+
+//! File layouts that are memory mapped put their header in the first page so the data starts page-aligned
+constexpr std::size_t kMappedFilePageSize{ 4096 };
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <board_state.h>
+#include <game_mechanics.h>
+
+//! One legal successor of a position, as produced by `MoveGenerator`
+struct ExpandedChild
+{
+    BoardState board_state;
+    TurnResult result;
+    std::uint8_t pit_index;
+    //! Index of the parent in the input of `MoveGenerator::expandBatch()`, zero for `MoveGenerator::expand()`
+    std::size_t parent_index;
+};
+
+//! A position to expand: the board and the player to move
+struct Position
+{
+    BoardState board_state;
+    std::size_t active_player_index;
+};
+
+//! Expands every legal child of a position under `Rules` (see `KalahRules`) in one call, skipping empty pits without
+//! touching a board copy.
+//!
+//! With SSE2, each side of the board is one 16-byte register and a whole turn is sown with a handful of byte-wise
+//! compares and adds against precomputed sowing positions, so the cost per child does not depend on the number of
+//! stones or pits. Only the capture check is scalar. The sowing positions assume the opposing bank is skipped, so
+//! rules that sow into it, and builds without SSE2, fall back to `BasicTurnExecutor::playTurn()`.
+//!
+//! Like `TurnExecutor`, this only plays the turn: ending the game and sweeping the remaining stones is up to the caller.
+template <typename Rules>
+class BasicMoveGenerator
+{
+public:
+    //! Appends every legal child of `board_state` with `active_player_index` to move to `children`, in pit order, and
+    //! returns how many were appended. Reusing `children` across calls avoids allocating once it has grown.
+    std::size_t expand(const BoardState& board_state, const std::size_t active_player_index,
+                       std::vector<ExpandedChild>& children) const
+    {
+        return expandInto(board_state, active_player_index, /*parent_index*/ 0, children);
+    }
+
+    //! Appends the children of every position in `positions` to `children`, grouped by parent in input order, so a
+    //! breadth-first frontier can be expanded one layer at a time. Returns the number of children appended.
+    std::size_t expandBatch(const std::vector<Position>& positions, std::vector<ExpandedChild>& children) const
+    {
+        std::size_t num_children{ 0 };
+        for (std::size_t n = 0; n < positions.size(); ++n)
+        {
+            num_children += expandInto(positions[n].board_state, positions[n].active_player_index, n, children);
+        }
+
+        return num_children;
+    }
+
+private:
+    std::size_t expandInto(const BoardState& board_state, const std::size_t active_player_index, const std::size_t parent_index,
+                           std::vector<ExpandedChild>& children) const
+    {
+        if ((active_player_index != 0) && (active_player_index != 1))
+        {
+            return 0;
+        }
+
+#if defined(__SSE2__)
+        if constexpr (!Rules::kSowsIntoOpposingBank)
+        {
+            return expandVectorized(board_state, active_player_index, parent_index, children);
+        }
+#endif
+
+        std::size_t num_children{ 0 };
+        for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+        {
+            ExpandedChild child{ board_state, TurnResult::makeInvalidResult(), static_cast<std::uint8_t>(i), parent_index };
+            child.result = turn_executor_.playTurn(active_player_index, i, child.board_state);
+            if (child.result.valid)
+            {
+                children.push_back(child);
+                ++num_children;
+            }
+        }
+
+        return num_children;
+    }
+
+#if defined(__SSE2__)
+    //! Sowing position of every byte of a `SinglePlayerBoardState`, see `TurnExecutor`. Bytes that never receive a stone
+    //! hold `kNoPosition`, which is larger than any sowing position so it never falls inside a sown range.
+    struct SowingPositions
+    {
+        alignas(16) std::array<std::int8_t, sizeof(SinglePlayerBoardState)> active;
+        alignas(16) std::array<std::int8_t, sizeof(SinglePlayerBoardState)> active_next_lap;
+        alignas(16) std::array<std::int8_t, sizeof(SinglePlayerBoardState)> opposing;
+        alignas(16) std::array<std::int8_t, sizeof(SinglePlayerBoardState)> opposing_next_lap;
+    };
+
+    static constexpr std::int8_t kNoPosition{ 127 };
+
+    static constexpr SowingPositions makeSowingPositions(const std::size_t num_pits)
+    {
+        SowingPositions positions{};
+        const std::size_t lap_length{ 2 * num_pits + 1 };
+        for (std::size_t b = 0; b < sizeof(SinglePlayerBoardState); ++b)
+        {
+            const bool is_pit{ b < num_pits };
+            const bool is_bank{ b == SinglePlayerBoardState::kBankByteOffset };
+
+            positions.active[b] = is_pit ? static_cast<std::int8_t>(b)
+                                         : (is_bank ? static_cast<std::int8_t>(num_pits) : kNoPosition);
+            positions.active_next_lap[b] = (positions.active[b] == kNoPosition)
+                                               ? kNoPosition : static_cast<std::int8_t>(positions.active[b] + lap_length);
+            positions.opposing[b] = is_pit ? static_cast<std::int8_t>(num_pits + 1 + b) : kNoPosition;
+            positions.opposing_next_lap[b] = is_pit ? static_cast<std::int8_t>(num_pits + 1 + b + lap_length) : kNoPosition;
+        }
+
+        return positions;
+    }
+
+    static constexpr std::array<SowingPositions, kMaxNumPits + 1> makeSowingPositionsTable()
+    {
+        std::array<SowingPositions, kMaxNumPits + 1> table{};
+        for (std::size_t num_pits = 1; num_pits <= kMaxNumPits; ++num_pits)
+        {
+            table[num_pits] = makeSowingPositions(num_pits);
+        }
+
+        return table;
+    }
+
+    static const SowingPositions& getSowingPositions(const std::size_t num_pits)
+    {
+        static constexpr std::array<SowingPositions, kMaxNumPits + 1> kSowingPositionsTable{ makeSowingPositionsTable() };
+
+        return kSowingPositionsTable[num_pits];
+    }
+
+    static __m128i load(const SinglePlayerBoardState& single_player_board_state)
+    {
+        __m128i bytes;
+        std::memcpy(&bytes, &single_player_board_state, sizeof(bytes));
+
+        return bytes;
+    }
+
+    static void store(const __m128i bytes, SinglePlayerBoardState& single_player_board_state)
+    {
+        // `SinglePlayerBoardState` is trivially copyable, so its bytes can be overwritten wholesale
+        std::memcpy(static_cast<void*>(&single_player_board_state), &bytes, sizeof(bytes));
+    }
+
+    static __m128i load(const std::array<std::int8_t, sizeof(SinglePlayerBoardState)>& positions)
+    {
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(positions.data()));
+    }
+
+    //! Adds `num_stones` to the running total of stones in the pits held in `bytes`
+    static __m128i addToNumStonesInPits(const __m128i bytes, const int num_stones)
+    {
+        static_assert((SinglePlayerBoardState::kNumStonesInPitsByteOffset % 2) == 0);
+
+        // Only the low byte of the inserted 16-bit lane is non-zero, so the neighbouring byte is left untouched
+        const __m128i change{ _mm_insert_epi16(_mm_setzero_si128(), num_stones & 0xff,
+                                               SinglePlayerBoardState::kNumStonesInPitsByteOffset / 2) };
+
+        return _mm_add_epi8(bytes, change);
+    }
+
+    //! Stones each byte receives from a turn sowing `(pit_index, final_position]` plus `num_laps` full laps
+    static __m128i countSownStones(const __m128i positions, const __m128i next_lap_positions, const __m128i pit_index,
+                                   const __m128i final_position_end, const __m128i num_laps)
+    {
+        // Compare masks are all ones (-1) where true, so subtracting them adds one stone
+        const __m128i is_on_lap{ _mm_cmplt_epi8(positions, _mm_set1_epi8(kNoPosition)) };
+        const __m128i in_partial_lap{ _mm_and_si128(_mm_cmpgt_epi8(positions, pit_index),
+                                                    _mm_cmplt_epi8(positions, final_position_end)) };
+        const __m128i in_wrapped_partial_lap{ _mm_cmplt_epi8(next_lap_positions, final_position_end) };
+
+        return _mm_sub_epi8(_mm_sub_epi8(_mm_and_si128(num_laps, is_on_lap), in_partial_lap), in_wrapped_partial_lap);
+    }
+
+    std::size_t expandVectorized(const BoardState& board_state, const std::size_t active_player_index,
+                                 const std::size_t parent_index, std::vector<ExpandedChild>& children) const
+    {
+        const std::size_t num_pits{ board_state.getNumPits() };
+        const std::size_t lap_length{ 2 * num_pits + 1 };
+        const SowingPositions& sowing_positions{ getSowingPositions(num_pits) };
+
+        const SinglePlayerBoardState& active_player_board_state{ (active_player_index == 0) ? board_state.getPlayer0BoardState()
+                                                                                          : board_state.getPlayer1BoardState() };
+        const SinglePlayerBoardState& opposing_player_board_state{ (active_player_index == 0) ? board_state.getPlayer1BoardState()
+                                                                                            : board_state.getPlayer0BoardState() };
+
+        const __m128i active_bytes{ load(active_player_board_state) };
+        const __m128i opposing_bytes{ load(opposing_player_board_state) };
+        const __m128i active_positions{ load(sowing_positions.active) };
+        const __m128i active_next_lap_positions{ load(sowing_positions.active_next_lap) };
+        const __m128i opposing_positions{ load(sowing_positions.opposing) };
+        const __m128i opposing_next_lap_positions{ load(sowing_positions.opposing_next_lap) };
+
+        std::size_t num_children{ 0 };
+        for (std::size_t i = 0; i < num_pits; ++i)
+        {
+            const int num_stones{ active_player_board_state.getNumStonesInPitUnchecked(i) };
+            if (num_stones == 0)
+            {
+                continue;
+            }
+
+            const std::size_t num_laps{ static_cast<std::size_t>(num_stones) / lap_length };
+            const std::size_t final_position{ i + (static_cast<std::size_t>(num_stones) % lap_length) };
+
+            const __m128i pit_index{ _mm_set1_epi8(static_cast<char>(i)) };
+            const __m128i final_position_end{ _mm_set1_epi8(static_cast<char>(final_position + 1)) };
+            const __m128i num_laps_bytes{ _mm_set1_epi8(static_cast<char>(num_laps)) };
+
+            // The sown pit is emptied first, then receives its share of any full laps like every other pit
+            const __m128i emptied_active_bytes{ _mm_andnot_si128(_mm_cmpeq_epi8(active_positions, pit_index), active_bytes) };
+            const __m128i child_active_bytes{ _mm_add_epi8(emptied_active_bytes,
+                                                           countSownStones(active_positions, active_next_lap_positions,
+                                                                           pit_index, final_position_end, num_laps_bytes)) };
+            const __m128i child_opposing_bytes{ _mm_add_epi8(opposing_bytes,
+                                                             countSownStones(opposing_positions, opposing_next_lap_positions,
+                                                                             pit_index, final_position_end, num_laps_bytes)) };
+
+            // Every stone that left the active player's pits went to their bank or the opposing pits
+            const std::size_t num_bank_stones{ num_laps + ((final_position >= num_pits) ? 1 : 0) };
+            const std::size_t num_opposing_stones{ (num_laps * num_pits) +
+                                                   ((final_position > num_pits) ? std::min(final_position - num_pits, num_pits) : 0) };
+            const int active_total_change{ -static_cast<int>(num_bank_stones + num_opposing_stones) };
+
+            ExpandedChild child{ board_state, TurnResult::makeNotEndedInBankResult(), static_cast<std::uint8_t>(i), parent_index };
+            SinglePlayerBoardState& child_active_player_board_state{ (active_player_index == 0)
+                                                                         ? child.board_state.getPlayer0BoardState()
+                                                                         : child.board_state.getPlayer1BoardState() };
+            SinglePlayerBoardState& child_opposing_player_board_state{ (active_player_index == 0)
+                                                                           ? child.board_state.getPlayer1BoardState()
+                                                                           : child.board_state.getPlayer0BoardState() };
+            store(addToNumStonesInPits(child_active_bytes, active_total_change), child_active_player_board_state);
+            store(addToNumStonesInPits(child_opposing_bytes, static_cast<int>(num_opposing_stones)), child_opposing_player_board_state);
+
+            const std::size_t final_wrapped_position{ final_position % lap_length };
+            if (final_wrapped_position == num_pits)
+            {
+                child.result = TurnResult::makeEndedInBankResult();
+            }
+            else if (final_wrapped_position < num_pits)
+            {
+                const std::size_t opposing_pit_index{ num_pits - final_wrapped_position - 1 };
+                const int num_stones_in_opposing_pit{ child_opposing_player_board_state.getNumStonesInPitUnchecked(opposing_pit_index) };
+
+                if ((child_active_player_board_state.getNumStonesInPitUnchecked(final_wrapped_position) == 1) &&
+                    (Rules::kCapturesFromEmptyOpposingPit || (num_stones_in_opposing_pit > 0)))
+                {
+                    child_active_player_board_state.addStonesToBank(1 + num_stones_in_opposing_pit);
+                    child_active_player_board_state.clearStonesFromPitUnchecked(final_wrapped_position);
+                    child_opposing_player_board_state.clearStonesFromPitUnchecked(opposing_pit_index);
+                }
+            }
+
+            children.push_back(child);
+            ++num_children;
+        }
+
+        return num_children;
+    }
+#endif
+
+    BasicTurnExecutor<Rules> turn_executor_{};
+};
+
+using MoveGenerator = BasicMoveGenerator<KalahRules>;
@@ -0,0 +1,883 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <board_state.h>
+#include <endgame_tablebase.h>
+#include <game_mechanics.h>
+#include <opening_book.h>
+#include <search_stats.h>
+#include <solver.h>
+#include <transposition_table.h>
+#include <work_stealing_pool.h>
+#include <zobrist.h>
+
+//! Nodes closer to the root than this are split between threads in a parallel solve
+constexpr std::size_t kDefaultSplitPly{ 4 };
+
+//! Search depth meaning "to the end of the game"
+constexpr int kUnlimitedDepth{ std::numeric_limits<int>::max() };
+
+//! Bounds for an anytime solve. The search stops at whichever limit is reached first.
+struct SearchLimits
+{
+    std::optional<std::chrono::steady_clock::time_point> deadline{};
+    std::optional<std::size_t> max_nodes{};
+    int max_depth{ kUnlimitedDepth };
+};
+
+struct NegamaxResult
+{
+    //! Final bank differential (active player minus opposing player, after remaining stones are swept into the banks)
+    //! with perfect play by both players. If `proven` is false this is a heuristic estimate from a depth-limited search.
+    int value{ 0 };
+    //! Empty if the game is already finished
+    std::optional<std::size_t> best_pit_index{};
+    //! Expected line of play starting with `best_pit_index`, collected on the way back up the search. Consecutive
+    //! entries belong to the same player after an extra turn. Ends early where the rest of the line was answered by the
+    //! transposition table or the endgame tablebase.
+    std::vector<std::size_t> principal_variation{};
+    //! Depth of the last completed search iteration
+    int depth{ 0 };
+    //! True if `value` does not depend on the heuristic evaluation, i.e. the position is solved
+    bool proven{ false };
+    //! True if the search was cut short by a limit or `NegamaxSolver::cancel()`. The result then comes from the last
+    //! completed iteration, or is just the first move in move order if no iteration completed (`depth == 0`).
+    bool stopped{ false };
+    std::size_t num_nodes{ 0 };
+    //! Merged over all threads and, for iterative deepening, all iterations
+    SearchStats stats{};
+};
+
+//! Alpha-beta negamax search over the final bank differential. Values are always from the perspective of the player to
+//! move, so the sign only flips when the turn passes to the other player; extra turns keep the same perspective and
+//! the same search window.
+//!
+//! Moves are ordered by the transposition table move, killer moves, extra turns, captures and then the history
+//! heuristic. Depth-limited searches score their leaves with `evaluate()`. Subtrees that reach the end of the game
+//! before the depth limit are still proven, which lets iterative deepening stop as soon as the root is solved.
+//!
+//! With more than one thread, the root and the nodes above `split_ply` are searched young-brothers-wait style: the
+//! first child is searched by the owning thread to establish a bound, then the remaining children are pushed to a
+//! work-stealing pool and searched in parallel with the best bound known when each one starts. All threads share the
+//! lock-free transposition table and keep their own node counters and move ordering tables.
+//!
+//! The game is played under `Rules` (see `KalahRules`). Transposition table keys do not include the rules, so a table
+//! must not be shared between solvers for different rules. The endgame tablebase and the opening book hold Kalah
+//! values and are only available under `KalahRules`.
+template <typename Rules>
+class BasicNegamaxSolver
+{
+public:
+    explicit BasicNegamaxSolver(const std::size_t transposition_table_size_bytes = kDefaultTranspositionTableSizeBytes,
+                           const std::size_t num_threads = 1, const std::size_t split_ply = kDefaultSplitPly) :
+                BasicNegamaxSolver{ std::make_shared<TranspositionTable>(transposition_table_size_bytes), num_threads, split_ply }
+    {
+    }
+
+    //! Searches with `transposition_table`, which may be shared with other solvers running at the same time so each one
+    //! reuses the others' results
+    explicit BasicNegamaxSolver(std::shared_ptr<TranspositionTable> transposition_table, const std::size_t num_threads = 1,
+                           const std::size_t split_ply = kDefaultSplitPly) :
+                transposition_table_{ std::move(transposition_table) }, num_threads_{ std::max<std::size_t>(num_threads, 1) },
+                split_ply_{ split_ply }
+    {
+    }
+
+    //! Solves for the exact minimax value of the position and a pit index achieving it. Only stops early if `cancel()`
+    //! is called.
+    NegamaxResult solve(const BoardState& board_state, const BasicGameMechanicsExecutor<Rules>& game_mechanics_executor)
+    {
+        const std::optional<NegamaxResult> book_result{ probeOpeningBook(board_state, game_mechanics_executor) };
+        if (book_result.has_value())
+        {
+            return book_result.value();
+        }
+
+        transposition_table_->newSearch();
+        limits_ = SearchLimits{};
+        stop_requested_.store(false);
+        num_nodes_searched_.store(0);
+
+        NegamaxResult result{ solveToDepth(board_state, game_mechanics_executor, kUnlimitedDepth) };
+        if (result.stopped)
+        {
+            const SearchStats stats{ result.stats };
+            result = makeFallbackResult(board_state, game_mechanics_executor, result.num_nodes);
+            result.stopped = true;
+            result.stats = stats;
+        }
+
+        return result;
+    }
+
+    //! Searches with depths `1, 2, ... max_depth` until the root is proven, reusing the transposition table between
+    //! iterations for move ordering. Returns the result of the last iteration.
+    NegamaxResult solveIterativeDeepening(const BoardState& board_state,
+                                          const BasicGameMechanicsExecutor<Rules>& game_mechanics_executor, const int max_depth)
+    {
+        SearchLimits limits{};
+        limits.max_depth = max_depth;
+
+        return solveWithLimits(board_state, game_mechanics_executor, limits);
+    }
+
+    //! Anytime solve: iterative deepening until the root is proven or one of `limits` is reached, returning the result
+    //! of the last completed iteration. Always returns a best move if the game is not finished.
+    NegamaxResult solveWithLimits(const BoardState& board_state, const BasicGameMechanicsExecutor<Rules>& game_mechanics_executor,
+                                  const SearchLimits& limits)
+    {
+        const std::optional<NegamaxResult> book_result{ probeOpeningBook(board_state, game_mechanics_executor) };
+        if (book_result.has_value())
+        {
+            return book_result.value();
+        }
+
+        transposition_table_->newSearch();
+        limits_ = limits;
+        stop_requested_.store(false);
+        num_nodes_searched_.store(0);
+
+        NegamaxResult result{ makeFallbackResult(board_state, game_mechanics_executor, /*num_nodes*/ 0) };
+        std::size_t num_nodes{ 0 };
+        SearchStats stats{};
+        for (int depth = 1; (depth <= limits.max_depth) && !result.proven; ++depth)
+        {
+            NegamaxResult iteration_result{ solveToDepth(board_state, game_mechanics_executor, depth) };
+            num_nodes += iteration_result.num_nodes;
+            stats.merge(iteration_result.stats);
+            if (iteration_result.stopped)
+            {
+                result.stopped = true;
+                break;
+            }
+
+            result = iteration_result;
+        }
+
+        result.num_nodes = num_nodes;
+        result.stats = stats;
+        return result;
+    }
+
+    //! Positions covered by `endgame_tablebase` are looked up instead of searched. The tablebase must outlive the solver
+    //! or be reset with `nullptr`.
+    void setEndgameTablebase(const EndgameTablebase* endgame_tablebase)
+    {
+        static_assert(std::is_same_v<Rules, KalahRules>, "Endgame tablebases are only generated for `KalahRules`");
+        endgame_tablebase_ = endgame_tablebase;
+    }
+
+    //! Root positions found in `opening_book` are answered from the book without searching. The book must outlive the
+    //! solver or be reset with `nullptr`.
+    void setOpeningBook(const OpeningBook* opening_book)
+    {
+        static_assert(std::is_same_v<Rules, KalahRules>, "Opening books are only built for `KalahRules`");
+        opening_book_ = opening_book;
+    }
+
+    //! Stops a solve running on another thread as soon as possible. The interrupted solve returns with `stopped` set.
+    //! Has no effect on solves started afterwards.
+    void cancel()
+    {
+        stop_requested_.store(true);
+    }
+
+    //! Solves are also stopped once `*stop_flag` is set, like with `cancel()`, including solves started after it was
+    //! set. Lets an owner stop solves without racing against their start. The flag is polled every
+    //! `kLimitCheckInterval` nodes and must outlive the solver or be reset with `nullptr`.
+    void setStopFlag(const std::atomic<bool>* stop_flag)
+    {
+        stop_flag_ = stop_flag;
+    }
+
+    //! Heuristic value of a position for `player_index`: the bank differential plus the difference in stones on each
+    //! side, i.e. the final bank differential if the game ended now
+    static int evaluate(const BoardState& board_state, const std::size_t player_index)
+    {
+        return getFinalBankDifferential(board_state, player_index);
+    }
+
+    //! Final bank differential for `player_index` once the remaining stones are swept into the banks, see
+    //! `BasicGameMechanicsExecutor::getFinalBankDifferential()`
+    static int getFinalBankDifferential(const BoardState& board_state, const std::size_t player_index)
+    {
+        return BasicGameMechanicsExecutor<Rules>::getFinalBankDifferential(board_state, player_index);
+    }
+
+    //! Current bank differential for `player_index`, ignoring stones still in the pits
+    static int getBankDifferential(const BoardState& board_state, const std::size_t player_index)
+    {
+        const int player_0_differential{ board_state.getPlayer0BoardState().getNumStonesInBank() -
+                                         board_state.getPlayer1BoardState().getNumStonesInBank() };
+
+        return (player_index == 0) ? player_0_differential : -player_0_differential;
+    }
+
+private:
+    static constexpr int kMinValue{ -kMaxNumStones - 1 };
+    static constexpr int kMaxValue{ kMaxNumStones + 1 };
+
+    //! Each thread only checks the deadline and node limit this often. Must be a power of two.
+    static constexpr std::size_t kLimitCheckInterval{ 1024 };
+
+    //! Killer moves are only tracked this close to the root
+    static constexpr std::size_t kMaxKillerPly{ 128 };
+    static constexpr std::size_t kMaxPrincipalVariationLength{ 256 };
+
+    //! Best line found below a node, built up as the search returns
+    struct PrincipalVariation
+    {
+        std::array<std::uint8_t, kMaxPrincipalVariationLength> pit_indices;
+        std::size_t length{ 0 };
+
+        //! Replaces the line with `pit_index` followed by `child_principal_variation`, truncated to the capacity
+        void update(const std::size_t pit_index, const PrincipalVariation& child_principal_variation)
+        {
+            pit_indices[0] = static_cast<std::uint8_t>(pit_index);
+            length = 1 + std::min(child_principal_variation.length, kMaxPrincipalVariationLength - 1);
+            std::copy(child_principal_variation.pit_indices.begin(), child_principal_variation.pit_indices.begin() + (length - 1),
+                      pit_indices.begin() + 1);
+        }
+    };
+
+    struct SearchValue
+    {
+        int value;
+        //! False if the value depends on the heuristic evaluation anywhere in the searched subtree
+        bool proven;
+    };
+
+    //! Per-thread counters and move ordering tables, padded so threads never write to the same cache line
+    struct alignas(64) ThreadContext
+    {
+        std::size_t num_nodes{ 0 };
+        SearchStats stats{};
+        std::array<std::array<std::uint8_t, 2>, kMaxKillerPly> killer_pit_indices{};
+        std::array<std::array<std::uint32_t, kMaxNumPits>, 2> history{};
+
+        ThreadContext()
+        {
+            for (std::array<std::uint8_t, 2>& killers : killer_pit_indices)
+            {
+                killers.fill(kNoBestPitIndex);
+            }
+        }
+    };
+
+    //! Valid moves of a position, best first according to the move ordering heuristics
+    struct OrderedMoves
+    {
+        std::array<std::uint8_t, kMaxNumPits> pit_indices;
+        std::size_t num_moves{ 0 };
+    };
+
+    //! Shared state of a node whose younger children are searched in parallel
+    struct SplitPoint
+    {
+        std::mutex mutex;
+        int alpha;
+        int beta;
+        int best_value;
+        std::size_t best_pit_index;
+        bool proven;
+        PrincipalVariation principal_variation;
+        std::atomic<bool> cutoff{ false };
+        std::atomic<std::size_t> num_pending_children{ 0 };
+    };
+
+    //! Records the nodes and time spent on a root move into the searching thread's statistics when it goes out of
+    //! scope. Does nothing for other plies or with statistics compiled out.
+    class RootMoveTimer
+    {
+    public:
+        RootMoveTimer(ThreadContext& thread_context, const std::size_t pit_index, const std::size_t ply) :
+                    thread_context_{ thread_context }, pit_index_{ pit_index }, active_{ kSearchStatsEnabled && (ply == 0) },
+                    start_num_nodes_{ thread_context.num_nodes }, start_time_{}
+        {
+            if (active_)
+            {
+                start_time_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        RootMoveTimer(const RootMoveTimer&) = delete;
+        RootMoveTimer& operator=(const RootMoveTimer&) = delete;
+
+        ~RootMoveTimer()
+        {
+            if (active_)
+            {
+                thread_context_.stats.addRootMove(pit_index_, thread_context_.num_nodes - start_num_nodes_,
+                                                  std::chrono::steady_clock::now() - start_time_);
+            }
+        }
+
+    private:
+        ThreadContext& thread_context_;
+        std::size_t pit_index_;
+        bool active_;
+        std::size_t start_num_nodes_;
+        std::chrono::steady_clock::time_point start_time_;
+    };
+
+    NegamaxResult solveToDepth(const BoardState& board_state, const BasicGameMechanicsExecutor<Rules>& game_mechanics_executor,
+                               const int depth)
+    {
+        NegamaxResult result{};
+        result.depth = depth;
+
+        const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
+        if (game_mechanics_executor.isGameFinished(board_state))
+        {
+            result.value = getFinalBankDifferential(board_state, active_player_index);
+            result.proven = true;
+            return result;
+        }
+
+        thread_contexts_ = std::vector<ThreadContext>(num_threads_);
+
+        // The search makes and unmakes moves on a single board, which is back in its original state when it returns
+        BoardState search_board_state{ board_state };
+        BasicGameMechanicsExecutor<Rules> search_game_mechanics_executor{ game_mechanics_executor };
+
+        const std::chrono::steady_clock::time_point start_time{ std::chrono::steady_clock::now() };
+
+        std::optional<std::size_t> best_pit_index{};
+        PrincipalVariation principal_variation{};
+        SearchValue search_value{};
+        if (num_threads_ > 1)
+        {
+            WorkStealingPool pool{ num_threads_ };
+            pool_ = &pool;
+            search_value = search(search_board_state, search_game_mechanics_executor, kMinValue, kMaxValue, depth, /*ply*/ 0,
+                                  /*worker_index*/ 0, principal_variation, &best_pit_index);
+            pool_ = nullptr;
+        }
+        else
+        {
+            search_value = search(search_board_state, search_game_mechanics_executor, kMinValue, kMaxValue, depth, /*ply*/ 0,
+                                  /*worker_index*/ 0, principal_variation, &best_pit_index);
+        }
+
+        for (const ThreadContext& thread_context : thread_contexts_)
+        {
+            result.num_nodes += thread_context.num_nodes;
+            result.stats.merge(thread_context.stats);
+        }
+        result.stats.num_nodes = result.num_nodes;
+        result.stats.elapsed = std::chrono::steady_clock::now() - start_time;
+
+        // Values from an interrupted search are meaningless
+        if (stop_requested_.load())
+        {
+            result.stopped = true;
+            return result;
+        }
+
+        result.value = search_value.value;
+        result.proven = search_value.proven;
+        result.best_pit_index = best_pit_index;
+        result.principal_variation.assign(principal_variation.pit_indices.begin(),
+                                          principal_variation.pit_indices.begin() + principal_variation.length);
+
+        return result;
+    }
+
+    //! Proven result for a root position in the opening book, with the principal variation followed through the book for
+    //! as long as it stays in the book
+    std::optional<NegamaxResult> probeOpeningBook(const BoardState& board_state,
+                                                  const BasicGameMechanicsExecutor<Rules>& game_mechanics_executor) const
+    {
+        if (opening_book_ == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        const std::optional<OpeningBookEntry> entry{ opening_book_->probe(board_state, game_mechanics_executor.getActivePlayerIndex()) };
+        if (!entry.has_value())
+        {
+            return std::nullopt;
+        }
+
+        NegamaxResult result{};
+        result.value = entry->value;
+        result.best_pit_index = entry->best_pit_index;
+        result.depth = kUnlimitedDepth;
+        result.proven = true;
+
+        BoardState board_state_i{ board_state };
+        BasicGameMechanicsExecutor<Rules> game_mechanics_executor_i{ game_mechanics_executor };
+        std::optional<OpeningBookEntry> entry_i{ entry };
+        while (entry_i.has_value() && (result.principal_variation.size() < kMaxPrincipalVariationLength))
+        {
+            if (!game_mechanics_executor_i.playTurn(entry_i->best_pit_index, board_state_i))
+            {
+                break;
+            }
+            result.principal_variation.push_back(entry_i->best_pit_index);
+
+            if (game_mechanics_executor_i.isGameFinished(board_state_i))
+            {
+                break;
+            }
+            entry_i = opening_book_->probe(board_state_i, game_mechanics_executor_i.getActivePlayerIndex());
+        }
+
+        return result;
+    }
+
+    //! Result used when no search iteration completed: the first move in move order, unproven, at depth zero. The caller
+    //! sets `stopped` if an iteration was interrupted.
+    NegamaxResult makeFallbackResult(const BoardState& board_state, const BasicGameMechanicsExecutor<Rules>& game_mechanics_executor,
+                                     const std::size_t num_nodes) const
+    {
+        NegamaxResult result{};
+        result.num_nodes = num_nodes;
+
+        const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
+        if (game_mechanics_executor.isGameFinished(board_state))
+        {
+            result.value = getFinalBankDifferential(board_state, active_player_index);
+            result.proven = true;
+            return result;
+        }
+
+        const std::optional<TranspositionEntry> entry{ transposition_table_->probe(ZobristHasher::hashPits(board_state, active_player_index)) };
+        const OrderedMoves ordered_moves{ orderMoves(board_state, active_player_index,
+                                                     entry.has_value() ? entry->best_pit_index : kNoBestPitIndex, /*ply*/ 0,
+                                                     ThreadContext{}) };
+        result.value = evaluate(board_state, active_player_index);
+        result.best_pit_index = ordered_moves.pit_indices[0];
+        result.principal_variation = { ordered_moves.pit_indices[0] };
+
+        return result;
+    }
+
+    //! Called for every node. Counts the node and returns true if the search should unwind.
+    bool countNodeAndCheckStop(ThreadContext& thread_context)
+    {
+        ++thread_context.num_nodes;
+        if ((thread_context.num_nodes & (kLimitCheckInterval - 1)) == 0)
+        {
+            const std::size_t num_nodes_searched{ num_nodes_searched_.fetch_add(kLimitCheckInterval) + kLimitCheckInterval };
+            if ((limits_.max_nodes.has_value() && (num_nodes_searched >= limits_.max_nodes.value())) ||
+                (limits_.deadline.has_value() && (std::chrono::steady_clock::now() >= limits_.deadline.value())) ||
+                ((stop_flag_ != nullptr) && stop_flag_->load()))
+            {
+                stop_requested_.store(true);
+            }
+        }
+
+        return stop_requested_.load(std::memory_order_relaxed);
+    }
+
+    //! Sorts the valid moves of the active player: transposition table move, killers, extra turns, captures (largest
+    //! first) and then by history score
+    OrderedMoves orderMoves(const BoardState& board_state, const std::size_t active_player_index, const std::size_t table_pit_index,
+                            const std::size_t ply, const ThreadContext& thread_context) const
+    {
+        const SinglePlayerBoardState& active_player_board_state{ (active_player_index == 0) ? board_state.getPlayer0BoardState()
+                                                                                          : board_state.getPlayer1BoardState() };
+        const SinglePlayerBoardState& opposing_player_board_state{ (active_player_index == 0) ? board_state.getPlayer1BoardState()
+                                                                                            : board_state.getPlayer0BoardState() };
+        const std::size_t num_pits{ board_state.getNumPits() };
+        const std::size_t lap_length{ Rules::kSowsIntoOpposingBank ? (2 * num_pits + 2) : (2 * num_pits + 1) };
+
+        std::array<std::uint8_t, 2> killers{ kNoBestPitIndex, kNoBestPitIndex };
+        if (ply < kMaxKillerPly)
+        {
+            killers = thread_context.killer_pit_indices[ply];
+        }
+
+        OrderedMoves ordered_moves{};
+        std::array<std::uint64_t, kMaxNumPits> scores{};
+        for (std::size_t i = 0; i < num_pits; ++i)
+        {
+            const std::size_t num_stones{ static_cast<std::size_t>(active_player_board_state.getNumStonesInPitUnchecked(i)) };
+            if (num_stones == 0)
+            {
+                continue;
+            }
+
+            std::uint64_t score{ thread_context.history[active_player_index][i] };
+            const std::size_t final_position{ (i + num_stones) % lap_length };
+            if (i == table_pit_index)
+            {
+                score |= std::uint64_t{ 1 } << 60;
+            }
+            else if (i == killers[0])
+            {
+                score |= std::uint64_t{ 1 } << 59;
+            }
+            else if (i == killers[1])
+            {
+                score |= std::uint64_t{ 1 } << 58;
+            }
+            else if (final_position == num_pits)
+            {
+                score |= std::uint64_t{ 1 } << 57;
+            }
+            else if (final_position < num_pits)
+            {
+                // The final pit ends up with exactly one stone only if it was empty and is reached before a full lap,
+                // or if it is the emptied starting pit after exactly one lap
+                const bool lands_in_empty_pit{ (num_stones < lap_length) ?
+                    (active_player_board_state.getNumStonesInPitUnchecked(final_position) == 0) : (num_stones == lap_length) };
+                const std::size_t num_laps{ num_stones / lap_length };
+                const int num_captured_stones{
+                    opposing_player_board_state.getNumStonesInPitUnchecked(num_pits - final_position - 1) + static_cast<int>(num_laps) };
+                if (lands_in_empty_pit && (Rules::kCapturesFromEmptyOpposingPit || (num_captured_stones > 0)))
+                {
+                    score |= (std::uint64_t{ 1 } << 56) | (static_cast<std::uint64_t>(num_captured_stones) << 40);
+                }
+            }
+
+            // Insertion sort, descending by score
+            std::size_t n{ ordered_moves.num_moves };
+            while ((n > 0) && (scores[n - 1] < score))
+            {
+                scores[n] = scores[n - 1];
+                ordered_moves.pit_indices[n] = ordered_moves.pit_indices[n - 1];
+                --n;
+            }
+            scores[n] = score;
+            ordered_moves.pit_indices[n] = static_cast<std::uint8_t>(i);
+            ++ordered_moves.num_moves;
+        }
+
+        return ordered_moves;
+    }
+
+    static void recordCutoff(const std::size_t active_player_index, const std::size_t pit_index, const int depth,
+                             const std::size_t ply, ThreadContext& thread_context)
+    {
+        if ((ply < kMaxKillerPly) && (thread_context.killer_pit_indices[ply][0] != pit_index))
+        {
+            thread_context.killer_pit_indices[ply][1] = thread_context.killer_pit_indices[ply][0];
+            thread_context.killer_pit_indices[ply][0] = static_cast<std::uint8_t>(pit_index);
+        }
+
+        const std::uint32_t bonus{ static_cast<std::uint32_t>(std::min(depth, 64)) };
+        std::uint32_t& history{ thread_context.history[active_player_index][pit_index] };
+        history = std::min<std::uint32_t>(history + (bonus * bonus), std::uint32_t{ 1 } << 30);
+    }
+
+    //! Fail-soft alpha-beta on a position where the game is not finished. Transposition table entries are keyed on the
+    //! pits only and store values relative to the current bank differential, so transpositions reached with different
+    //! banks share an entry. Children are searched by making and unmaking moves on `board_state` and
+    //! `game_mechanics_executor`, which are restored before returning.
+    //!
+    //! `principal_variation` is set to the line through the child that last raised `alpha`, which is the best line if
+    //! the value is exact. It stops early where the subtree was answered by the table, the tablebase or the depth
+    //! limit.
+    SearchValue search(BoardState& board_state, BasicGameMechanicsExecutor<Rules>& game_mechanics_executor, int alpha, int beta,
+                       const int depth, const std::size_t ply, const std::size_t worker_index,
+                       PrincipalVariation& principal_variation, std::optional<std::size_t>* best_pit_index_out = nullptr)
+    {
+        principal_variation.length = 0;
+        ThreadContext& thread_context{ thread_contexts_[worker_index] };
+        if (countNodeAndCheckStop(thread_context))
+        {
+            return SearchValue{ 0, /*proven*/ false };
+        }
+
+        const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
+
+        // The root needs a best move, so it is always searched
+        if ((endgame_tablebase_ != nullptr) && (best_pit_index_out == nullptr))
+        {
+            const std::optional<int> value{ endgame_tablebase_->probe(board_state, active_player_index) };
+            if (value.has_value())
+            {
+                return SearchValue{ value.value(), /*proven*/ true };
+            }
+        }
+
+        if (depth <= 0)
+        {
+            return SearchValue{ evaluate(board_state, active_player_index), /*proven*/ false };
+        }
+
+        const int bank_differential{ getBankDifferential(board_state, active_player_index) };
+        const std::uint64_t key{ ZobristHasher::hashPits(board_state, active_player_index) };
+        const std::uint8_t draft{ static_cast<std::uint8_t>(std::min(depth, kFullDraft - 1)) };
+
+        bool proven{ true };
+        std::size_t table_pit_index{ kNoBestPitIndex };
+        ProbeOutcome probe_outcome{ ProbeOutcome::kMiss };
+        const std::optional<TranspositionEntry> entry{ transposition_table_->probe(key, &probe_outcome) };
+        thread_context.stats.countTranspositionProbe(probe_outcome);
+        if (entry.has_value())
+        {
+            const bool entry_proven{ entry->draft == kFullDraft };
+            const int value{ entry->value + bank_differential };
+
+            // The root needs a best move, so it never returns straight from the table
+            if ((best_pit_index_out == nullptr) && (entry_proven || (entry->draft >= depth)))
+            {
+                if (entry->bound == Bound::kExact)
+                {
+                    return SearchValue{ value, entry_proven };
+                }
+                if (entry->bound == Bound::kLower)
+                {
+                    alpha = std::max(alpha, value);
+                }
+                else if (entry->bound == Bound::kUpper)
+                {
+                    beta = std::min(beta, value);
+                }
+                proven = entry_proven;
+                if (alpha >= beta)
+                {
+                    return SearchValue{ value, entry_proven };
+                }
+            }
+
+            table_pit_index = entry->best_pit_index;
+        }
+
+        // Bounds are classified against the window actually searched, after any narrowing from the table
+        const int searched_alpha{ alpha };
+        int best_value{ kMinValue };
+        std::size_t best_pit_index{ kNoBestPitIndex };
+
+        const OrderedMoves ordered_moves{ orderMoves(board_state, active_player_index, table_pit_index, ply, thread_context) };
+
+        // When splitting, only the eldest child is searched here and the rest are handed to the pool
+        const bool split{ (pool_ != nullptr) && (ply < split_ply_) };
+
+        std::size_t n{ 0 };
+        for (; n < ordered_moves.num_moves; ++n)
+        {
+            const std::size_t i{ ordered_moves.pit_indices[n] };
+
+            SearchValue child_value{};
+            // Left default-initialized, so the line is not cleared for every node, only its length
+            PrincipalVariation child_principal_variation;
+            {
+                const RootMoveTimer root_move_timer{ thread_context, i, ply };
+
+                MoveUndo undo{};
+                game_mechanics_executor.makeMove(i, board_state, undo);
+                child_value = searchChild(board_state, game_mechanics_executor, active_player_index, alpha, beta, depth, ply,
+                                          worker_index, child_principal_variation);
+                game_mechanics_executor.unmakeMove(undo, board_state);
+            }
+
+            if (stop_requested_.load(std::memory_order_relaxed))
+            {
+                return SearchValue{ 0, /*proven*/ false };
+            }
+
+            proven = proven && child_value.proven;
+            if (child_value.value > best_value)
+            {
+                best_value = child_value.value;
+                best_pit_index = i;
+            }
+
+            if (child_value.value > alpha)
+            {
+                alpha = child_value.value;
+                principal_variation.update(i, child_principal_variation);
+            }
+            if (alpha >= beta)
+            {
+                recordCutoff(active_player_index, i, depth, ply, thread_context);
+                thread_context.stats.countCutoff(n);
+                break;
+            }
+
+            if (split)
+            {
+                ++n;
+                break;
+            }
+        }
+
+        // Every child up to and including a cutoff, or all of them once the remaining ones go to the pool
+        std::size_t num_children{ std::min(n + 1, ordered_moves.num_moves) };
+
+        if (split && (alpha < beta) && (n < ordered_moves.num_moves))
+        {
+            num_children = ordered_moves.num_moves;
+
+            SplitPoint split_point{};
+            split_point.alpha = alpha;
+            split_point.beta = beta;
+            split_point.best_value = best_value;
+            split_point.best_pit_index = best_pit_index;
+            split_point.proven = proven;
+            split_point.principal_variation = principal_variation;
+
+            searchSplitPoint(board_state, game_mechanics_executor, ordered_moves, n, depth, ply, worker_index, split_point);
+            if (stop_requested_.load(std::memory_order_relaxed))
+            {
+                return SearchValue{ 0, /*proven*/ false };
+            }
+
+            best_value = split_point.best_value;
+            best_pit_index = split_point.best_pit_index;
+            proven = split_point.proven;
+            principal_variation = split_point.principal_variation;
+            if (split_point.cutoff.load())
+            {
+                recordCutoff(active_player_index, best_pit_index, depth, ply, thread_context);
+                thread_context.stats.countCutoff(static_cast<std::size_t>(
+                    std::find(ordered_moves.pit_indices.begin(), ordered_moves.pit_indices.begin() + ordered_moves.num_moves,
+                              best_pit_index) - ordered_moves.pit_indices.begin()));
+            }
+        }
+        thread_context.stats.countInteriorNode(ply, num_children);
+
+        Bound bound{ Bound::kExact };
+        if (best_value <= searched_alpha)
+        {
+            bound = Bound::kUpper;
+        }
+        else if (best_value >= beta)
+        {
+            bound = Bound::kLower;
+        }
+
+        const int num_stones_in_pits{ board_state.getPlayer0BoardState().sumOfStonesInPits() +
+                                      board_state.getPlayer1BoardState().sumOfStonesInPits() };
+        transposition_table_->store(key, best_value - bank_differential, bound, static_cast<std::uint8_t>(best_pit_index),
+                                   static_cast<std::uint8_t>(num_stones_in_pits), proven ? kFullDraft : draft);
+
+        if (best_pit_index_out != nullptr)
+        {
+            *best_pit_index_out = best_pit_index;
+        }
+
+        return SearchValue{ best_value, proven };
+    }
+
+    //! Value of a child position from the perspective of `active_player_index`, who just moved into it
+    SearchValue searchChild(BoardState& board_state, BasicGameMechanicsExecutor<Rules>& game_mechanics_executor,
+                            const std::size_t active_player_index, const int alpha, const int beta, const int depth,
+                            const std::size_t ply, const std::size_t worker_index, PrincipalVariation& principal_variation)
+    {
+        if (game_mechanics_executor.isGameFinished(board_state))
+        {
+            principal_variation.length = 0;
+            return SearchValue{ getFinalBankDifferential(board_state, active_player_index), /*proven*/ true };
+        }
+
+        // `kUnlimitedDepth` never runs out
+        const int child_depth{ (depth == kUnlimitedDepth) ? depth : depth - 1 };
+        if (game_mechanics_executor.getActivePlayerIndex() == active_player_index)
+        {
+            // Extra turn: same player, same perspective
+            return search(board_state, game_mechanics_executor, alpha, beta, child_depth, ply + 1, worker_index, principal_variation);
+        }
+
+        const SearchValue child_value{
+            search(board_state, game_mechanics_executor, -beta, -alpha, child_depth, ply + 1, worker_index, principal_variation) };
+        return SearchValue{ -child_value.value, child_value.proven };
+    }
+
+    //! Searches the moves from the `first_n`-th in `ordered_moves` onward in parallel, then waits for all of them while
+    //! helping with any pending work. Each task searches its own copy of the child position, since the owner's board keeps
+    //! changing while the task is queued.
+    void searchSplitPoint(const BoardState& board_state, const BasicGameMechanicsExecutor<Rules>& game_mechanics_executor,
+                          const OrderedMoves& ordered_moves, const std::size_t first_n, const int depth, const std::size_t ply,
+                          const std::size_t worker_index, SplitPoint& split_point)
+    {
+        const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
+
+        for (std::size_t n = first_n; n < ordered_moves.num_moves; ++n)
+        {
+            const std::size_t i{ ordered_moves.pit_indices[n] };
+
+            BoardState board_state_i{ board_state };
+            BasicGameMechanicsExecutor<Rules> game_mechanics_executor_i{ game_mechanics_executor };
+            game_mechanics_executor_i.playTurn(i, board_state_i);
+
+            split_point.num_pending_children.fetch_add(1);
+            pool_->push(worker_index, [this, &split_point, board_state_i, game_mechanics_executor_i, active_player_index, i,
+                                       depth, ply](const std::size_t task_worker_index) mutable
+            {
+                if (!split_point.cutoff.load() && !stop_requested_.load(std::memory_order_relaxed))
+                {
+                    int alpha{ 0 };
+                    {
+                        std::lock_guard<std::mutex> lock{ split_point.mutex };
+                        alpha = split_point.alpha;
+                    }
+
+                    SearchValue child_value{};
+                    PrincipalVariation child_principal_variation;
+                    {
+                        const RootMoveTimer root_move_timer{ thread_contexts_[task_worker_index], i, ply };
+                        child_value = searchChild(board_state_i, game_mechanics_executor_i, active_player_index, alpha,
+                                                  split_point.beta, depth, ply, task_worker_index, child_principal_variation);
+                    }
+
+                    std::lock_guard<std::mutex> lock{ split_point.mutex };
+                    split_point.proven = split_point.proven && child_value.proven;
+                    if (child_value.value > split_point.best_value)
+                    {
+                        split_point.best_value = child_value.value;
+                        split_point.best_pit_index = i;
+                    }
+
+                    if (child_value.value > split_point.alpha)
+                    {
+                        split_point.alpha = child_value.value;
+                        split_point.principal_variation.update(i, child_principal_variation);
+                    }
+                    if (split_point.alpha >= split_point.beta)
+                    {
+                        split_point.cutoff.store(true);
+                    }
+                }
+
+                // Must be the last access, the owner may destroy `split_point` as soon as this reaches zero
+                split_point.num_pending_children.fetch_sub(1);
+            });
+        }
+
+        while (split_point.num_pending_children.load() > 0)
+        {
+            if (!pool_->runPendingTask(worker_index))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    std::shared_ptr<TranspositionTable> transposition_table_;
+    std::size_t num_threads_;
+    std::size_t split_ply_;
+
+    const EndgameTablebase* endgame_tablebase_{ nullptr };
+    const OpeningBook* opening_book_{ nullptr };
+    const std::atomic<bool>* stop_flag_{ nullptr };
+
+    std::vector<ThreadContext> thread_contexts_;
+
+    SearchLimits limits_{};
+    std::atomic<bool> stop_requested_{ false };
+    //! Approximate total over all threads, only updated every `kLimitCheckInterval` nodes per thread
+    std::atomic<std::size_t> num_nodes_searched_{ 0 };
+    //! Only set during a parallel solve
+    WorkStealingPool* pool_{ nullptr };
+};
+
+using NegamaxSolver = BasicNegamaxSolver<KalahRules>;
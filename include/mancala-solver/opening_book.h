@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <board_state.h>
+#include <game_mechanics.h>
+#include <mapped_file.h>
+
+//! Book answer for a position
+struct OpeningBookEntry
+{
+    std::size_t best_pit_index;
+    //! Final bank differential for the player to move with perfect play by both players
+    int value;
+};
+
+//! Exact solutions of every position reachable within the first few turns of a game, built offline so the most common
+//! queries become a lookup.
+//!
+//! Entries are keyed by `ZobristHasher::hashPits()` and store values relative to the current banks, like the
+//! transposition table, so transpositions reached with different banks share an entry, and so do mirrored positions. On disk, the header fills the
+//! first page and the entries follow sorted by key, so a loaded book is probed by binary search straight from the
+//! mapping.
+class OpeningBook
+{
+public:
+    //! Solves every position reachable from `board_state` in at most `num_plies` turns (extra turns count as turns)
+    //! with `NegamaxSolver` using `num_threads` threads. Deeper positions are solved first so the shallower ones reuse
+    //! their transposition table entries.
+    static OpeningBook build(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+                             const std::size_t num_plies, const std::size_t num_threads,
+                             const std::size_t transposition_table_size_bytes);
+
+    //! Maps a book written by `save()`. Throws `std::runtime_error` for missing or malformed files.
+    static OpeningBook load(const std::string& path);
+
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    OpeningBook(OpeningBook&&) = default;
+    OpeningBook& operator=(OpeningBook&&) = default;
+
+    void save(const std::string& path) const;
+
+    std::size_t getNumPits() const
+    {
+        return num_pits_;
+    }
+
+    std::size_t getNumEntries() const
+    {
+        return num_entries_;
+    }
+
+    std::optional<OpeningBookEntry> probe(const BoardState& board_state, const std::size_t active_player_index) const;
+
+private:
+    static constexpr std::uint32_t kFormatVersion{ 2 };
+
+    //! On-disk entry, 16 bytes so entries never straddle a page
+    struct Record
+    {
+        std::uint64_t key;
+        //! Relative to the bank differential of the player to move
+        std::int16_t value;
+        std::uint8_t best_pit_index;
+        std::uint8_t reserved[5];
+    };
+
+    static_assert(sizeof(Record) == 16);
+
+    explicit OpeningBook(const std::size_t num_pits);
+
+    std::size_t num_pits_;
+    std::size_t num_entries_;
+
+    //! Backing storage for `records_`: one of these is populated, depending on whether the book was built or loaded
+    std::vector<Record> built_records_;
+    std::optional<MappedFile> mapped_file_;
+    const Record* records_;
+};
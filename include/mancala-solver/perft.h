@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <board_state.h>
+#include <game_mechanics.h>
+
+//! Position counts from a perft run, indexed by depth from `0` (the root) up to the requested depth. A depth is one
+//! turn, so an extra turn counts as a new depth. Finished games are counted at the depth where they end and are not
+//! expanded further.
+struct PerftResult
+{
+    std::vector<std::uint64_t> num_positions{};
+    //! Distinct (board, player to move) pairs, told apart by their full `ZobristHasher::hash()`. Empty unless counted.
+    std::vector<std::uint64_t> num_unique_positions{};
+    //! Positions where the game is over. Empty unless counted.
+    std::vector<std::uint64_t> num_finished_games{};
+};
+
+//! Enumerates every line of play from a position, as a throughput benchmark for move generation and a correctness
+//! check for the sowing kernels
+class Perft
+{
+public:
+    //! Visits every position up to `depth` with `GameMechanicsExecutor::makeMove()`, counting all, unique and finished
+    //! positions per depth. Counting unique positions keeps one hash per distinct position in memory.
+    static PerftResult run(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+                           const std::size_t depth, const bool count_unique_positions = true);
+
+    //! Counts positions per depth only. Positions one turn above `depth` count their legal moves without playing
+    //! them, so the leaves are never materialized. With more than one thread, the tree is expanded breadth-first until
+    //! there is enough work to share and the subtrees are counted on a work-stealing pool.
+    static PerftResult runBulk(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+                               const std::size_t depth, const std::size_t num_threads = 1);
+
+    //! Same as `run()` without unique positions, but plays every move with `TurnExecutor::playTurn()`,
+    //! `TurnExecutor::makeMove()` / `unmakeMove()`, `MoveGenerator` and `ReferenceTurnExecutor` and throws
+    //! `std::runtime_error` describing the first position where they disagree.
+    static PerftResult verify(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+                              const std::size_t depth);
+
+    //! Same as `verify()` under `FlippedKalahRules`, from its starting player, so the rule policy is checked on both
+    //! sides of every rule. The tree is then checked again under Kalah with only the capture rule flipped, which
+    //! `MoveGenerator` plays with its vectorized kernel. Returns the counts under `FlippedKalahRules`. Both also check
+    //! that scoring a finished game agrees with `GameMechanicsExecutor::finalize()`.
+    static PerftResult verifyRuleVariant(const BoardState& board_state, const std::size_t depth);
+
+    //! Solves `board_state` and each position after a root move under `FlippedKalahRules` with `BasicNegamaxSolver`,
+    //! and by brute force minimax over `BasicReferenceTurnExecutor`, and returns the value at the root. Throws
+    //! `std::runtime_error` if they disagree, or if the solver's best move does not achieve the root value. The brute
+    //! force visits the whole game tree, so this is only feasible for small boards.
+    static int verifyRuleVariantSolve(const BoardState& board_state, const std::size_t transposition_table_size_bytes);
+};
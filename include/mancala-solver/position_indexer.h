@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <board_state.h>
+#include <move_generator.h>
+
+//! Dense, perfect ranking of positions, so that tables over positions can be flat arrays indexed by rank instead of
+//! hash tables.
+//!
+//! The pits are ranked as a distribution of stones over `2 * num_pits` cells through the combinatorial number system.
+//! Written as stars and bars, a distribution is the set of bar positions `b_j = c_0 + ... + c_j + j` for all but the last
+//! cell, and its rank is the colexicographic rank of that set, `sum(C(b_j, j + 1))`. The distributions of `s` stones
+//! take exactly the ranks `[0, getNumDistributions(s))`.
+//!
+//! Whole positions with a fixed total number of stones add the split of the remaining stones between the banks and the
+//! player to move. They are grouped by the number of stones in the pits, and within a group the index is
+//! `(pits rank * number of bank splits + player 0's bank) * 2 + active player`.
+class PositionIndexer
+{
+public:
+    //! Player 0's pits followed by player 1's, see `getCells()`
+    using Cells = std::array<std::uint8_t, 2 * kMaxNumPits>;
+
+    //! Ranks distributions of up to `max_stones` stones over the pits of a board with `num_pits` pits per side, and
+    //! indexes whole positions with exactly `max_stones` stones in the pits and banks. Throws `std::invalid_argument` for
+    //! unsupported dimensions and `std::overflow_error` if the distributions of `max_stones` stones cannot be counted in
+    //! 64 bits.
+    PositionIndexer(const std::size_t num_pits, const int max_stones);
+
+    std::size_t getNumPits() const
+    {
+        return num_pits_;
+    }
+
+    int getMaxStones() const
+    {
+        return max_stones_;
+    }
+
+    //! Ways to distribute `num_stones` stones over `num_cells` cells, i.e. `C(num_stones + num_cells - 1, num_cells - 1)`.
+    //! Throws `std::overflow_error` if the result does not fit in 64 bits.
+    static std::uint64_t countDistributions(const int num_stones, const std::size_t num_cells);
+
+    //! Distributions of `num_stones` stones, at most `getMaxStones()`, over this board's pits. Zero for negative
+    //! `num_stones`.
+    std::uint64_t getNumDistributions(const int num_stones) const
+    {
+        return (num_stones < 0) ? 0 : getBinomial(num_stones + num_cells_ - 1, num_cells_ - 1);
+    }
+
+    //! Rank of `cells` among the distributions of the same number of stones
+    std::uint64_t rankCells(const Cells& cells) const
+    {
+        std::uint64_t rank{ 0 };
+        std::size_t bar{ 0 };
+        for (std::size_t j = 0; (j + 1) < num_cells_; ++j)
+        {
+            bar += cells[j];
+            rank += getBinomial(bar + j, j + 1);
+        }
+
+        return rank;
+    }
+
+    Cells unrankCells(std::uint64_t rank, const int num_stones) const;
+
+    //! Player 0's pits followed by player 1's. Use `BoardState::getCanonical()` for the mover's pits first.
+    static Cells getCells(const BoardState& board_state);
+
+    //! Number of whole positions with `getMaxStones()` stones. Throws `std::overflow_error` if they cannot be counted in
+    //! 64 bits.
+    std::uint64_t getNumPositions() const;
+
+    //! Index of a whole position in `[0, getNumPositions())`. Throws `std::invalid_argument` if the board does not have
+    //! `getNumPits()` pits and `getMaxStones()` stones.
+    std::uint64_t getIndex(const BoardState& board_state, const std::size_t active_player_index) const;
+
+    Position getPosition(const std::uint64_t index) const;
+
+private:
+    std::uint64_t getBinomial(const std::size_t n, const std::size_t k) const
+    {
+        return binomials_[n * num_cells_ + k];
+    }
+
+    std::uint64_t getNumBankSplits(const int num_stones_in_pits) const
+    {
+        return static_cast<std::uint64_t>(max_stones_ - num_stones_in_pits) + 1;
+    }
+
+    void checkPositionsCountable() const;
+
+    std::size_t num_pits_;
+    std::size_t num_cells_;
+    int max_stones_;
+    //! `C(n, k)` at `[n * num_cells_ + k]` for `n < max_stones_ + num_cells_` and `k < num_cells_`, saturating at the
+    //! largest `std::uint64_t`
+    std::vector<std::uint64_t> binomials_{};
+    //! Index of the first whole position with each number of stones in the pits
+    std::vector<std::uint64_t> position_offsets_{};
+    bool positions_overflow_{ false };
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+#include <move_generator.h>
+#include <negamax_solver.h>
+
+//! Parses a position written as the player to move, then player 0's pits and bank, then player 1's pits and bank,
+//! separated by whitespace (e.g. `0 4 4 4 4 4 4 0 4 4 4 4 4 4 0`). The number of pits follows from the number of
+//! values. Throws `std::invalid_argument` describing the problem if `text` is not a valid position.
+Position parseTextPosition(const std::string& text);
+
+//! Formats a position the way `parseTextPosition()` reads it
+std::string formatTextPosition(const Position& position);
+
+//! Formats a result as `<best_pit_index> <value> <proven>`, with `-` as the pit of a finished game
+std::string formatTextResult(const NegamaxResult& result);
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include <board_state.h>
+#include <game_mechanics.h>
+#include <move_generator.h>
+
+//! Standard opening position: six pits per player with four stones each
+inline BoardState makeDefaultBoardState()
+{
+    return BoardState{ /*player_0_board_state*/ SinglePlayerBoardState{ std::vector<int>{ 4, 4, 4, 4, 4, 4 }, 0 },
+                       /*player_1_board_state*/ SinglePlayerBoardState{ std::vector<int>{ 4, 4, 4, 4, 4, 4 }, 0 }};
+}
+
+//! Small endgame that both solvers finish in milliseconds, with player 0 to move
+inline BoardState makeTestBoardState()
+{
+    return BoardState{ /*player_0_board_state*/ SinglePlayerBoardState{ std::vector<int>{ 0, 0, 3, 2, 1, 1 }, 0 },
+                       /*player_1_board_state*/ SinglePlayerBoardState{ std::vector<int>{ 7, 0, 0, 0, 2, 1 }, 0 }};
+}
+
+//! Position and player to move reached from `makeDefaultBoardState()` (player 0 first) after `num_turns` turns of a fixed line of
+//! play. Each turn plays the first non-empty pit at or after `(turn * 5 + 2) % num_pits`, so the sequence is the same
+//! on every platform and release. Throws `std::invalid_argument` if the game ends within `num_turns` turns.
+inline Position makeMidGameBoardState(const std::size_t num_turns)
+{
+    BoardState board_state{ makeDefaultBoardState() };
+    GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, /*starting_player_index*/ 0 };
+
+    const std::size_t num_pits{ board_state.getNumPits() };
+    for (std::size_t turn = 0; turn < num_turns; ++turn)
+    {
+        if (game_mechanics_executor.isGameFinished(board_state))
+        {
+            throw std::invalid_argument("`makeMidGameBoardState()`: the game ends before `num_turns`");
+        }
+
+        for (std::size_t n = 0; n < num_pits; ++n)
+        {
+            if (game_mechanics_executor.playTurn(((turn * 5) + 2 + n) % num_pits, board_state))
+            {
+                break;
+            }
+        }
+    }
+
+    if (game_mechanics_executor.isGameFinished(board_state))
+    {
+        throw std::invalid_argument("`makeMidGameBoardState()`: the game ends before `num_turns`");
+    }
+
+    return Position{ board_state, game_mechanics_executor.getActivePlayerIndex() };
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <board_state.h>
+#include <game_mechanics.h>
+#include <solver.h>
+#include <transposition_table.h>
+
+enum class ProofOutcome
+{
+    kProven,
+    kDisproven,
+    //! The node limit was reached first
+    kUnknown
+};
+
+struct ProofNumberResult
+{
+    ProofOutcome outcome{ ProofOutcome::kUnknown };
+    //! A move that reaches the target, if proven and the game is not already finished
+    std::optional<std::size_t> best_pit_index{};
+    //! Positions expanded
+    std::size_t num_nodes{ 0 };
+};
+
+//! Depth-first proof-number search (df-pn) for yes/no questions about a position: can the player to move force a final
+//! bank differential of at least some target? A target of `1` asks for a guaranteed win, like `Solver::solve()`, and
+//! `0` for at least a draw. Unlike depth-first enumeration, the search keeps expanding the most promising frontier node,
+//! so it proves or disproves the question without searching all the moves that do not matter for the answer.
+//!
+//! Each node asks the question from the perspective of its player to move, relative to the current banks, so it is an OR
+//! node for that player. A move that passes the turn leads to the opponent's question with the target negated, and
+//! counts as an AND node of the mover (its proof number is the opponent's disproof number). A move that ends in the
+//! bank keeps the same player and question, minus the stones just banked, and counts as an OR node.
+//!
+//! Proof and disproof numbers are kept in a fixed-size table, so memory stays bounded however long the search runs;
+//! when a bucket is full, the entry that took the least work to compute is replaced. Thresholds for the children use the
+//! 1 + epsilon trick, which cuts down on re-expansions when the search switches between siblings. If a
+//! `TranspositionTable` is given, proven and disproven positions are also stored in it as bounds on the bank-relative
+//! value, and its solved entries answer questions without a search, so a table shared with `NegamaxSolver` serves both
+//! solvers.
+class ProofNumberSolver
+{
+public:
+    explicit ProofNumberSolver(const std::size_t proof_table_size_bytes = kDefaultTranspositionTableSizeBytes,
+                               std::shared_ptr<TranspositionTable> transposition_table = nullptr);
+
+    //! Proves or disproves that the player to move can force a final bank differential of at least `target`. Stops with
+    //! `ProofOutcome::kUnknown` after `max_nodes` expansions, if given.
+    ProofNumberResult solve(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor, const int target = 1,
+                            const std::optional<std::size_t> max_nodes = std::nullopt);
+
+private:
+    static constexpr std::uint32_t kInfinity{ std::numeric_limits<std::uint32_t>::max() };
+
+    struct ProofNumbers
+    {
+        std::uint32_t proof;
+        std::uint32_t disproof;
+    };
+
+    struct Entry
+    {
+        std::uint64_t key;
+        ProofNumbers numbers;
+        //! Expansions below this node, saturating, for replacement
+        std::uint32_t work;
+    };
+
+    static constexpr std::size_t kBucketSize{ 4 };
+
+    struct Bucket
+    {
+        std::array<Entry, kBucketSize> entries;
+    };
+
+    //! A move from a node, with the child in canonical form
+    struct Child
+    {
+        BoardState board_state;
+        //! Key of the child's question
+        std::uint64_t key;
+        //! The child's target, relative to its banks and from its own player to move's perspective
+        int target;
+        //! The move ended in the mover's bank, so the child asks the same player's question
+        bool extra_turn;
+        std::uint8_t pit_index;
+        //! The answer to the child's question if the game is over
+        std::optional<bool> finished_game_answer;
+    };
+
+    //! Searches the node until its proof number reaches `proof_threshold` or its disproof number reaches
+    //! `disproof_threshold`, and returns its numbers. `board_state` is canonical, with the player to move as player 0.
+    ProofNumbers search(const BoardState& board_state, const std::uint64_t key, const int target, const std::uint32_t proof_threshold,
+                        const std::uint32_t disproof_threshold, std::size_t* best_pit_index_out);
+
+    //! Numbers of a child's question, from the tables or the initial estimate for unexplored positions
+    ProofNumbers lookUp(const Child& child) const;
+
+    void store(const std::uint64_t key, const ProofNumbers numbers, const std::uint32_t work);
+
+    //! Records a proven or disproven question as a bound in the transposition table
+    void storeResult(const BoardState& board_state, const int target, const bool proven) const;
+
+    //! The answer for a finished game, relative to the banks, if the game is finished
+    static std::optional<bool> getFinishedGameAnswer(const BoardState& board_state, const int target);
+
+    static std::uint64_t getKey(const BoardState& board_state, const int target);
+
+    std::vector<Bucket> buckets_;
+    std::size_t bucket_mask_;
+    std::shared_ptr<TranspositionTable> transposition_table_;
+
+    std::size_t num_nodes_{ 0 };
+    std::optional<std::size_t> max_nodes_{};
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+
+#include <board_state.h>
+#include <game_mechanics.h>
+
+//! Straightforward stone-by-stone implementation of the turn rules, using only the checked board accessors. Far slower
+//! than `TurnExecutor`, but simple enough to be obviously correct, so fast kernels are cross-checked against it (see
+//! `Perft::verify()`).
+template <typename Rules>
+class BasicReferenceTurnExecutor
+{
+public:
+    TurnResult playTurn(const std::size_t player_index, const std::size_t pit_index, BoardState& board_state) const
+    {
+        if ((player_index != 0) && (player_index != 1))
+        {
+            return TurnResult::makeInvalidResult();
+        }
+
+        if (pit_index >= board_state.getNumPits())
+        {
+            return TurnResult::makeInvalidResult();
+        }
+
+        SinglePlayerBoardState& active_player_board_state{ (player_index == 0) ? board_state.getPlayer0BoardState()
+                                                                               : board_state.getPlayer1BoardState() };
+        SinglePlayerBoardState& opposing_player_board_state{ (player_index == 0) ? board_state.getPlayer1BoardState()
+                                                                                 : board_state.getPlayer0BoardState() };
+
+        int num_stones{ active_player_board_state.getNumStonesInPit(pit_index) };
+        if (num_stones <= 0)
+        {
+            return TurnResult::makeInvalidResult();
+        }
+        active_player_board_state.clearStonesFromPit(pit_index);
+
+        const std::size_t num_pits{ board_state.getNumPits() };
+
+        // Walk the board one stone at a time: the active player's pits, their bank, the opposing player's pits, then
+        // the opposing player's bank if the rules sow into it
+        bool on_active_side{ true };
+        std::size_t position{ pit_index };
+        bool in_bank{ false };
+        bool in_opposing_bank{ false };
+        while (num_stones > 0)
+        {
+            if (in_bank)
+            {
+                in_bank = false;
+                on_active_side = false;
+                position = 0;
+            }
+            else if (in_opposing_bank)
+            {
+                in_opposing_bank = false;
+                on_active_side = true;
+                position = 0;
+            }
+            else if (on_active_side && ((position + 1) == num_pits))
+            {
+                in_bank = true;
+            }
+            else if (!on_active_side && ((position + 1) == num_pits))
+            {
+                if constexpr (Rules::kSowsIntoOpposingBank)
+                {
+                    in_opposing_bank = true;
+                }
+                else
+                {
+                    // Skip the opposing player's bank
+                    on_active_side = true;
+                    position = 0;
+                }
+            }
+            else
+            {
+                ++position;
+            }
+
+            if (in_bank)
+            {
+                active_player_board_state.addStonesToBank(1);
+            }
+            else if (in_opposing_bank)
+            {
+                opposing_player_board_state.addStonesToBank(1);
+            }
+            else if (on_active_side)
+            {
+                active_player_board_state.addStoneToPit(position);
+            }
+            else
+            {
+                opposing_player_board_state.addStoneToPit(position);
+            }
+            --num_stones;
+        }
+
+        if (in_bank)
+        {
+            return TurnResult::makeEndedInBankResult();
+        }
+
+        // Ending in the opposing player's bank leaves `on_active_side` false, so there is nothing to capture
+        if (on_active_side)
+        {
+            const std::size_t opposing_pit_index{ num_pits - position - 1 };
+            const int num_stones_in_opposing_pit{ opposing_player_board_state.getNumStonesInPit(opposing_pit_index) };
+            if ((active_player_board_state.getNumStonesInPit(position) == 1) &&
+                (Rules::kCapturesFromEmptyOpposingPit || (num_stones_in_opposing_pit > 0)))
+            {
+                active_player_board_state.addStonesToBank(1 + num_stones_in_opposing_pit);
+                active_player_board_state.clearStonesFromPit(position);
+                opposing_player_board_state.clearStonesFromPit(opposing_pit_index);
+            }
+        }
+
+        return TurnResult::makeNotEndedInBankResult();
+    }
+};
+
+using ReferenceTurnExecutor = BasicReferenceTurnExecutor<KalahRules>;
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <board_state.h>
+
+struct RetrogradeOptions
+{
+    //! Positions held in memory during enumeration, over all layers, before they are sorted and spilled to disk
+    std::size_t max_buffered_positions{ std::size_t{ 1 } << 24 };
+    //! Memory for decoded chunks of solved layers, which serve the child lookups while solving and probing
+    std::size_t chunk_cache_size_bytes{ std::size_t{ 256 } << 20 };
+};
+
+//! Strong solution of a whole game: the exact value of every position reachable from a starting position, computed
+//! by retrograde analysis with all large data structures on disk, so that state spaces larger than memory can be
+//! solved.
+//!
+//! Positions are stored in canonical form (see `BoardState::getCanonical()`) without their banks, with values relative
+//! to the banks like `EndgameTablebase`, and grouped into layers by the number of stones left in the pits. Stones only
+//! ever leave the pits, so every move stays in its layer or goes to a smaller one. Within a layer, a move only carries
+//! stones forward on the mover's side, which strictly increases the potential `sum(pit index * stones)` over both
+//! sides. Keys sort by potential first, so sorted order within a layer is a topological order of its moves.
+//!
+//! `solve()` runs in two passes:
+//!
+//! - Enumeration, from the starting layer down: each layer's positions are extracted in key order from an external
+//!   priority queue of sorted runs spilled to disk. Children in smaller layers are buffered and spilled as runs of
+//!   their own layer. Children in the same layer have a higher potential, so they can still be added while the layer
+//!   is being extracted.
+//! - Solving, from the smallest layer up: each layer is walked in descending key order, so every child has been solved
+//!   already, either in a smaller layer or earlier in the same one.
+//!
+//! Runs and layers are stored as delta- and varint-encoded chunks of sorted keys. Solved layers keep one value byte per
+//! position next to the keys, and lookups find the chunk through an in-memory index of first keys and decode it
+//! through an LRU cache.
+class RetrogradeDatabase
+{
+public:
+    //! Solves every position reachable from `board_state` with `active_player_index` to move and writes the database
+    //! to `directory`, which is created if needed. Throws `std::invalid_argument` if the position has more than 127
+    //! stones in the pits and `std::runtime_error` on I/O errors.
+    static RetrogradeDatabase solve(const BoardState& board_state, const std::size_t active_player_index,
+                                    const std::string& directory, const RetrogradeOptions& options = RetrogradeOptions{});
+
+    //! Opens a database written by `solve()`. Throws `std::runtime_error` for missing or malformed databases.
+    static RetrogradeDatabase open(const std::string& directory, const RetrogradeOptions& options = RetrogradeOptions{});
+
+    RetrogradeDatabase(const RetrogradeDatabase&) = delete;
+    RetrogradeDatabase& operator=(const RetrogradeDatabase&) = delete;
+
+    RetrogradeDatabase(RetrogradeDatabase&&) noexcept;
+    RetrogradeDatabase& operator=(RetrogradeDatabase&&) noexcept;
+
+    ~RetrogradeDatabase();
+
+    std::size_t getNumPits() const
+    {
+        return num_pits_;
+    }
+
+    //! Number of stones in the pits of the starting position
+    int getMaxStones() const
+    {
+        return max_stones_;
+    }
+
+    //! Stored positions with `num_stones` stones in the pits. Finished games are not stored.
+    std::uint64_t getNumPositions(const int num_stones) const;
+
+    std::uint64_t getNumPositions() const;
+
+    //! Final bank differential for the active player with perfect play by both players, if the position is reachable
+    //! from the starting position or the game is over. Probes share a cache, so they must not run concurrently.
+    std::optional<int> probe(const BoardState& board_state, const std::size_t active_player_index) const;
+
+private:
+    class KeyIndexer;
+    class ChunkCache;
+    class LayerFile;
+
+    RetrogradeDatabase(const std::string& directory, const std::size_t num_pits, const int max_stones,
+                       const RetrogradeOptions& options);
+
+    //! Writes each layer's reachable positions to a sorted positions file and returns the number of positions per layer
+    std::vector<std::uint64_t> enumeratePositions(const BoardState& canonical_board_state, const RetrogradeOptions& options) const;
+    //! Solves the layers enumerated by `enumeratePositions()` into value files, replacing the positions files
+    void solveLayers(const std::vector<std::uint64_t>& num_positions);
+    void writeManifest() const;
+    std::string getLayerPath(const int num_stones, const std::string& extension) const;
+
+    std::string directory_;
+    std::size_t num_pits_;
+    int max_stones_;
+    std::unique_ptr<KeyIndexer> key_indexer_;
+    std::unique_ptr<ChunkCache> chunk_cache_;
+    //! Solved layers, indexed by number of stones. Empty layers are null.
+    std::vector<std::unique_ptr<LayerFile>> layers_;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include <board_state.h>
+#include <transposition_table.h>
+
+//! Set to `0` to compile out search statistics. Counters then stay at zero and recording them costs nothing.
+#ifndef MANCALA_SOLVER_ENABLE_STATS
+#define MANCALA_SOLVER_ENABLE_STATS 1
+#endif
+
+constexpr bool kSearchStatsEnabled{ MANCALA_SOLVER_ENABLE_STATS != 0 };
+
+//! Work spent on one move at the root of the search
+struct RootMoveStats
+{
+    std::uint64_t num_nodes{ 0 };
+    std::chrono::nanoseconds elapsed{ 0 };
+};
+
+//! Counters describing how a search went. Each search thread records into its own copy, and the copies are merged
+//! when the search finishes, so recording never touches shared memory.
+struct SearchStats
+{
+    //! Per-ply counters are only kept this close to the root. Deeper nodes are counted in the last ply.
+    static constexpr std::size_t kMaxPly{ 64 };
+
+    std::uint64_t num_nodes{ 0 };
+    std::chrono::nanoseconds elapsed{ 0 };
+
+    std::uint64_t num_transposition_hits{ 0 };
+    std::uint64_t num_transposition_misses{ 0 };
+    //! Misses where the bucket was full of other positions, i.e. the table is too small to keep the position
+    std::uint64_t num_transposition_collisions{ 0 };
+
+    //! Beta cutoffs by the index of the cutting move in move order
+    std::array<std::uint64_t, kMaxNumPits> num_cutoffs_by_move_index{};
+
+    //! Interior nodes and the children searched from them, by ply
+    std::array<std::uint64_t, kMaxPly> num_interior_nodes_by_ply{};
+    std::array<std::uint64_t, kMaxPly> num_children_by_ply{};
+
+    //! By pit index. Under a parallel search the work of a root move is attributed to the thread that searched it, so
+    //! it also includes any other tasks that thread helped with while waiting.
+    std::array<RootMoveStats, kMaxNumPits> root_moves{};
+
+    void countTranspositionProbe(const ProbeOutcome outcome)
+    {
+        if constexpr (kSearchStatsEnabled)
+        {
+            switch (outcome)
+            {
+                case ProbeOutcome::kHit:
+                    ++num_transposition_hits;
+                    break;
+                case ProbeOutcome::kMiss:
+                    ++num_transposition_misses;
+                    break;
+                case ProbeOutcome::kCollision:
+                    ++num_transposition_misses;
+                    ++num_transposition_collisions;
+                    break;
+            }
+        }
+    }
+
+    void countCutoff(const std::size_t move_index)
+    {
+        if constexpr (kSearchStatsEnabled)
+        {
+            ++num_cutoffs_by_move_index[move_index];
+        }
+    }
+
+    void countInteriorNode(const std::size_t ply, const std::size_t num_children)
+    {
+        if constexpr (kSearchStatsEnabled)
+        {
+            const std::size_t clamped_ply{ (ply < kMaxPly) ? ply : (kMaxPly - 1) };
+            ++num_interior_nodes_by_ply[clamped_ply];
+            num_children_by_ply[clamped_ply] += num_children;
+        }
+    }
+
+    void addRootMove(const std::size_t pit_index, const std::uint64_t num_move_nodes, const std::chrono::nanoseconds move_elapsed)
+    {
+        if constexpr (kSearchStatsEnabled)
+        {
+            root_moves[pit_index].num_nodes += num_move_nodes;
+            root_moves[pit_index].elapsed += move_elapsed;
+        }
+    }
+
+    //! Adds all counters of `other`, which may come from another thread or another search iteration
+    void merge(const SearchStats& other);
+
+    double getNodesPerSecond() const;
+
+    std::uint64_t getNumTranspositionProbes() const
+    {
+        return num_transposition_hits + num_transposition_misses;
+    }
+
+    //! Fractions of all transposition table probes. Zero if there were no probes.
+    double getTranspositionHitRate() const;
+    double getTranspositionMissRate() const;
+    double getTranspositionCollisionRate() const;
+
+    std::uint64_t getNumCutoffs() const;
+
+    //! Average number of children searched per interior node at `ply`, the effective branching factor after pruning.
+    //! Zero if no interior node was searched at `ply`.
+    double getBranchingFactor(const std::size_t ply) const;
+};
+
+std::ostream& operator<<(std::ostream& os, const SearchStats& search_stats);
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <move_generator.h>
+#include <opening_book.h>
+#include <solver.h>
+
+//! How a side picks its moves in `SelfPlay`
+enum class SelfPlayPolicy
+{
+    //! Uniformly random legal move
+    kRandom,
+    //! Most stones banked this turn, preferring extra turns and breaking ties at random
+    kGreedy,
+    //! `NegamaxSolver`'s best move, within `SelfPlayOptions::solver_time_limit_per_move`
+    kSolver
+};
+
+//! Parses `random`, `greedy` or `solver`. Throws `std::invalid_argument` for anything else.
+SelfPlayPolicy parseSelfPlayPolicy(const std::string& name);
+
+//! One game in a game log: the moves are enough to replay every position, since the rules are deterministic
+struct GameRecord
+{
+    std::size_t starting_player_index{ 0 };
+    std::vector<std::uint8_t> pit_indices{};
+    //! Player 0's final bank minus player 1's, after the remaining stones are swept into the banks
+    int final_bank_differential{ 0 };
+};
+
+//! Writes a game log: a `GameLogHeader`, then for each game a `GameLogRecordHeader` followed by one byte per move, in
+//! host byte order. Moves are only stored as pit indices, so a typical game takes a few dozen bytes.
+class GameLogWriter
+{
+public:
+    GameLogWriter(std::ostream& output, const std::size_t num_pits, const int num_stones_per_pit);
+
+    void write(const GameRecord& game_record);
+
+private:
+    std::ostream& output_;
+};
+
+//! Reads a game log written by `GameLogWriter`. Throws `std::runtime_error` if the log has the wrong magic or version
+//! or ends in the middle of a game.
+class GameLogReader
+{
+public:
+    explicit GameLogReader(std::istream& input);
+
+    std::size_t getNumPits() const
+    {
+        return num_pits_;
+    }
+
+    int getNumStonesPerPit() const
+    {
+        return num_stones_per_pit_;
+    }
+
+    //! Reads the next game into `game_record`. Returns false at the end of the log.
+    bool read(GameRecord& game_record);
+
+    //! The position before each move of a game, from the starting board of the log. Throws `std::runtime_error` if a
+    //! move is not legal.
+    std::vector<Position> replay(const GameRecord& game_record) const;
+
+private:
+    std::istream& input_;
+    std::size_t num_pits_{ 0 };
+    int num_stones_per_pit_{ 0 };
+};
+
+struct SelfPlayOptions
+{
+    std::size_t num_games{ 1000 };
+    //! Games played concurrently, one per thread at a time
+    std::size_t num_threads{ 1 };
+    std::size_t num_pits{ 6 };
+    int num_stones_per_pit{ 4 };
+    //! Policy of player 0 and player 1. Player 0 starts the even games and player 1 the odd ones.
+    std::array<SelfPlayPolicy, 2> policies{ SelfPlayPolicy::kRandom, SelfPlayPolicy::kRandom };
+    //! Game `i` draws its random moves from a generator seeded with `seed` and `i`, so a run can be reproduced
+    //! regardless of the number of threads
+    std::uint64_t seed{ 0 };
+    //! Time for each solver move, or solve every move exactly if not set
+    std::optional<std::chrono::milliseconds> solver_time_limit_per_move{ std::chrono::milliseconds{ 100 } };
+    //! Size of each thread's transposition table, which is kept across the moves and games that thread plays
+    std::size_t transposition_table_size_bytes{ kDefaultTranspositionTableSizeBytes };
+    //! See `TranspositionTable::TranspositionTable()`
+    bool use_huge_pages{ false };
+    const OpeningBook* opening_book{ nullptr };
+};
+
+struct SelfPlaySummary
+{
+    std::uint64_t num_games{ 0 };
+    std::uint64_t num_moves{ 0 };
+    //! Games won by player 0, won by player 1 and drawn
+    std::array<std::uint64_t, 3> num_results{};
+    std::uint64_t num_solver_moves{ 0 };
+    std::chrono::duration<double> total_solver_time{};
+    std::chrono::duration<double> max_solver_time{};
+    std::chrono::duration<double> elapsed{};
+
+    double getGamesPerSecond() const
+    {
+        return static_cast<double>(num_games) / elapsed.count();
+    }
+
+    double getMovesPerSecond() const
+    {
+        return static_cast<double>(num_moves) / elapsed.count();
+    }
+};
+
+//! Plays games between two policies on a pool of threads, for throughput and solver latency measurements and to
+//! produce game logs. `GameLogReader::replay()` turns a log into the positions reached, as input for `BatchAnalyzer`.
+class SelfPlay
+{
+public:
+    //! Throws `std::invalid_argument` for an unsupported board
+    explicit SelfPlay(const SelfPlayOptions& options);
+
+    //! Plays `SelfPlayOptions::num_games` games. If `game_log` is given, every game is written to it as it finishes, so
+    //! games are logged in completion order.
+    SelfPlaySummary run(GameLogWriter* game_log) const;
+
+private:
+    SelfPlayOptions options_;
+};
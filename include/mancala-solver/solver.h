@@ -1,26 +1,148 @@
 #pragma once
 
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include <board_state.h>
+#include <endgame_tablebase.h>
 #include <game_mechanics.h>
+#include <game_tree_statistics.h>
+#include <opening_book.h>
+#include <search_stats.h>
+#include <transposition_table.h>
+#include <zobrist.h>
+
+constexpr std::size_t kDefaultTranspositionTableSizeBytes{ std::size_t{ 64 } << 20 };
+
+//! Where and how often `Solver` snapshots its progress
+struct SolverCheckpointSettings
+{
+    std::string path{};
+    std::chrono::seconds interval{ 600 };
+    //! Continue from the snapshot at `path` if there is one, instead of starting over. A missing snapshot starts a new
+    //! solve, so the same command line can be rerun until the solve finishes.
+    bool resume{ false };
+};
 
 class Solver
 {
 public:
+    explicit Solver(const std::size_t transposition_table_size_bytes = kDefaultTranspositionTableSizeBytes,
+                    const bool use_huge_pages = false) :
+                transposition_table_{ transposition_table_size_bytes, use_huge_pages }
+    {
+    }
+
+    //! The book settles root moves without searching them. The book holds exact values, while the search lets opposing
+    //! moves that end the game in a draw stand without refuting a win, so only book wins and losses are used: a position
+    //! the book has as drawn can still have a guaranteed win here and is searched instead. A root position the book has
+    //! as won only bounds the search by the book's move, since a lower pit may also win and `solve()` returns the lowest
+    //! winning pit. The book must outlive the solver or be reset with `nullptr`.
+    void setOpeningBook(const OpeningBook* opening_book)
+    {
+        opening_book_ = opening_book;
+    }
+
+    //! Positions covered by `endgame_tablebase` are settled from their exact value without searching, unless the value
+    //! is a draw: with draws by the opposing player not refuting a win (see `setOpeningBook()`), a drawn position can
+    //! still have a guaranteed win. The tablebase must outlive the solver or be reset with `nullptr`.
+    void setEndgameTablebase(const EndgameTablebase* endgame_tablebase)
+    {
+        endgame_tablebase_ = endgame_tablebase;
+    }
+
+    //! With checkpoint settings, `solve()` periodically replaces the snapshot at `settings->path` with the transposition
+    //! table and the root move it is working on, and writes the result once it finishes. Snapshots are written to a
+    //! temporary file and renamed over the previous one, so a crash while saving keeps the previous snapshot.
+    //!
+    //! Resuming restarts the root move that was in progress, but every subtree solved before the snapshot is answered
+    //! from the table. With several threads, the others pause at their next node while a snapshot is written, so it
+    //! holds the table as it was at one point in the search.
+    void setCheckpoint(const std::optional<SolverCheckpointSettings>& settings)
+    {
+        checkpoint_settings_ = settings;
+    }
+
+    //! With a thread count, `solve()` falls back to `GameTreeStatistics` on that many threads when there is no
+    //! guaranteed win. Without one, the guaranteed win search is all that is paid for.
+    void setStatisticsThreads(const std::optional<std::size_t>& num_threads)
+    {
+        statistics_num_threads_ = num_threads;
+    }
+
+    //! Root moves are split across `num_threads` threads sharing the transposition table. The result does not depend on
+    //! the thread count: as with one thread, the lowest winning root move is chosen. Once a root move is found to win,
+    //! the threads searching root moves above it give up, without storing the subtrees they did not finish.
+    void setNumThreads(const std::size_t num_threads)
+    {
+        num_threads_ = std::max<std::size_t>(num_threads, 1);
+    }
+
+    //! Counters of the last `solve()`, merged over all threads. Node counts, transposition table probes and the time per
+    //! root move only cover the guaranteed win search, not the statistics fallback. Empty if the root was answered from
+    //! a finished checkpoint.
+    const SearchStats& getStats() const
+    {
+        return stats_;
+    }
+
     //! Solves for the optimal pit index to choose for the current player. If the move guarantees a win even with
-    //! perfect play by the opposing player, the second return value will be `true`. Otherwise, the move with the
-    //! highest percentage of [winning + drawn] sub-branches is chosen, and the second return value will be `false`.
-    //! Note that this solver does not currently provide the fastest sequence of moves to result in a win.
+    //! perfect play by the opposing player, the second return value will be `true`. Otherwise, the second return value
+    //! will be `false`, and with statistics enabled (see `setStatisticsThreads()`) the move with the highest percentage
+    //! of [winning + drawn] games below it is chosen, or else the first valid move.
+    //! Note that this solver does not currently provide the fastest sequence of moves to result in a win; see
+    //! `NegamaxSolver` for the exact margin and the principal variation.
     std::pair<std::size_t, bool> solve(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor)
     {
-        num_winning_branches_ = std::vector<std::size_t>(board_state.getNumPits(), 0);
-        num_drawn_branches_ = std::vector<std::size_t>(board_state.getNumPits(), 0);
-        num_total_branches_ = std::vector<std::size_t>(board_state.getNumPits(), 0);
+        stats_ = SearchStats{};
+        const std::chrono::steady_clock::time_point start_time{ std::chrono::steady_clock::now() };
 
         const std::size_t initial_active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
 
-        for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+        std::size_t first_pit_index{ 0 };
+        bool resumed{ false };
+        if (checkpoint_settings_.has_value())
+        {
+            checkpoint_board_state_ = board_state;
+            checkpoint_active_player_index_ = initial_active_player_index;
+            if (checkpoint_settings_->resume)
+            {
+                const std::optional<CheckpointProgress> progress{ loadCheckpoint() };
+                if (progress.has_value() && progress->solution.has_value())
+                {
+                    return progress->solution.value();
+                }
+                if (progress.has_value())
+                {
+                    first_pit_index = progress->next_pit_index;
+                    resumed = true;
+                }
+            }
+            next_checkpoint_time_ = std::chrono::steady_clock::now() + checkpoint_settings_->interval;
+        }
+        if (!resumed)
+        {
+            transposition_table_.newSearch();
+        }
+
+        // Root moves that finish the game or are settled by the book are decided right away. The lowest winning one, or
+        // the book's move if the book has the root as won, bounds the moves worth searching.
+        const std::size_t num_pits{ board_state.getNumPits() };
+        lowest_winning_pit_index_.store(
+            probeOpeningBookWinningPitIndex(board_state, initial_active_player_index).value_or(num_pits));
+        search_failed_.store(false);
+        std::vector<RootMove> root_moves{};
+        for (std::size_t i = first_pit_index; i < lowest_winning_pit_index_.load(); ++i)
         {
             GameMechanicsExecutor game_mechanics_executor_i{ game_mechanics_executor };
             BoardState board_state_i{ board_state };
@@ -35,51 +157,415 @@ public:
             {
                 if (winner_player_index.value() == initial_active_player_index)
                 {
-                    return std::make_pair(i, true);
+                    lowest_winning_pit_index_.store(i);
+                    break;
                 }
 
                 continue;
             }
 
-            if (solveInner(board_state_i, game_mechanics_executor_i, initial_active_player_index, /*initial_pit_index*/ i))
+            const std::optional<bool> book_guaranteed_win{
+                probeOpeningBookGuaranteedWin(board_state_i, game_mechanics_executor_i.getActivePlayerIndex(), initial_active_player_index) };
+            if (book_guaranteed_win.has_value())
             {
-                std::size_t num_total_branches{ 0 };
-                for (const std::size_t num_branches : num_total_branches_)
+                if (book_guaranteed_win.value())
                 {
-                    num_total_branches += num_branches;
+                    lowest_winning_pit_index_.store(i);
+                    break;
                 }
-                
-                std::cout << "Total num branches: " << num_total_branches << std::endl;
-                return std::make_pair(i, true);
+
+                continue;
             }
+
+            root_moves.push_back(RootMove{ i, board_state_i, game_mechanics_executor_i });
         }
 
-        double highest_win_and_draw_ratio{ 0.0 };
-        std::size_t index_of_highest_win_and_draw_ratio{ 0 };
+        // A snapshot resumes from the lowest root move that has neither been refuted nor been found to win
+        std::vector<bool> refuted_root_moves(root_moves.size(), false);
+        current_root_pit_index_ = root_moves.empty() ? lowest_winning_pit_index_.load() : root_moves.front().pit_index;
+        const auto refuteRootMove{ [&](const std::size_t root_move_index)
+        {
+            std::lock_guard<std::mutex> lock{ root_progress_mutex_ };
+            refuted_root_moves[root_move_index] = true;
+            const auto unrefuted{ std::find(refuted_root_moves.begin(), refuted_root_moves.end(), false) };
+            current_root_pit_index_ = (unrefuted == refuted_root_moves.end())
+                                          ? lowest_winning_pit_index_.load()
+                                          : root_moves[static_cast<std::size_t>(unrefuted - refuted_root_moves.begin())].pit_index;
+        } };
 
-        for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+        // Threads take root moves in order, so every move below the lowest win has been taken once a thread stops
+        std::atomic<std::size_t> next_root_move_index{ 0 };
+        std::mutex stats_mutex{};
+        const auto searchRootMoves{ [&]()
         {
-            const double win_and_draw_ratio{ static_cast<double>(num_winning_branches_.at(i)) / static_cast<double>(num_total_branches_.at(i)) };
+            const SearchingThreadScope searching_thread_scope{ *this };
+            ThreadContext thread_context{};
+            for (std::size_t r = next_root_move_index.fetch_add(1); r < root_moves.size(); r = next_root_move_index.fetch_add(1))
+            {
+                const RootMove& root_move{ root_moves[r] };
+                thread_context.root_pit_index = root_move.pit_index;
+                thread_context.aborted = false;
+
+                const std::uint64_t root_move_start_num_nodes{ thread_context.stats.num_nodes };
+                const std::chrono::steady_clock::time_point root_move_start_time{ std::chrono::steady_clock::now() };
+                const bool guaranteed_win{
+                    solveInner(root_move.board_state, root_move.game_mechanics_executor, initial_active_player_index, thread_context) };
+                thread_context.stats.addRootMove(root_move.pit_index, thread_context.stats.num_nodes - root_move_start_num_nodes,
+                                                 std::chrono::steady_clock::now() - root_move_start_time);
+                if (thread_context.aborted)
+                {
+                    // Only happens above a win or after a failure, which applies to every later root move too
+                    break;
+                }
+
+                if (guaranteed_win)
+                {
+                    std::size_t lowest_winning_pit_index{ lowest_winning_pit_index_.load() };
+                    while ((root_move.pit_index < lowest_winning_pit_index) &&
+                           !lowest_winning_pit_index_.compare_exchange_weak(lowest_winning_pit_index, root_move.pit_index))
+                    {
+                    }
+                    break;
+                }
+                refuteRootMove(r);
+            }
+
+            std::lock_guard<std::mutex> lock{ stats_mutex };
+            stats_.merge(thread_context.stats);
+        } };
 
-            if (win_and_draw_ratio > highest_win_and_draw_ratio)
+        const std::size_t num_threads{ std::min(num_threads_, std::max<std::size_t>(root_moves.size(), 1)) };
+        if (num_threads == 1)
+        {
+            searchRootMoves();
+        }
+        else
+        {
+            std::vector<std::thread> threads{};
+            std::vector<std::exception_ptr> thread_exceptions(num_threads);
+            for (std::size_t t = 0; t < num_threads; ++t)
             {
-                highest_win_and_draw_ratio = win_and_draw_ratio;
-                index_of_highest_win_and_draw_ratio = i;
+                threads.emplace_back([&, t]()
+                {
+                    try
+                    {
+                        searchRootMoves();
+                    }
+                    catch (...)
+                    {
+                        // A snapshot that cannot be written aborts the other threads too
+                        thread_exceptions[t] = std::current_exception();
+                        search_failed_.store(true);
+                    }
+                });
+            }
+            for (std::thread& thread : threads)
+            {
+                thread.join();
             }
+            for (const std::exception_ptr& thread_exception : thread_exceptions)
+            {
+                if (thread_exception != nullptr)
+                {
+                    std::rethrow_exception(thread_exception);
+                }
+            }
+        }
+
+        stats_.elapsed = std::chrono::steady_clock::now() - start_time;
+
+        const std::size_t lowest_winning_pit_index{ lowest_winning_pit_index_.load() };
+        if (lowest_winning_pit_index < num_pits)
+        {
+            return finishSolve(std::make_pair(lowest_winning_pit_index, true));
+        }
+
+        return finishSolve(std::make_pair(chooseFallbackPitIndex(board_state, game_mechanics_executor), false));
+    }
+
+private:
+    //! Root move that does not finish the game, with the position after it
+    struct RootMove
+    {
+        std::size_t pit_index;
+        BoardState board_state;
+        GameMechanicsExecutor game_mechanics_executor;
+    };
+
+    //! State of one search thread
+    struct ThreadContext
+    {
+        //! Root move the thread is searching
+        std::size_t root_pit_index{ 0 };
+        //! Set once the root move no longer matters. Nothing below it is stored from then on.
+        bool aborted{ false };
+        std::uint64_t num_checkpoint_polls{ 0 };
+        //! Merged into `stats_` once the thread runs out of root moves
+        SearchStats stats{};
+    };
+
+    //! What a snapshot says about the root
+    struct CheckpointProgress
+    {
+        //! Root move to continue with
+        std::size_t next_pit_index;
+        //! Set if the solve had finished
+        std::optional<std::pair<std::size_t, bool>> solution;
+    };
+
+    //! Writes the snapshot, with `solution` if the solve has finished. Throws `std::runtime_error` if it cannot be
+    //! written.
+    void saveCheckpoint(const std::optional<std::pair<std::size_t, bool>>& solution) const;
+
+    //! Restores the transposition table from the snapshot, if there is one. Throws
+    //! `std::runtime_error` if the snapshot is malformed or belongs to another position.
+    std::optional<CheckpointProgress> loadCheckpoint();
+
+    //! Counts the thread it is created on as searching for as long as it is in scope, so a snapshot knows how many
+    //! threads to wait for. Threads that are done never store into the table again, and do not hold up a snapshot.
+    class SearchingThreadScope
+    {
+    public:
+        explicit SearchingThreadScope(Solver& solver) :
+                    solver_{ solver }
+        {
+            std::lock_guard<std::mutex> lock{ solver_.pause_mutex_ };
+            ++solver_.num_searching_threads_;
+        }
+
+        SearchingThreadScope(const SearchingThreadScope&) = delete;
+        SearchingThreadScope& operator=(const SearchingThreadScope&) = delete;
+
+        ~SearchingThreadScope()
+        {
+            std::lock_guard<std::mutex> lock{ solver_.pause_mutex_ };
+            --solver_.num_searching_threads_;
+            solver_.pause_condition_.notify_all();
+        }
+
+    private:
+        Solver& solver_;
+    };
+
+    //! Saves a snapshot if one is due. A thread that finds another one saving skips the snapshot instead of waiting, and
+    //! pauses at its next node instead. `TranspositionTable::save()` must not run while entries are stored, so the
+    //! saving thread waits until every other searching thread has paused.
+    void pollCheckpoint()
+    {
+        const std::unique_lock<std::mutex> lock{ checkpoint_mutex_, std::try_to_lock };
+        if (!lock.owns_lock() || (std::chrono::steady_clock::now() < next_checkpoint_time_))
+        {
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> pause_lock{ pause_mutex_ };
+            pause_requested_.store(true);
+            pause_condition_.wait(pause_lock, [&]() { return (num_paused_threads_ + 1) == num_searching_threads_; });
+        }
+        try
+        {
+            saveCheckpoint(std::nullopt);
+        }
+        catch (...)
+        {
+            resumePausedThreads();
+            throw;
+        }
+        resumePausedThreads();
+        next_checkpoint_time_ = std::chrono::steady_clock::now() + checkpoint_settings_->interval;
+    }
+
+    //! Waits while another thread writes a snapshot, see `pollCheckpoint()`
+    void pauseForCheckpoint()
+    {
+        std::unique_lock<std::mutex> pause_lock{ pause_mutex_ };
+        ++num_paused_threads_;
+        pause_condition_.notify_all();
+        pause_condition_.wait(pause_lock, [&]() { return !pause_requested_.load(); });
+        --num_paused_threads_;
+    }
+
+    void resumePausedThreads()
+    {
+        std::lock_guard<std::mutex> pause_lock{ pause_mutex_ };
+        pause_requested_.store(false);
+        pause_condition_.notify_all();
+    }
+
+    //! True once the root move of `thread_context` is above a known win, or another thread has failed
+    bool isAborted(ThreadContext& thread_context) const
+    {
+        if (!thread_context.aborted &&
+            (search_failed_.load(std::memory_order_relaxed) ||
+             (thread_context.root_pit_index > lowest_winning_pit_index_.load(std::memory_order_relaxed))))
+        {
+            thread_context.aborted = true;
+        }
+
+        return thread_context.aborted;
+    }
+
+    std::pair<std::size_t, bool> finishSolve(const std::pair<std::size_t, bool>& solution) const
+    {
+        if (checkpoint_settings_.has_value())
+        {
+            saveCheckpoint(solution);
         }
 
-        return std::make_pair(index_of_highest_win_and_draw_ratio, false);
+        return solution;
     }
 
     //! If the currently active player is the initially active player, returns true if there was a guaranteed win in any sub-branch. 
     //! If the currently active player is opposing the initially active player, return true if all sub-branches contain a guaranteed win
     //! for the initially active player.
     bool solveInner(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor, const std::size_t initial_active_player_index,
-            const std::size_t initial_pit_index)
+                    ThreadContext& thread_context)
+    {
+        const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
+        // `searchGuaranteedWin()` scores drawn leaves differently depending on whether the initially active player is to
+        // move, so that is part of the key. Everything else is relative to the player to move, so the canonical form
+        // lets mirrored positions share entries.
+        const std::uint64_t key{ ZobristHasher::hashCanonical(board_state, active_player_index) ^
+                                 ((active_player_index == initial_active_player_index) ? 0 : kInitialOpposingPlayerToMoveKeyMask) };
+
+        ++thread_context.stats.num_nodes;
+
+        // Checking the clock costs more than a node, so it is only read every few thousand nodes
+        if (checkpoint_settings_.has_value() && ((++thread_context.num_checkpoint_polls % kCheckpointPollInterval) == 0))
+        {
+            pollCheckpoint();
+        }
+        if (pause_requested_.load(std::memory_order_relaxed))
+        {
+            pauseForCheckpoint();
+        }
+        if (isAborted(thread_context))
+        {
+            return false;
+        }
+
+        const std::optional<bool> cached_guaranteed_win{
+            probeGuaranteedWin(key, active_player_index, initial_active_player_index, thread_context.stats) };
+        if (cached_guaranteed_win.has_value())
+        {
+            return cached_guaranteed_win.value();
+        }
+
+        const int num_stones_in_pits{ board_state.getPlayer0BoardState().sumOfStonesInPits() +
+                                      board_state.getPlayer1BoardState().sumOfStonesInPits() };
+        if ((endgame_tablebase_ != nullptr) && (num_stones_in_pits <= endgame_tablebase_->getMaxStones()))
+        {
+            const std::optional<int> value{ endgame_tablebase_->probe(board_state, active_player_index) };
+            if (value.has_value() && (value.value() != 0))
+            {
+                // A win for the player to move is a guaranteed win exactly when they are the initially active player
+                const bool guaranteed_win{ (value.value() > 0) == (active_player_index == initial_active_player_index) };
+                storeGuaranteedWin(key, active_player_index, initial_active_player_index, guaranteed_win, num_stones_in_pits);
+
+                return guaranteed_win;
+            }
+        }
+
+        const bool guaranteed_win{ searchGuaranteedWin(board_state, game_mechanics_executor, initial_active_player_index, thread_context) };
+        if (thread_context.aborted)
+        {
+            return false;
+        }
+        storeGuaranteedWin(key, active_player_index, initial_active_player_index, guaranteed_win, num_stones_in_pits);
+
+        return guaranteed_win;
+    }
+
+    //! The book's move if the book has the root as won
+    std::optional<std::size_t> probeOpeningBookWinningPitIndex(const BoardState& board_state, const std::size_t active_player_index) const
+    {
+        if (opening_book_ == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        const std::optional<OpeningBookEntry> entry{ opening_book_->probe(board_state, active_player_index) };
+        if (!entry.has_value() || (entry->value <= 0))
+        {
+            return std::nullopt;
+        }
+
+        return entry->best_pit_index;
+    }
+
+    //! Whether the book settles a position as a guaranteed win for the initially active player or not, see
+    //! `setOpeningBook()`. Empty if the position is not in the book or is drawn.
+    std::optional<bool> probeOpeningBookGuaranteedWin(const BoardState& board_state, const std::size_t active_player_index,
+                                                      const std::size_t initial_active_player_index) const
+    {
+        if (opening_book_ == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        const std::optional<OpeningBookEntry> entry{ opening_book_->probe(board_state, active_player_index) };
+        if (!entry.has_value() || (entry->value == 0))
+        {
+            return std::nullopt;
+        }
+
+        return (entry->value > 0) == (active_player_index == initial_active_player_index);
+    }
+
+    //! Move to play when there is no guaranteed win, see `solve()`
+    std::size_t chooseFallbackPitIndex(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor) const
+    {
+        if (statistics_num_threads_.has_value())
+        {
+            const GameTreeStatisticsResult statistics{
+                GameTreeStatistics::count(board_state, game_mechanics_executor, statistics_num_threads_.value()) };
+
+            double highest_win_and_draw_ratio{ -1.0 };
+            std::size_t index_of_highest_win_and_draw_ratio{ 0 };
+            for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+            {
+                const GameCounts& counts{ statistics.game_counts_per_pit.at(i) };
+                const std::uint64_t num_games{ counts.getNumGames() };
+                if (num_games == 0)
+                {
+                    continue;
+                }
+
+                const double win_and_draw_ratio{ static_cast<double>(counts.num_wins + counts.num_draws) / static_cast<double>(num_games) };
+                if (win_and_draw_ratio > highest_win_and_draw_ratio)
+                {
+                    highest_win_and_draw_ratio = win_and_draw_ratio;
+                    index_of_highest_win_and_draw_ratio = i;
+                }
+            }
+
+            return index_of_highest_win_and_draw_ratio;
+        }
+
+        const SinglePlayerBoardState& active_player_board_state{ (game_mechanics_executor.getActivePlayerIndex() == 0)
+                                                                     ? board_state.getPlayer0BoardState()
+                                                                     : board_state.getPlayer1BoardState() };
+        for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+        {
+            if (active_player_board_state.getNumStonesInPitUnchecked(i) > 0)
+            {
+                return i;
+            }
+        }
+
+        return 0;
+    }
+
+    //! Expands the children of a position which is not in the transposition table. See `solveInner()`.
+    bool searchGuaranteedWin(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+            const std::size_t initial_active_player_index, ThreadContext& thread_context)
     {
         const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
         const std::size_t initial_opposing_player_index{ (initial_active_player_index + 1) % 2 };
 
+        // A child that settles the node is counted as a cutoff, by its index among the valid moves
+        std::size_t move_index{ 0 };
         for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
         {
             BoardState board_state_i{ board_state };
@@ -90,52 +576,43 @@ public:
             {
                 continue;
             }
+            ++move_index;
 
             const std::optional<std::size_t> winner_player_index{ game_mechanics_executor_i.getWinnerPlayerIndex(board_state_i) };
             if (winner_player_index.has_value())
             {
-                if (winner_player_index.value() == initial_active_player_index)
-                {
-                    ++num_winning_branches_.at(initial_pit_index);
-                    ++num_total_branches_.at(initial_pit_index);
-
-                    if (active_player_index == initial_active_player_index)
-                    {
-                        return true;
-                    }
-                }
-                else if (winner_player_index.value() == initial_opposing_player_index)
+                if ((winner_player_index.value() == initial_active_player_index) && (active_player_index == initial_active_player_index))
                 {
-                    if (active_player_index == initial_opposing_player_index)
-                    {
-                        return false;
-                    }
+                    thread_context.stats.countCutoff(move_index - 1);
+                    return true;
                 }
-                // Drawn case
-                else
+                if ((winner_player_index.value() == initial_opposing_player_index) && (active_player_index == initial_opposing_player_index))
                 {
-                    ++num_drawn_branches_.at(initial_pit_index);
+                    thread_context.stats.countCutoff(move_index - 1);
+                    return false;
                 }
 
-                ++num_total_branches_.at(initial_pit_index);
-
                 continue;
             }
                 
             const bool guaranteed_win_for_initially_active_player{
-                solveInner(board_state_i, game_mechanics_executor_i, initial_active_player_index, initial_pit_index)
+                solveInner(board_state_i, game_mechanics_executor_i, initial_active_player_index, thread_context)
             };
+            if (thread_context.aborted)
+            {
+                return false;
+            }
             // This case represents where a guaranteed win is found and the current move is up to the initially active player
             if (guaranteed_win_for_initially_active_player && (active_player_index == initial_active_player_index))
             {
+                thread_context.stats.countCutoff(move_index - 1);
                 return true;
             }
             
             // This case represents where the non-initially-active (opposing) player has a move which prevents a guaranteed win
             if (!guaranteed_win_for_initially_active_player && (active_player_index != initial_active_player_index))
             {
-                // Returning early here will prematurely eliminate some branches that would generate additional data in the case
-                // where there is no guaranteed win given the `initial_pit_index`. This could be improved if necessary.
+                thread_context.stats.countCutoff(move_index - 1);
                 return false;
             }
         }
@@ -150,9 +627,93 @@ public:
         return false;
     }
 
-private:
-    //! Size corresponds to the total number of pits, as the number of winning / total branches is tracked independently for each move choice
-    std::vector<std::size_t> num_winning_branches_;
-    std::vector<std::size_t> num_drawn_branches_;
-    std::vector<std::size_t> num_total_branches_;
+    //! A guaranteed win for the initially active player is stored as a bound on the final bank differential from the
+    //! perspective of the active player: at least `+1` / at most `-1`, depending on who is to move. Otherwise the
+    //! differential is at most `0` / at least `0`.
+    std::optional<bool> probeGuaranteedWin(const std::uint64_t key, const std::size_t active_player_index,
+            const std::size_t initial_active_player_index, SearchStats& stats) const
+    {
+        ProbeOutcome probe_outcome{ ProbeOutcome::kMiss };
+        const std::optional<TranspositionEntry> entry{ transposition_table_.probe(key, &probe_outcome) };
+        stats.countTranspositionProbe(probe_outcome);
+        if (!entry.has_value())
+        {
+            return std::nullopt;
+        }
+
+        // Convert to the perspective of the initially active player
+        const bool flip{ active_player_index != initial_active_player_index };
+        const int value{ flip ? -entry->value : entry->value };
+        Bound bound{ entry->bound };
+        if (flip && (bound == Bound::kLower))
+        {
+            bound = Bound::kUpper;
+        }
+        else if (flip && (bound == Bound::kUpper))
+        {
+            bound = Bound::kLower;
+        }
+
+        if ((bound == Bound::kExact) || ((bound == Bound::kLower) && (value >= 1)) || ((bound == Bound::kUpper) && (value <= 0)))
+        {
+            return value >= 1;
+        }
+
+        return std::nullopt;
+    }
+
+    void storeGuaranteedWin(const std::uint64_t key, const std::size_t active_player_index, const std::size_t initial_active_player_index,
+            const bool guaranteed_win, const int num_stones_in_pits)
+    {
+        const bool initial_active_player_to_move{ active_player_index == initial_active_player_index };
+
+        int value{ 0 };
+        Bound bound{ Bound::kNone };
+        if (initial_active_player_to_move)
+        {
+            value = guaranteed_win ? 1 : 0;
+            bound = guaranteed_win ? Bound::kLower : Bound::kUpper;
+        }
+        else
+        {
+            value = guaranteed_win ? -1 : 0;
+            bound = guaranteed_win ? Bound::kUpper : Bound::kLower;
+        }
+
+        transposition_table_.store(key, value, bound, kNoBestPitIndex, static_cast<std::uint8_t>(num_stones_in_pits));
+    }
+
+    static constexpr std::uint64_t kInitialOpposingPlayerToMoveKeyMask{ 0x9e3779b97f4a7c15 };
+    static constexpr std::uint64_t kCheckpointPollInterval{ 1 << 16 };
+
+    TranspositionTable transposition_table_;
+    const OpeningBook* opening_book_{ nullptr };
+    const EndgameTablebase* endgame_tablebase_{ nullptr };
+
+    std::size_t num_threads_{ 1 };
+    std::optional<std::size_t> statistics_num_threads_{};
+    SearchStats stats_{};
+
+    //! The pit count while no root move is known to win
+    std::atomic<std::size_t> lowest_winning_pit_index_{ 0 };
+    std::atomic<bool> search_failed_{ false };
+
+    std::optional<SolverCheckpointSettings> checkpoint_settings_{};
+    //! Root of the current solve, which a snapshot has to match to be resumed
+    std::optional<BoardState> checkpoint_board_state_{};
+    std::size_t checkpoint_active_player_index_{ 0 };
+    //! Held by the thread writing a snapshot
+    std::mutex checkpoint_mutex_{};
+    std::chrono::steady_clock::time_point next_checkpoint_time_{};
+    //! Root move a snapshot resumes from. Only changed between root moves, so never while a snapshot is written.
+    std::mutex root_progress_mutex_{};
+    std::size_t current_root_pit_index_{ 0 };
+
+    //! Set while a snapshot waits for, or is written with, the other searching threads paused. Guarded by `pause_mutex_`
+    //! together with the thread counts, and also read without it at every node.
+    std::atomic<bool> pause_requested_{ false };
+    std::mutex pause_mutex_{};
+    std::condition_variable pause_condition_{};
+    std::size_t num_searching_threads_{ 0 };
+    std::size_t num_paused_threads_{ 0 };
 };
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <bounded_queue.h>
+#include <endgame_tablebase.h>
+#include <move_generator.h>
+#include <negamax_solver.h>
+#include <opening_book.h>
+#include <solver.h>
+#include <transposition_table.h>
+
+struct SolverServerOptions
+{
+    //! Solves run concurrently, each on a single-threaded `NegamaxSolver`
+    std::size_t num_workers{ 1 };
+    //! Requests waiting for a worker. Connections block once this many are queued.
+    std::size_t queue_capacity{ 256 };
+    //! Size of the transposition table shared by all workers for the lifetime of the server
+    std::size_t transposition_table_size_bytes{ kDefaultTranspositionTableSizeBytes };
+    //! See `TranspositionTable::TranspositionTable()`
+    bool use_huge_pages{ false };
+    //! Must outlive the server
+    const OpeningBook* opening_book{ nullptr };
+    //! Must outlive the server
+    const EndgameTablebase* endgame_tablebase{ nullptr };
+};
+
+//! Long-running solver that answers requests over a TCP or Unix domain socket. The transposition table, opening book
+//! and tablebase stay resident between requests, and all workers share one table, so solving a position warms the
+//! table for every related position (values are stored relative to the banks, so transpositions that differ only in
+//! their banks share entries too).
+//!
+//! The protocol is line based. Each connection sends requests one per line and gets one response line per request, in
+//! order:
+//!
+//! - `solve <position>` solves a position given as in `parseTextPosition()`
+//! - `search <time_limit_ms> <position>` returns the best result found within the time limit
+//! - `ping`
+//! - `quit` closes the connection
+//!
+//! Successful requests are answered with `ok`, followed by `formatTextResult()` for solves, and failed ones with
+//! `error <message>`. Each connection is served by its own thread, which queues its solves for the worker pool.
+class SolverServer
+{
+public:
+    explicit SolverServer(const SolverServerOptions& options);
+
+    SolverServer(const SolverServer&) = delete;
+    SolverServer& operator=(const SolverServer&) = delete;
+
+    //! Stops serving and waits for the connection threads and the workers to finish. Solves in flight are interrupted.
+    ~SolverServer();
+
+    //! Listens on `host:port` (an IPv4 address) and serves until `stop()` is called. Throws `std::runtime_error` if the
+    //! socket cannot be set up.
+    void serveTcp(const std::string& host, const std::uint16_t port);
+
+    //! Listens on the Unix domain socket `path`, replacing any stale socket file, and serves until `stop()` is called.
+    //! Throws `std::runtime_error` if the socket cannot be set up.
+    void serveUnix(const std::string& path);
+
+    //! Makes `serveTcp()` / `serveUnix()` return and closes all connections. Solves in flight are interrupted and return
+    //! their best result so far, and queued requests are answered with an error. Safe to call from any thread.
+    void stop();
+
+    //! Answers one request line (without the trailing newline) as a connection would. Sets `close_connection` for `quit`.
+    std::string handleRequest(const std::string& request, bool& close_connection);
+
+private:
+    struct Request
+    {
+        Position position;
+        std::optional<std::chrono::milliseconds> time_limit{};
+        std::promise<NegamaxResult> result{};
+    };
+
+    void serve(const int listen_fd);
+    void serveConnection(const int connection_fd);
+    void runWorker();
+
+    SolverServerOptions options_;
+    std::shared_ptr<TranspositionTable> transposition_table_;
+    BoundedQueue<Request> request_queue_;
+    std::vector<std::thread> workers_{};
+
+    std::atomic<bool> stop_requested_{ false };
+
+    //! Connection threads are detached and counted, so the destructor can wait for connections that are still open
+    std::mutex connections_mutex_{};
+    std::condition_variable connections_finished_condition_{};
+    int listen_fd_{ -1 };
+    std::unordered_set<int> connection_fds_{};
+    std::size_t num_connection_threads_{ 0 };
+};
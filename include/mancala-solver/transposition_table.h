@@ -0,0 +1,267 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+
+//! Describes how a stored value relates to the true minimax value of a position
+enum class Bound : std::uint8_t
+{
+    kNone,  //!< Empty entry
+    kExact,
+    kLower, //!< The true value is at least the stored value
+    kUpper  //!< The true value is at most the stored value
+};
+
+//! Why a `TranspositionTable::probe()` did or did not find an entry
+enum class ProbeOutcome : std::uint8_t
+{
+    kHit,
+    kMiss,      //!< The bucket had room for the position
+    kCollision  //!< The bucket was full of other positions
+};
+
+//! Value of `TranspositionEntry::best_pit_index` when no best move was recorded
+constexpr std::uint8_t kNoBestPitIndex{ 0xff };
+
+//! Value of `TranspositionEntry::draft` for values searched all the way to the end of the game
+constexpr std::uint8_t kFullDraft{ 0xff };
+
+struct TranspositionEntry
+{
+    std::uint64_t key{ 0 };
+    //! Final bank differential from the perspective of the player to move
+    std::int16_t value{ 0 };
+    Bound bound{ Bound::kNone };
+    std::uint8_t best_pit_index{ kNoBestPitIndex };
+    //! Estimate of how much work the entry represents (larger is more expensive to recompute). Used for replacement.
+    std::uint8_t depth{ 0 };
+    //! Remaining search depth the value was computed with, or `kFullDraft` if it does not depend on a depth limit
+    std::uint8_t draft{ kFullDraft };
+    //! `TranspositionTable::getGeneration()` when the entry was stored
+    std::uint8_t generation{ 0 };
+};
+
+//! How the memory of a `TranspositionTable` is backed
+enum class PageBacking : std::uint8_t
+{
+    kDefault,
+    kTransparentHugePages, //!< Regular mapping that the kernel was asked to back with huge pages where it can
+    kHugeTlb               //!< Explicitly reserved huge pages (see `/proc/sys/vm/nr_hugepages`)
+};
+
+//! Fixed-size hash table of search results, keyed by `ZobristHasher` keys. Each bucket holds two entries: a
+//! depth-preferred slot that only yields to entries representing at least as much work, and an always-replace slot
+//! that keeps recent results around.
+//!
+//! The table is meant to be kept across solves. Entries are stamped with the generation of the solve that stored them,
+//! and `newSearch()` starts a new generation: older entries still answer probes, since the value of a position never
+//! changes, but they no longer hold on to the depth-preferred slot, so each solve gets the deep slots of the table for
+//! its own results.
+//!
+//! The table can be shared between search threads without locks. Each slot is a pair of 64-bit atomics holding the
+//! packed entry data and `key ^ data`; a probe only accepts a slot whose words XOR back to the probed key, so a read
+//! racing with a write to the same slot is rejected as a miss instead of returning a torn entry.
+class TranspositionTable
+{
+public:
+    //! Uses at most `size_bytes` of memory, rounded down to a power-of-two number of buckets (at least one bucket). With
+    //! `use_huge_pages`, the table is backed by huge pages if the system has them reserved, or else by transparent huge
+    //! pages where the kernel supports them, which cuts TLB misses on the random accesses of a large table. Throws
+    //! `std::bad_alloc` if the memory cannot be mapped.
+    explicit TranspositionTable(const std::size_t size_bytes, const bool use_huge_pages = false);
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    ~TranspositionTable();
+
+    //! Starts a new generation. Safe to call while other threads are using the table.
+    void newSearch()
+    {
+        generation_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint8_t getGeneration() const
+    {
+        return generation_.load(std::memory_order_relaxed);
+    }
+
+    //! If `outcome` is given, it is set to why the probe did or did not find an entry
+    std::optional<TranspositionEntry> probe(const std::uint64_t key, ProbeOutcome* outcome = nullptr) const
+    {
+        const Bucket& bucket{ buckets_[key & bucket_mask_] };
+        bool bucket_full{ true };
+        for (const Slot& slot : bucket.slots)
+        {
+            const std::uint64_t data{ slot.data.load(std::memory_order_relaxed) };
+            const std::uint64_t checked_key{ slot.checked_key.load(std::memory_order_relaxed) };
+            if ((data != 0) && ((checked_key ^ data) == key))
+            {
+                if (outcome != nullptr)
+                {
+                    *outcome = ProbeOutcome::kHit;
+                }
+                return unpack(key, data);
+            }
+
+            bucket_full = bucket_full && (data != 0);
+        }
+
+        if (outcome != nullptr)
+        {
+            *outcome = bucket_full ? ProbeOutcome::kCollision : ProbeOutcome::kMiss;
+        }
+        return std::nullopt;
+    }
+
+    void store(const std::uint64_t key, const int value, const Bound bound, const std::uint8_t best_pit_index, const std::uint8_t depth,
+               const std::uint8_t draft = kFullDraft)
+    {
+        const std::uint8_t generation{ getGeneration() };
+        const TranspositionEntry new_entry{ key, static_cast<std::int16_t>(value), bound, best_pit_index, depth, draft, generation };
+
+        Bucket& bucket{ buckets_[key & bucket_mask_] };
+        Slot& depth_preferred_slot{ bucket.slots[0] };
+        Slot& always_replace_slot{ bucket.slots[1] };
+
+        // Reads of the other slots may race with concurrent stores. That only affects which slot gets replaced.
+        const std::optional<TranspositionEntry> depth_preferred_entry{ load(depth_preferred_slot) };
+        const std::optional<TranspositionEntry> always_replace_entry{ load(always_replace_slot) };
+        if (!depth_preferred_entry.has_value() || (depth_preferred_entry->key == key))
+        {
+            write(depth_preferred_slot, new_entry);
+        }
+        else if (always_replace_entry.has_value() && (always_replace_entry->key == key))
+        {
+            write(always_replace_slot, new_entry);
+        }
+        else if ((depth >= depth_preferred_entry->depth) || (depth_preferred_entry->generation != generation))
+        {
+            // Demote the previous depth-preferred entry rather than dropping it
+            write(always_replace_slot, depth_preferred_entry.value());
+            write(depth_preferred_slot, new_entry);
+        }
+        else
+        {
+            write(always_replace_slot, new_entry);
+        }
+    }
+
+    //! Not safe to call while other threads are using the table
+    void clear()
+    {
+        for (std::size_t i = 0; i < num_buckets_; ++i)
+        {
+            for (Slot& slot : buckets_[i].slots)
+            {
+                slot.checked_key.store(0, std::memory_order_relaxed);
+                slot.data.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //! Writes every stored entry and the generation to `output`. Not safe to call while other threads store entries.
+    //! Throws `std::runtime_error` if the stream fails.
+    void save(std::ostream& output) const;
+
+    //! Replaces the contents of the table with the entries written by `save()`, which may come from a table of another
+    //! size. Entries that do not fit in their bucket are dropped. Throws `std::runtime_error` if the input is not a saved
+    //! table or ends early. Not safe to call while other threads are using the table.
+    void load(std::istream& input);
+
+    std::size_t getNumEntries() const
+    {
+        return 2 * num_buckets_;
+    }
+
+    std::size_t getSizeBytes() const
+    {
+        return num_buckets_ * sizeof(Bucket);
+    }
+
+    PageBacking getPageBacking() const
+    {
+        return page_backing_;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::uint64_t> checked_key;
+        std::atomic<std::uint64_t> data;
+    };
+
+    struct Bucket
+    {
+        std::array<Slot, 2> slots;
+    };
+
+    //! Layout of `Slot::data`: value (bits 0-15), bound (16-23), best pit index (24-31), depth (32-39), draft (40-47),
+    //! generation (48-55).
+    //! A zero word is an empty slot, which `Bound::kNone` guarantees never collides with a stored entry.
+    static std::uint64_t pack(const TranspositionEntry& entry)
+    {
+        return static_cast<std::uint64_t>(static_cast<std::uint16_t>(entry.value)) |
+               (static_cast<std::uint64_t>(entry.bound) << 16) |
+               (static_cast<std::uint64_t>(entry.best_pit_index) << 24) |
+               (static_cast<std::uint64_t>(entry.depth) << 32) |
+               (static_cast<std::uint64_t>(entry.draft) << 40) |
+               (static_cast<std::uint64_t>(entry.generation) << 48);
+    }
+
+    static TranspositionEntry unpack(const std::uint64_t key, const std::uint64_t data)
+    {
+        TranspositionEntry entry{};
+        entry.key = key;
+        entry.value = static_cast<std::int16_t>(static_cast<std::uint16_t>(data & 0xffff));
+        entry.bound = static_cast<Bound>((data >> 16) & 0xff);
+        entry.best_pit_index = static_cast<std::uint8_t>((data >> 24) & 0xff);
+        entry.depth = static_cast<std::uint8_t>((data >> 32) & 0xff);
+        entry.draft = static_cast<std::uint8_t>((data >> 40) & 0xff);
+        entry.generation = static_cast<std::uint8_t>((data >> 48) & 0xff);
+
+        return entry;
+    }
+
+    static std::optional<TranspositionEntry> load(const Slot& slot)
+    {
+        const std::uint64_t data{ slot.data.load(std::memory_order_relaxed) };
+        if (data == 0)
+        {
+            return std::nullopt;
+        }
+
+        return unpack(slot.checked_key.load(std::memory_order_relaxed) ^ data, data);
+    }
+
+    static void write(Slot& slot, const TranspositionEntry& entry)
+    {
+        const std::uint64_t data{ pack(entry) };
+        slot.checked_key.store(entry.key ^ data, std::memory_order_relaxed);
+        slot.data.store(data, std::memory_order_relaxed);
+    }
+
+    static std::size_t getNumBuckets(const std::size_t size_bytes)
+    {
+        std::size_t num_buckets{ 1 };
+        while ((2 * num_buckets * sizeof(Bucket)) <= size_bytes)
+        {
+            num_buckets *= 2;
+        }
+
+        return num_buckets;
+    }
+
+    std::size_t num_buckets_;
+    //! Size of the mapping backing `buckets_`, which may be rounded up to a whole number of huge pages
+    std::size_t mapping_size_bytes_;
+    PageBacking page_backing_;
+    Bucket* buckets_;
+    std::size_t bucket_mask_;
+    std::atomic<std::uint8_t> generation_{ 0 };
+};
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+//! Pool of workers with one task deque each. Workers push and pop their own tasks LIFO and steal from the front of
+//! other workers' deques when their own is empty. Worker `0` is the thread that owns the pool; it does not get a
+//! dedicated thread and instead runs tasks through `runPendingTask()` when it would otherwise be waiting.
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void(std::size_t worker_index)>;
+
+    explicit WorkStealingPool(const std::size_t num_workers)
+    {
+        const std::size_t num_queues{ (num_workers == 0) ? 1 : num_workers };
+        for (std::size_t i = 0; i < num_queues; ++i)
+        {
+            queues_.push_back(std::make_unique<WorkerQueue>());
+        }
+
+        for (std::size_t i = 1; i < num_queues; ++i)
+        {
+            threads_.emplace_back([this, i]() { runWorker(i); });
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ idle_mutex_ };
+            stop_ = true;
+        }
+        idle_condition_.notify_all();
+
+        for (std::thread& thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+    std::size_t getNumWorkers() const
+    {
+        return queues_.size();
+    }
+
+    void push(const std::size_t worker_index, Task task)
+    {
+        // Counted before the task becomes visible so the count never drops below the number of queued tasks
+        {
+            std::lock_guard<std::mutex> lock{ idle_mutex_ };
+            ++num_queued_tasks_;
+        }
+
+        {
+            WorkerQueue& queue{ *queues_.at(worker_index) };
+            std::lock_guard<std::mutex> lock{ queue.mutex };
+            queue.tasks.push_back(std::move(task));
+        }
+        idle_condition_.notify_one();
+    }
+
+    //! Runs one pending task on the calling worker, taking the most recently pushed task from its own deque or else the
+    //! oldest task of another worker. Returns false if there was nothing to run.
+    bool runPendingTask(const std::size_t worker_index)
+    {
+        std::optional<Task> task{ popTask(worker_index) };
+        for (std::size_t n = 1; !task.has_value() && (n < queues_.size()); ++n)
+        {
+            task = stealTask((worker_index + n) % queues_.size());
+        }
+
+        if (!task.has_value())
+        {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{ idle_mutex_ };
+            --num_queued_tasks_;
+        }
+
+        (*task)(worker_index);
+        return true;
+    }
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::optional<Task> popTask(const std::size_t worker_index)
+    {
+        WorkerQueue& queue{ *queues_[worker_index] };
+        std::lock_guard<std::mutex> lock{ queue.mutex };
+        if (queue.tasks.empty())
+        {
+            return std::nullopt;
+        }
+
+        Task task{ std::move(queue.tasks.back()) };
+        queue.tasks.pop_back();
+        return task;
+    }
+
+    std::optional<Task> stealTask(const std::size_t victim_index)
+    {
+        WorkerQueue& queue{ *queues_[victim_index] };
+        std::lock_guard<std::mutex> lock{ queue.mutex };
+        if (queue.tasks.empty())
+        {
+            return std::nullopt;
+        }
+
+        Task task{ std::move(queue.tasks.front()) };
+        queue.tasks.pop_front();
+        return task;
+    }
+
+    void runWorker(const std::size_t worker_index)
+    {
+        while (true)
+        {
+            if (runPendingTask(worker_index))
+            {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock{ idle_mutex_ };
+            idle_condition_.wait(lock, [this]() { return stop_ || (num_queued_tasks_ > 0); });
+            if (stop_)
+            {
+                return;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+
+    //! Guards `num_queued_tasks_` and `stop_` so idle workers can sleep instead of spinning
+    std::mutex idle_mutex_;
+    std::condition_variable idle_condition_;
+    std::size_t num_queued_tasks_{ 0 };
+    bool stop_{ false };
+};
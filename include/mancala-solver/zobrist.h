@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <board_state.h>
+
+//! Computes Zobrist keys for positions, i.e. the XOR of one pseudo-random key per (pit or bank, stone count) pair plus
+//! a key for the active player. The keys are generated from a fixed seed so hashes are reproducible across runs.
+//!
+//! Caches and databases key on the canonical form of a position (see `BoardState::getCanonical()`) with
+//! `hashCanonical()` or `hashPits()`, so a position and its mirror with the other player to move share one entry.
+class ZobristHasher
+{
+public:
+    static std::uint64_t hash(const BoardState& board_state, const std::size_t active_player_index)
+    {
+        const Keys& keys{ getKeys() };
+
+        std::uint64_t key{ (active_player_index == 0) ? 0 : keys.active_player_1 };
+        key ^= hashSinglePlayerBoardState(board_state.getPlayer0BoardState(), keys.player_0_cells);
+        key ^= hashSinglePlayerBoardState(board_state.getPlayer1BoardState(), keys.player_1_cells);
+
+        return key;
+    }
+
+    //! Same as `hash(board_state.getCanonical(active_player_index), 0)`, without building the canonical board
+    static std::uint64_t hashCanonical(const BoardState& board_state, const std::size_t active_player_index)
+    {
+        const Keys& keys{ getKeys() };
+
+        return hashSinglePlayerBoardState(getActivePlayerBoardState(board_state, active_player_index), keys.player_0_cells) ^
+               hashSinglePlayerBoardState(getOpposingPlayerBoardState(board_state, active_player_index), keys.player_1_cells);
+    }
+
+    //! Same as `hashCanonical()` but ignores the banks. Positions that differ only in their banks have the same future,
+    //! so this lets searches that store values relative to the current banks share entries between them.
+    static std::uint64_t hashPits(const BoardState& board_state, const std::size_t active_player_index)
+    {
+        const Keys& keys{ getKeys() };
+
+        return hashPitsOnly(getActivePlayerBoardState(board_state, active_player_index), keys.player_0_cells) ^
+               hashPitsOnly(getOpposingPlayerBoardState(board_state, active_player_index), keys.player_1_cells);
+    }
+
+private:
+    //! One row of keys per pit, followed by one for the bank
+    using CellKeys = std::array<std::array<std::uint64_t, kMaxNumStones + 1>, kMaxNumPits + 1>;
+
+    struct Keys
+    {
+        CellKeys player_0_cells;
+        CellKeys player_1_cells;
+        std::uint64_t active_player_1;
+    };
+
+    static const SinglePlayerBoardState& getActivePlayerBoardState(const BoardState& board_state, const std::size_t active_player_index)
+    {
+        return (active_player_index == 0) ? board_state.getPlayer0BoardState() : board_state.getPlayer1BoardState();
+    }
+
+    static const SinglePlayerBoardState& getOpposingPlayerBoardState(const BoardState& board_state, const std::size_t active_player_index)
+    {
+        return (active_player_index == 0) ? board_state.getPlayer1BoardState() : board_state.getPlayer0BoardState();
+    }
+
+    static std::uint64_t hashSinglePlayerBoardState(const SinglePlayerBoardState& single_player_board_state,
+                                                    const CellKeys& cell_keys)
+    {
+        return cell_keys[kMaxNumPits][single_player_board_state.getNumStonesInBank()] ^
+               hashPitsOnly(single_player_board_state, cell_keys);
+    }
+
+    static std::uint64_t hashPitsOnly(const SinglePlayerBoardState& single_player_board_state, const CellKeys& cell_keys)
+    {
+        std::uint64_t key{ 0 };
+        for (std::size_t i = 0; i < single_player_board_state.getNumPits(); ++i)
+        {
+            key ^= cell_keys[i][single_player_board_state.getNumStonesInPitUnchecked(i)];
+        }
+
+        return key;
+    }
+
+    static const Keys& getKeys()
+    {
+        static const Keys keys{ makeKeys() };
+        return keys;
+    }
+
+    static Keys makeKeys()
+    {
+        // splitmix64, which is enough to give well-distributed, independent keys
+        std::uint64_t state{ 0x6d616e63616c6121 };
+        const auto next_key = [&state]()
+        {
+            state += 0x9e3779b97f4a7c15;
+            std::uint64_t z{ state };
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            return z ^ (z >> 31);
+        };
+
+        Keys keys{};
+        for (CellKeys* cell_keys : { &keys.player_0_cells, &keys.player_1_cells })
+        {
+            for (auto& cell : *cell_keys)
+            {
+                for (std::uint64_t& key : cell)
+                {
+                    key = next_key();
+                }
+            }
+        }
+        keys.active_player_1 = next_key();
+
+        return keys;
+    }
+};
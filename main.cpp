@@ -1,10 +1,32 @@
+#include <chrono>
+#include <csignal>
+#include <fstream>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <optional>
+#include <string>
+#include <thread>
 
+#include <pthread.h>
+
+#include <batch_analyzer.h>
+#include <binary_records.h>
 #include <board_state.h>
+#include <distributed_solver.h>
+#include <endgame_tablebase.h>
 #include <game_mechanics.h>
+#include <game_tree_statistics.h>
+#include <negamax_solver.h>
+#include <opening_book.h>
+#include <perft.h>
+#include <position_text.h>
+#include <preset_positions.h>
+#include <proof_number_solver.h>
+#include <retrograde_solver.h>
+#include <self_play.h>
 #include <solver.h>
+#include <solver_server.h>
 
 // Board layout (pit indices for each player are specified within the `( )` markings)
 //
@@ -54,18 +76,6 @@
 // ...
 
 
-BoardState makeDefaultBoardState()
-{
-    return BoardState{ /*player_0_board_state*/ SinglePlayerBoardState{ std::vector<int>{ 4, 4, 4, 4, 4, 4 }, 0 }, 
-                       /*player_1_board_state*/ SinglePlayerBoardState{ std::vector<int>{ 4, 4, 4, 4, 4, 4 }, 0 }};
-}
-
-BoardState makeTestBoardState()
-{
-    return BoardState{ /*player_0_board_state*/ SinglePlayerBoardState{ std::vector<int>{ 0, 0, 3, 2, 1, 1 }, 0 },
-                       /*player_1_board_state*/ SinglePlayerBoardState{ std::vector<int>{ 7, 0, 0, 0, 2, 1 }, 0 }};
-}
-
 void printBoardForPlayer(const BoardState& board_state, const std::size_t player_index)
 {
     if (player_index == 0)
@@ -88,8 +98,8 @@ void playManualGame(BoardState board_state, GameMechanicsExecutor game_mechanics
 
         const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
 
-        // Good to do this after calling `getWinnerPlayerIndex()` because that is responsible
-        // for cleaning up the board after it finishes.
+        // Sweep the remaining stones into the banks before printing a finished game
+        game_mechanics_executor.finalize(board_state);
         printBoardForPlayer(board_state, active_player_index);
         std::cout << std::endl;
         std::cout << "Active player: " << active_player_index << std::endl;
@@ -147,8 +157,797 @@ void playManualGame(BoardState board_state, GameMechanicsExecutor game_mechanics
     }
 }
 
+//! Transposition table configuration for every command, set with the global options
+struct TranspositionTableSettings
+{
+    std::size_t size_bytes{ kDefaultTranspositionTableSizeBytes };
+    bool use_huge_pages{ false };
+};
+
+void printUsage(const std::string& program_name)
+{
+    std::cout << "Usage:" << std::endl;
+    std::cout << "  " << program_name << " [--tt-size-mb=<n>] [--huge-pages] [<command> ...]" << std::endl;
+    std::cout << "      Global options, given before the command: the size of each transposition table in MiB (default "
+              << (kDefaultTranspositionTableSizeBytes >> 20) << ")" << std::endl;
+    std::cout << "      and whether to back the tables with huge pages." << std::endl;
+    std::cout << "  " << program_name << std::endl;
+    std::cout << "      Runs the built-in solver examples." << std::endl;
+    std::cout << "  " << program_name << " generate-tablebase <num_pits> <max_stones> <output_path>" << std::endl;
+    std::cout << "      Solves every position with at most `max_stones` stones in the pits and writes the endgame tablebase." << std::endl;
+    std::cout << "  " << program_name << " build-opening-book <num_pits> <num_stones_per_pit> <num_plies> <output_path> [num_threads]" << std::endl;
+    std::cout << "      Solves every position reachable in up to `num_plies` turns from the starting board and writes the opening book." << std::endl;
+    std::cout << "  " << program_name << " analyze <text|binary> <input_path|-> [num_threads] [time_limit_ms]" << std::endl;
+    std::cout << "      Solves every position in the input (`-` for stdin) and writes the results to stdout as they complete." << std::endl;
+    std::cout << "  " << program_name << " serve <tcp|unix> <port|socket_path> [--workers=<n>] [--host=<ipv4_address>]" << std::endl;
+    std::cout << "                [--opening-book=<path>] [--tablebase=<path>]" << std::endl;
+    std::cout << "      Answers solve requests over a socket, keeping the transposition table, book and tablebase resident." << std::endl;
+    std::cout << "  " << program_name << " solve-retrograde <num_pits> <num_stones_per_pit> <directory> [max_buffered_positions]" << std::endl;
+    std::cout << "      Solves every position reachable from the starting board by retrograde analysis on disk and writes the database" << std::endl;
+    std::cout << "      to `directory`." << std::endl;
+    std::cout << "  " << program_name << " self-play <num_games> <random|greedy|solver> <random|greedy|solver> [--threads=<n>]" << std::endl;
+    std::cout << "                [--pits=<n>] [--stones=<n>] [--seed=<n>] [--move-time-ms=<n>] [--log=<path>]" << std::endl;
+    std::cout << "      Plays games between the policies of player 0 and player 1 and reports games/s, moves/s and solver move" << std::endl;
+    std::cout << "      latency. `--move-time-ms=0` solves every solver move exactly. `--log` writes the games to a game log." << std::endl;
+    std::cout << "  " << program_name << " replay-games <log_path> <output_path|->" << std::endl;
+    std::cout << "      Writes the position before every move in a game log as binary input for `analyze` (`-` for stdout)." << std::endl;
+    std::cout << "  " << program_name << " convert-positions <input_path|-> <output_path|->" << std::endl;
+    std::cout << "      Converts text positions, one per line as for `analyze text`, to binary input for `analyze`." << std::endl;
+    std::cout << "  " << program_name << " solve-distributed <num_pits> <num_stones_per_pit> <split_ply> <checkpoint_path>" << std::endl;
+    std::cout << "                <tcp:<ipv4_address>:<port>|unix:<socket_path>>... [--connections=<n>] [--response-timeout-ms=<n>]" << std::endl;
+    std::cout << "      Solves the starting board on `serve` workers, one job per distinct position after `split_ply` turns. Solved jobs" << std::endl;
+    std::cout << "      are appended to the checkpoint, and a restarted solve only sends the jobs that are not in it. A job not answered" << std::endl;
+    std::cout << "      within `--response-timeout-ms` is sent to another connection." << std::endl;
+    std::cout << "  " << program_name << " solve <num_pits> <num_stones_per_pit> [--checkpoint=<path>] [--checkpoint-interval-s=<n>] [--resume]" << std::endl;
+    std::cout << "                [--statistics-threads=<n>] [--threads=<n>] [--tablebase=<path>] [--opening-book=<path>]" << std::endl;
+    std::cout << "      Searches the starting board for a guaranteed win. `--checkpoint` snapshots the progress every" << std::endl;
+    std::cout << "      `--checkpoint-interval-s` seconds (default 600), and `--resume` continues from the snapshot." << std::endl;
+    std::cout << "      `--statistics-threads` picks the move with the most won and drawn games if there is no guaranteed win." << std::endl;
+    std::cout << "      `--threads` searches the root moves in parallel." << std::endl;
+    std::cout << "      `--tablebase` and `--opening-book` settle positions from an endgame tablebase and an opening book." << std::endl;
+    std::cout << "  " << program_name << " solve-variant <num_pits> <num_stones_per_pit> [--threads=<n>] [--verify]" << std::endl;
+    std::cout << "      Solves the starting board for the exact final bank differential under the ruleset with every Kalah rule" << std::endl;
+    std::cout << "      flipped. `--verify` cross-checks the solver against a brute force search of the whole game tree instead." << std::endl;
+    std::cout << "  " << program_name << " count-games <num_pits> <num_stones_per_pit> [num_threads]" << std::endl;
+    std::cout << "      Counts the won, drawn and lost games after each move from the starting board over the full game tree." << std::endl;
+    std::cout << "  " << program_name << " perft <full|bulk|verify|verify-variant> <depth> [num_threads]" << std::endl;
+    std::cout << "      Counts the positions reachable from the default board in up to `depth` turns. `full` also counts unique" << std::endl;
+    std::cout << "      and finished positions, `bulk` only counts positions (in parallel with `num_threads`) and `verify`" << std::endl;
+    std::cout << "      cross-checks the sowing kernels against the reference implementation. `verify-variant` does the same" << std::endl;
+    std::cout << "      under a ruleset with every Kalah rule flipped." << std::endl;
+}
+
+int generateTablebase(const std::size_t num_pits, const int max_stones, const std::string& output_path)
+{
+    const auto start_time{ std::chrono::steady_clock::now() };
+    const EndgameTablebase tablebase{ EndgameTablebase::generate(num_pits, max_stones) };
+    tablebase.save(output_path);
+
+    const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start_time };
+    std::cout << "Wrote endgame tablebase for " << num_pits << " pits and up to " << max_stones << " stones to `"
+              << output_path << "` in " << elapsed.count() << " s" << std::endl;
+
+    return 0;
+}
+
+int buildOpeningBook(const std::size_t num_pits, const int num_stones_per_pit, const std::size_t num_plies,
+                     const std::string& output_path, const std::size_t num_threads, const TranspositionTableSettings& settings)
+{
+    const BoardState board_state{ num_pits, num_stones_per_pit };
+    const GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, /*starting_player_index*/ 0 };
+
+    const auto start_time{ std::chrono::steady_clock::now() };
+    const OpeningBook book{ OpeningBook::build(board_state, game_mechanics_executor, num_plies, num_threads, settings.size_bytes) };
+    book.save(output_path);
+
+    const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start_time };
+    std::cout << "Wrote opening book with " << book.getNumEntries() << " positions up to " << num_plies << " turns to `"
+              << output_path << "` in " << elapsed.count() << " s" << std::endl;
+
+    return 0;
+}
+
+int solveRetrograde(const std::size_t num_pits, const int num_stones_per_pit, const std::string& directory,
+                    const std::optional<std::size_t> max_buffered_positions)
+{
+    const BoardState board_state{ num_pits, num_stones_per_pit };
+
+    RetrogradeOptions options{};
+    if (max_buffered_positions.has_value())
+    {
+        options.max_buffered_positions = max_buffered_positions.value();
+    }
+
+    const auto start_time{ std::chrono::steady_clock::now() };
+    const RetrogradeDatabase database{ RetrogradeDatabase::solve(board_state, /*active_player_index*/ 0, directory, options) };
+    const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start_time };
+
+    for (int s = database.getMaxStones(); s > 0; --s)
+    {
+        if (database.getNumPositions(s) > 0)
+        {
+            std::cout << s << " stones: " << database.getNumPositions(s) << " positions" << std::endl;
+        }
+    }
+    std::cout << "Wrote retrograde database with " << database.getNumPositions() << " positions to `" << directory << "` in "
+              << elapsed.count() << " s" << std::endl;
+    std::cout << "Final bank differential of the starting position: " << database.probe(board_state, 0).value() << std::endl;
+
+    return 0;
+}
+
+int analyzePositions(const std::string& format_name, const std::string& input_path, const std::size_t num_threads,
+                     const std::optional<std::chrono::milliseconds> time_limit_per_position,
+                     const TranspositionTableSettings& settings)
+{
+    BatchFormat format{};
+    if (format_name == "text")
+    {
+        format = BatchFormat::kText;
+    }
+    else if (format_name == "binary")
+    {
+        format = BatchFormat::kBinary;
+    }
+    else
+    {
+        throw std::invalid_argument("Unknown batch format `" + format_name + "`");
+    }
+
+    std::ifstream input_file{};
+    if (input_path != "-")
+    {
+        input_file.open(input_path, std::ios::binary);
+        if (!input_file)
+        {
+            throw std::runtime_error("Could not open `" + input_path + "`");
+        }
+    }
+
+    BatchAnalyzerOptions options{};
+    options.num_threads = num_threads;
+    options.time_limit_per_position = time_limit_per_position;
+    options.transposition_table_size_bytes = settings.size_bytes;
+    options.use_huge_pages = settings.use_huge_pages;
+
+    const BatchAnalyzer analyzer{ options };
+    const BatchSummary summary{ analyzer.run((input_path == "-") ? std::cin : input_file, std::cout, format) };
+
+    // Results go to stdout, so the summary goes to stderr
+    std::cerr << "Analyzed " << summary.num_positions << " positions (" << summary.num_invalid_positions << " invalid) in "
+              << summary.elapsed.count() << " s" << std::endl;
+
+    return 0;
+}
+
+int serve(const std::vector<std::string>& args, const TranspositionTableSettings& settings)
+{
+    const std::string& transport{ args[2] };
+    const std::string& address{ args[3] };
+
+    SolverServerOptions options{};
+    options.transposition_table_size_bytes = settings.size_bytes;
+    options.use_huge_pages = settings.use_huge_pages;
+    std::string host{ "127.0.0.1" };
+    std::optional<OpeningBook> opening_book{};
+    std::optional<EndgameTablebase> endgame_tablebase{};
+    for (std::size_t i = 4; i < args.size(); ++i)
+    {
+        const std::string& arg{ args[i] };
+        const std::size_t value_begin{ arg.find('=') + 1 };
+        const std::string name{ arg.substr(0, value_begin) };
+        const std::string value{ arg.substr(value_begin) };
+        if (name == "--workers=")
+        {
+            options.num_workers = std::stoul(value);
+        }
+        else if (name == "--host=")
+        {
+            host = value;
+        }
+        else if (name == "--opening-book=")
+        {
+            opening_book = OpeningBook::load(value);
+            options.opening_book = &opening_book.value();
+        }
+        else if (name == "--tablebase=")
+        {
+            endgame_tablebase = EndgameTablebase::load(value);
+            options.endgame_tablebase = &endgame_tablebase.value();
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option `" + arg + "`");
+        }
+    }
+
+    // Block the termination signals in every thread and wait for them on a dedicated one, so that they stop the server
+    // cleanly (removing the Unix socket file) instead of killing the process
+    sigset_t termination_signals{};
+    sigemptyset(&termination_signals);
+    sigaddset(&termination_signals, SIGINT);
+    sigaddset(&termination_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &termination_signals, nullptr);
+
+    SolverServer server{ options };
+    std::thread signal_thread{ [&]()
+    {
+        int signal_number{ 0 };
+        sigwait(&termination_signals, &signal_number);
+        server.stop();
+    } };
+    const auto stopSignalThread{ [&]()
+    {
+        pthread_kill(signal_thread.native_handle(), SIGTERM);
+        signal_thread.join();
+    } };
+
+    try
+    {
+        if (transport == "tcp")
+        {
+            const unsigned long port{ std::stoul(address) };
+            if (port > std::numeric_limits<std::uint16_t>::max())
+            {
+                throw std::invalid_argument("Port " + address + " is out of range");
+            }
+
+            std::cout << "Listening on " << host << ":" << port << std::endl;
+            server.serveTcp(host, static_cast<std::uint16_t>(port));
+        }
+        else if (transport == "unix")
+        {
+            std::cout << "Listening on `" << address << "`" << std::endl;
+            server.serveUnix(address);
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown transport `" + transport + "`");
+        }
+    }
+    catch (...)
+    {
+        stopSignalThread();
+        throw;
+    }
+    stopSignalThread();
+
+    std::cout << "Server stopped" << std::endl;
+    return 0;
+}
+
+int selfPlay(const std::vector<std::string>& args, const TranspositionTableSettings& settings)
+{
+    SelfPlayOptions options{};
+    options.num_games = std::stoul(args[2]);
+    options.policies = { parseSelfPlayPolicy(args[3]), parseSelfPlayPolicy(args[4]) };
+    options.transposition_table_size_bytes = settings.size_bytes;
+    options.use_huge_pages = settings.use_huge_pages;
+    std::optional<std::string> log_path{};
+    for (std::size_t i = 5; i < args.size(); ++i)
+    {
+        const std::string& arg{ args[i] };
+        const std::size_t value_begin{ arg.find('=') + 1 };
+        const std::string name{ arg.substr(0, value_begin) };
+        const std::string value{ arg.substr(value_begin) };
+        if (name == "--threads=")
+        {
+            options.num_threads = std::stoul(value);
+        }
+        else if (name == "--pits=")
+        {
+            options.num_pits = std::stoul(value);
+        }
+        else if (name == "--stones=")
+        {
+            options.num_stones_per_pit = std::stoi(value);
+        }
+        else if (name == "--seed=")
+        {
+            options.seed = std::stoull(value);
+        }
+        else if (name == "--move-time-ms=")
+        {
+            const long move_time_ms{ std::stol(value) };
+            options.solver_time_limit_per_move =
+                (move_time_ms > 0) ? std::optional<std::chrono::milliseconds>{ move_time_ms } : std::nullopt;
+        }
+        else if (name == "--log=")
+        {
+            log_path = value;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option `" + arg + "`");
+        }
+    }
+
+    const SelfPlay self_play{ options };
+    std::ofstream log_file{};
+    std::optional<GameLogWriter> game_log{};
+    if (log_path.has_value())
+    {
+        log_file.open(log_path.value(), std::ios::binary | std::ios::trunc);
+        if (!log_file)
+        {
+            throw std::runtime_error("Could not open `" + log_path.value() + "` for writing");
+        }
+        game_log.emplace(log_file, options.num_pits, options.num_stones_per_pit);
+    }
+
+    const SelfPlaySummary summary{ self_play.run(game_log.has_value() ? &game_log.value() : nullptr) };
+
+    std::cout << "Played " << summary.num_games << " games with " << summary.num_moves << " moves in " << summary.elapsed.count()
+              << " s (" << summary.getGamesPerSecond() << " games/s, " << summary.getMovesPerSecond() << " moves/s)" << std::endl;
+    std::cout << "Player 0 won " << summary.num_results[0] << ", player 1 won " << summary.num_results[1] << ", "
+              << summary.num_results[2] << " drawn" << std::endl;
+    if (summary.num_solver_moves > 0)
+    {
+        std::cout << "Solver moves: " << summary.num_solver_moves << ", mean "
+                  << (1000.0 * summary.total_solver_time.count() / static_cast<double>(summary.num_solver_moves)) << " ms, max "
+                  << (1000.0 * summary.max_solver_time.count()) << " ms" << std::endl;
+    }
+
+    return 0;
+}
+
+int replayGames(const std::string& log_path, const std::string& output_path)
+{
+    std::ifstream log_file{ log_path, std::ios::binary };
+    if (!log_file)
+    {
+        throw std::runtime_error("Could not open `" + log_path + "`");
+    }
+
+    std::ofstream output_file{};
+    if (output_path != "-")
+    {
+        output_file.open(output_path, std::ios::binary | std::ios::trunc);
+        if (!output_file)
+        {
+            throw std::runtime_error("Could not open `" + output_path + "` for writing");
+        }
+    }
+    GameLogReader reader{ log_file };
+    RecordWriter<PositionRecord> writer{ (output_path == "-") ? std::cout : output_file };
+    GameRecord game_record{};
+    std::uint64_t num_games{ 0 };
+    std::uint64_t num_positions{ 0 };
+    while (reader.read(game_record))
+    {
+        for (const Position& position : reader.replay(game_record))
+        {
+            writer.write(makePositionRecord(position));
+            ++num_positions;
+        }
+        ++num_games;
+    }
+    writer.flush();
+
+    // Positions may go to stdout, so the summary goes to stderr
+    std::cerr << "Replayed " << num_positions << " positions from " << num_games << " games" << std::endl;
+
+    return 0;
+}
+
+int convertPositions(const std::string& input_path, const std::string& output_path)
+{
+    std::ifstream input_file{};
+    if (input_path != "-")
+    {
+        input_file.open(input_path);
+        if (!input_file)
+        {
+            throw std::runtime_error("Could not open `" + input_path + "`");
+        }
+    }
+
+    std::ofstream output_file{};
+    if (output_path != "-")
+    {
+        output_file.open(output_path, std::ios::binary | std::ios::trunc);
+        if (!output_file)
+        {
+            throw std::runtime_error("Could not open `" + output_path + "` for writing");
+        }
+    }
+
+    std::istream& input{ (input_path == "-") ? std::cin : input_file };
+    RecordWriter<PositionRecord> writer{ (output_path == "-") ? std::cout : output_file };
+    std::string line{};
+    std::uint64_t line_number{ 0 };
+    std::uint64_t num_positions{ 0 };
+    while (std::getline(input, line))
+    {
+        ++line_number;
+        const std::size_t first_char{ line.find_first_not_of(" \t\r") };
+        if ((first_char == std::string::npos) || (line[first_char] == '#'))
+        {
+            continue;
+        }
+
+        try
+        {
+            writer.write(makePositionRecord(parseTextPosition(line)));
+        }
+        catch (const std::invalid_argument& e)
+        {
+            throw std::invalid_argument("Line " + std::to_string(line_number) + ": " + e.what());
+        }
+        ++num_positions;
+    }
+    writer.flush();
+
+    std::cerr << "Converted " << num_positions << " positions" << std::endl;
+
+    return 0;
+}
+
+int solveDistributed(const std::vector<std::string>& args)
+{
+    const BoardState board_state{ std::stoul(args[2]), std::stoi(args[3]) };
+    const GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, /*starting_player_index*/ 0 };
+
+    DistributedSolverOptions options{};
+    options.split_ply = std::stoul(args[4]);
+    options.checkpoint_path = args[5];
+    const std::string connections_option{ "--connections=" };
+    const std::string response_timeout_option{ "--response-timeout-ms=" };
+    for (std::size_t i = 6; i < args.size(); ++i)
+    {
+        if (args[i].rfind(connections_option, 0) == 0)
+        {
+            options.connections_per_worker = std::stoul(args[i].substr(connections_option.size()));
+        }
+        else if (args[i].rfind(response_timeout_option, 0) == 0)
+        {
+            options.response_timeout = std::chrono::milliseconds{ std::stol(args[i].substr(response_timeout_option.size())) };
+        }
+        else
+        {
+            options.worker_addresses.push_back(args[i]);
+        }
+    }
+
+    const auto start_time{ std::chrono::steady_clock::now() };
+    const DistributedSolver solver{ options };
+    const DistributedSolveResult result{ solver.solve(board_state, game_mechanics_executor) };
+    const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start_time };
+
+    std::cout << result.num_frontier_positions << " positions after " << options.split_ply << " turns, " << result.num_jobs
+              << " jobs (" << result.num_checkpointed_jobs << " from the checkpoint, " << result.num_retried_jobs << " retried)"
+              << std::endl;
+    std::cout << "Best pit index: " << (result.best_pit_index.has_value() ? std::to_string(result.best_pit_index.value()) : "-")
+              << std::endl;
+    std::cout << "Final bank differential: " << result.value << " (" << elapsed.count() << " s)" << std::endl;
+
+    return 0;
+}
+
+int solveStartingBoard(const std::vector<std::string>& args, const TranspositionTableSettings& settings)
+{
+    const BoardState board_state{ std::stoul(args[2]), std::stoi(args[3]) };
+    const GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, /*starting_player_index*/ 0 };
+
+    SolverCheckpointSettings checkpoint_settings{};
+    std::optional<std::size_t> statistics_num_threads{};
+    std::size_t num_threads{ 1 };
+    std::optional<EndgameTablebase> endgame_tablebase{};
+    std::optional<OpeningBook> opening_book{};
+    for (std::size_t i = 4; i < args.size(); ++i)
+    {
+        const std::string& arg{ args[i] };
+        const std::size_t value_begin{ arg.find('=') + 1 };
+        const std::string name{ arg.substr(0, value_begin) };
+        const std::string value{ arg.substr(value_begin) };
+        if (name == "--checkpoint=")
+        {
+            checkpoint_settings.path = value;
+        }
+        else if (name == "--checkpoint-interval-s=")
+        {
+            checkpoint_settings.interval = std::chrono::seconds{ std::stol(value) };
+        }
+        else if (arg == "--resume")
+        {
+            checkpoint_settings.resume = true;
+        }
+        else if (name == "--statistics-threads=")
+        {
+            statistics_num_threads = std::stoul(value);
+        }
+        else if (name == "--threads=")
+        {
+            num_threads = std::stoul(value);
+        }
+        else if (name == "--tablebase=")
+        {
+            endgame_tablebase = EndgameTablebase::load(value);
+        }
+        else if (name == "--opening-book=")
+        {
+            opening_book = OpeningBook::load(value);
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option `" + arg + "`");
+        }
+    }
+    if (checkpoint_settings.path.empty() && checkpoint_settings.resume)
+    {
+        throw std::invalid_argument("`--resume` needs `--checkpoint`");
+    }
+
+    const auto start_time{ std::chrono::steady_clock::now() };
+    Solver solver{ settings.size_bytes, settings.use_huge_pages };
+    if (!checkpoint_settings.path.empty())
+    {
+        solver.setCheckpoint(checkpoint_settings);
+    }
+    solver.setStatisticsThreads(statistics_num_threads);
+    solver.setNumThreads(num_threads);
+    if (endgame_tablebase.has_value())
+    {
+        solver.setEndgameTablebase(&endgame_tablebase.value());
+    }
+    if (opening_book.has_value())
+    {
+        solver.setOpeningBook(&opening_book.value());
+    }
+    const std::pair<std::size_t, bool> solution{ solver.solve(board_state, game_mechanics_executor) };
+    const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start_time };
+
+    std::cout << "Solution pit index: " << solution.first << std::endl;
+    std::cout << "Win guaranteed: " << solution.second << " (" << elapsed.count() << " s)" << std::endl;
+    std::cout << "Search statistics:" << std::endl << solver.getStats() << std::endl;
+
+    return 0;
+}
+
+int solveVariantStartingBoard(const std::vector<std::string>& args, const TranspositionTableSettings& settings)
+{
+    const BoardState board_state{ std::stoul(args[2]), std::stoi(args[3]) };
+    const BasicGameMechanicsExecutor<FlippedKalahRules> game_mechanics_executor{ BasicTurnExecutor<FlippedKalahRules>{} };
+
+    bool verify{ false };
+    std::size_t num_threads{ 1 };
+    for (std::size_t i = 4; i < args.size(); ++i)
+    {
+        const std::string& arg{ args[i] };
+        const std::size_t value_begin{ arg.find('=') + 1 };
+        const std::string name{ arg.substr(0, value_begin) };
+        const std::string value{ arg.substr(value_begin) };
+        if (arg == "--verify")
+        {
+            verify = true;
+        }
+        else if (name == "--threads=")
+        {
+            num_threads = std::stoul(value);
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option `" + arg + "`");
+        }
+    }
+
+    const auto start_time{ std::chrono::steady_clock::now() };
+    if (verify)
+    {
+        const int value{ Perft::verifyRuleVariantSolve(board_state, settings.size_bytes) };
+        const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start_time };
+        std::cout << "Solver agrees with brute force, final bank differential: " << value << " (" << elapsed.count() << " s)"
+                  << std::endl;
+
+        return 0;
+    }
+
+    BasicNegamaxSolver<FlippedKalahRules> solver{ std::make_shared<TranspositionTable>(settings.size_bytes, settings.use_huge_pages),
+                                                  num_threads };
+    const NegamaxResult result{ solver.solve(board_state, game_mechanics_executor) };
+    const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start_time };
+
+    std::cout << "Solution pit index: " << result.best_pit_index.value() << std::endl;
+    std::cout << "Final bank differential: " << result.value << " (" << elapsed.count() << " s)" << std::endl;
+    std::cout << "Principal variation:";
+    for (const std::size_t pit_index : result.principal_variation)
+    {
+        std::cout << " " << pit_index;
+    }
+    std::cout << std::endl;
+
+    return 0;
+}
+
+int countGames(const std::size_t num_pits, const int num_stones_per_pit, const std::size_t num_threads)
+{
+    const BoardState board_state{ num_pits, num_stones_per_pit };
+    const GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, /*starting_player_index*/ 0 };
+
+    const auto start_time{ std::chrono::steady_clock::now() };
+    const GameTreeStatisticsResult result{ GameTreeStatistics::count(board_state, game_mechanics_executor, num_threads) };
+    const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start_time };
+
+    for (std::size_t i = 0; i < result.game_counts_per_pit.size(); ++i)
+    {
+        const GameCounts& counts{ result.game_counts_per_pit[i] };
+        std::cout << "pit " << i << ": " << counts.num_wins << " won, " << counts.num_draws << " drawn, " << counts.num_losses
+                  << " lost" << std::endl;
+    }
+    std::cout << result.num_distinct_positions << " distinct positions in " << elapsed.count() << " s" << std::endl;
+
+    return 0;
+}
+
+int runPerft(const std::string& mode, const std::size_t depth, const std::size_t num_threads)
+{
+    const BoardState board_state{ makeDefaultBoardState() };
+    const GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, /*starting_player_index*/ 0 };
+
+    const auto start_time{ std::chrono::steady_clock::now() };
+    PerftResult result{};
+    if (mode == "full")
+    {
+        result = Perft::run(board_state, game_mechanics_executor, depth);
+    }
+    else if (mode == "bulk")
+    {
+        result = Perft::runBulk(board_state, game_mechanics_executor, depth, num_threads);
+    }
+    else if (mode == "verify")
+    {
+        result = Perft::verify(board_state, game_mechanics_executor, depth);
+    }
+    else if (mode == "verify-variant")
+    {
+        result = Perft::verifyRuleVariant(board_state, depth);
+    }
+    else
+    {
+        throw std::invalid_argument("Unknown perft mode `" + mode + "`");
+    }
+    const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start_time };
+
+    std::uint64_t total_num_positions{ 0 };
+    for (std::size_t ply = 0; ply <= depth; ++ply)
+    {
+        std::cout << "depth " << ply << ": " << result.num_positions[ply] << " positions";
+        if (!result.num_unique_positions.empty())
+        {
+            std::cout << ", " << result.num_unique_positions[ply] << " unique";
+        }
+        if (!result.num_finished_games.empty())
+        {
+            std::cout << ", " << result.num_finished_games[ply] << " finished";
+        }
+        std::cout << std::endl;
+
+        total_num_positions += result.num_positions[ply];
+    }
+    std::cout << total_num_positions << " positions in " << elapsed.count() << " s ("
+              << (static_cast<double>(total_num_positions) / elapsed.count()) << " positions/s)" << std::endl;
+
+    return 0;
+}
+
+//! Removes the global options from the front of `args`, after the program name
+TranspositionTableSettings parseGlobalOptions(std::vector<std::string>& args)
+{
+    TranspositionTableSettings settings{};
+    const std::string size_option{ "--tt-size-mb=" };
+    while ((args.size() > 1) && (args[1].rfind("--", 0) == 0))
+    {
+        if (args[1].rfind(size_option, 0) == 0)
+        {
+            const unsigned long size_mb{ std::stoul(args[1].substr(size_option.size())) };
+            if ((size_mb == 0) || (size_mb > (std::numeric_limits<std::size_t>::max() >> 20)))
+            {
+                throw std::invalid_argument("Transposition table size must be at least 1 MiB");
+            }
+            settings.size_bytes = static_cast<std::size_t>(size_mb) << 20;
+        }
+        else if (args[1] == "--huge-pages")
+        {
+            settings.use_huge_pages = true;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option `" + args[1] + "`");
+        }
+        args.erase(args.begin() + 1);
+    }
+
+    return settings;
+}
+
+//! Runs the command given on the command line. Returns the process exit code.
+int runCommand(const std::vector<std::string>& args, const TranspositionTableSettings& settings)
+{
+    const std::string& command{ args.at(1) };
+    if ((command == "generate-tablebase") && (args.size() == 5))
+    {
+        return generateTablebase(std::stoul(args[2]), std::stoi(args[3]), args[4]);
+    }
+    if ((command == "build-opening-book") && ((args.size() == 6) || (args.size() == 7)))
+    {
+        return buildOpeningBook(std::stoul(args[2]), std::stoi(args[3]), std::stoul(args[4]), args[5],
+                                (args.size() == 7) ? std::stoul(args[6]) : 1, settings);
+    }
+    if ((command == "analyze") && (args.size() >= 4) && (args.size() <= 6))
+    {
+        std::optional<std::chrono::milliseconds> time_limit_per_position{};
+        if (args.size() == 6)
+        {
+            time_limit_per_position = std::chrono::milliseconds{ std::stol(args[5]) };
+        }
+
+        return analyzePositions(args[2], args[3], (args.size() >= 5) ? std::stoul(args[4]) : 1, time_limit_per_position,
+                                settings);
+    }
+    if ((command == "serve") && (args.size() >= 4))
+    {
+        return serve(args, settings);
+    }
+    if ((command == "solve-retrograde") && ((args.size() == 5) || (args.size() == 6)))
+    {
+        return solveRetrograde(std::stoul(args[2]), std::stoi(args[3]), args[4],
+                               (args.size() == 6) ? std::optional<std::size_t>{ std::stoul(args[5]) } : std::nullopt);
+    }
+    if ((command == "self-play") && (args.size() >= 5))
+    {
+        return selfPlay(args, settings);
+    }
+    if ((command == "replay-games") && (args.size() == 4))
+    {
+        return replayGames(args[2], args[3]);
+    }
+    if ((command == "convert-positions") && (args.size() == 4))
+    {
+        return convertPositions(args[2], args[3]);
+    }
+    if ((command == "solve-distributed") && (args.size() >= 7))
+    {
+        return solveDistributed(args);
+    }
+    if ((command == "solve") && (args.size() >= 4))
+    {
+        return solveStartingBoard(args, settings);
+    }
+    if ((command == "solve-variant") && (args.size() >= 4))
+    {
+        return solveVariantStartingBoard(args, settings);
+    }
+    if ((command == "count-games") && ((args.size() == 4) || (args.size() == 5)))
+    {
+        return countGames(std::stoul(args[2]), std::stoi(args[3]), (args.size() == 5) ? std::stoul(args[4]) : 1);
+    }
+    if ((command == "perft") && ((args.size() == 4) || (args.size() == 5)))
+    {
+        return runPerft(args[2], std::stoul(args[3]), (args.size() == 5) ? std::stoul(args[4]) : 1);
+    }
+
+    printUsage(args.at(0));
+    return 1;
+}
+
 int main(int argc, char** argv)
 {
+    std::vector<std::string> args(argv, argv + argc);
+    TranspositionTableSettings settings{};
+    try
+    {
+        settings = parseGlobalOptions(args);
+        if (args.size() > 1)
+        {
+            return runCommand(args, settings);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
     // Manual gameplay code
     // {
     //     const BoardState board_state{ makeDefaultBoardState() };
@@ -164,12 +963,69 @@ int main(int argc, char** argv)
         const TurnExecutor turn_executor{};
         const GameMechanicsExecutor game_mechanics_executor{ turn_executor, /*starting_player_index*/ 0 };
     
-        Solver solver{};
+        Solver solver{ settings.size_bytes, settings.use_huge_pages };
         const std::pair<std::size_t, bool> solution{ solver.solve(board_state, game_mechanics_executor) };
 
         std::cout << "Solution pit index: " << solution.first << std::endl;
         std::cout << "Win guaranteed: " << solution.second << std::endl;
     }
 
+    // Proof-number solver test code
+    {
+        const BoardState board_state{ makeTestBoardState() };
+        const TurnExecutor turn_executor{};
+        const GameMechanicsExecutor game_mechanics_executor{ turn_executor, /*starting_player_index*/ 0 };
+
+        ProofNumberSolver solver{ settings.size_bytes };
+        const ProofNumberResult result{ solver.solve(board_state, game_mechanics_executor, /*target*/ 1) };
+
+        std::cout << "Proof-number win guaranteed: " << (result.outcome == ProofOutcome::kProven) << std::endl;
+        if (result.best_pit_index.has_value())
+        {
+            std::cout << "Proof-number solution pit index: " << result.best_pit_index.value() << std::endl;
+        }
+        std::cout << "Proof-number nodes expanded: " << result.num_nodes << std::endl;
+    }
+
+    // Negamax solver test code
+    {
+        const BoardState board_state{ makeTestBoardState() };
+        const TurnExecutor turn_executor{};
+        const GameMechanicsExecutor game_mechanics_executor{ turn_executor, /*starting_player_index*/ 0 };
+
+        NegamaxSolver solver{ std::make_shared<TranspositionTable>(settings.size_bytes, settings.use_huge_pages),
+                              /*num_threads*/ std::thread::hardware_concurrency() };
+        const NegamaxResult result{ solver.solve(board_state, game_mechanics_executor) };
+
+        std::cout << "Negamax solution pit index: " << result.best_pit_index.value() << std::endl;
+        std::cout << "Negamax final bank differential: " << result.value << std::endl;
+        std::cout << "Negamax principal variation:";
+        for (const std::size_t pit_index : result.principal_variation)
+        {
+            std::cout << " " << pit_index;
+        }
+        std::cout << std::endl;
+        std::cout << "Negamax nodes searched: " << result.num_nodes << std::endl;
+        std::cout << "Negamax search statistics:" << std::endl << result.stats << std::endl;
+    }
+
+    // Time-budgeted solve of the full default board, which is too large to solve exactly here
+    {
+        const BoardState board_state{ makeDefaultBoardState() };
+        const TurnExecutor turn_executor{};
+        const GameMechanicsExecutor game_mechanics_executor{ turn_executor, /*starting_player_index*/ 0 };
+
+        SearchLimits limits{};
+        limits.deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+        NegamaxSolver solver{ std::make_shared<TranspositionTable>(settings.size_bytes, settings.use_huge_pages),
+                              /*num_threads*/ std::thread::hardware_concurrency() };
+        const NegamaxResult result{ solver.solveWithLimits(board_state, game_mechanics_executor, limits) };
+
+        std::cout << "Default board best pit index: " << result.best_pit_index.value() << std::endl;
+        std::cout << "Default board estimated bank differential: " << result.value << " (depth " << result.depth
+                  << ", proven: " << result.proven << ")" << std::endl;
+    }
+
     return 0;
 }
\ No newline at end of file
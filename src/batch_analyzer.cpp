@@ -0,0 +1,230 @@
+#include <batch_analyzer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <binary_records.h>
+#include <bounded_queue.h>
+#include <game_mechanics.h>
+#include <move_generator.h>
+#include <position_text.h>
+
+namespace
+{
+
+//! Queued unit of work. Positions that fail to parse are still queued so that workers report them in the output.
+struct BatchJob
+{
+    std::uint64_t index;
+    std::optional<Position> position;
+    std::string error_message;
+};
+
+NegamaxResult analyzePosition(NegamaxSolver& solver, const Position& position, const BatchAnalyzerOptions& options)
+{
+    const GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, position.active_player_index };
+    if (!options.time_limit_per_position.has_value())
+    {
+        return solver.solve(position.board_state, game_mechanics_executor);
+    }
+
+    SearchLimits limits{};
+    limits.deadline = std::chrono::steady_clock::now() + options.time_limit_per_position.value();
+
+    return solver.solveWithLimits(position.board_state, game_mechanics_executor, limits);
+}
+
+//! Writes a text result to `output`, or a binary one to `result_writer` if given
+void writeResult(std::ostream& output, RecordWriter<ResultRecord>* result_writer, const BatchJob& job, const NegamaxResult* result)
+{
+    if (result_writer == nullptr)
+    {
+        output << job.index << " ";
+        if (result == nullptr)
+        {
+            output << "error " << job.error_message << "\n";
+        }
+        else
+        {
+            output << formatTextResult(*result) << "\n";
+        }
+
+        return;
+    }
+
+    if (result == nullptr)
+    {
+        ResultRecord record{};
+        record.index = job.index;
+        record.best_pit_index = ResultRecord::kNoPitIndex;
+        record.flags = ResultRecord::kInvalidPositionFlag;
+        result_writer->write(record);
+        return;
+    }
+
+    result_writer->write(makeResultRecord(job.index, *result));
+}
+
+//! Reads the next position into `job`, from `position_reader` if given and otherwise as text from `input`. Returns false
+//! when the input is exhausted.
+bool readJob(std::istream& input, RecordReader<PositionRecord>* position_reader, const std::uint64_t index, BatchJob& job)
+{
+    job = BatchJob{ index, std::nullopt, {} };
+
+    if (position_reader == nullptr)
+    {
+        std::string line{};
+        while (std::getline(input, line))
+        {
+            const std::size_t first_char{ line.find_first_not_of(" \t\r") };
+            if ((first_char == std::string::npos) || (line[first_char] == '#'))
+            {
+                continue;
+            }
+
+            try
+            {
+                job.position = parseTextPosition(line);
+            }
+            catch (const std::exception& e)
+            {
+                job.error_message = e.what();
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    PositionRecord record{};
+    if (!position_reader->read(record))
+    {
+        return false;
+    }
+
+    try
+    {
+        job.position = parsePositionRecord(record);
+    }
+    catch (const std::exception& e)
+    {
+        job.error_message = e.what();
+    }
+
+    return true;
+}
+
+} // namespace
+
+BatchSummary BatchAnalyzer::run(std::istream& input, std::ostream& output, const BatchFormat format) const
+{
+    const auto start_time{ std::chrono::steady_clock::now() };
+
+    std::optional<RecordReader<PositionRecord>> position_reader{};
+    std::optional<RecordWriter<ResultRecord>> result_writer{};
+    if (format == BatchFormat::kBinary)
+    {
+        position_reader.emplace(input);
+        result_writer.emplace(output);
+    }
+    RecordWriter<ResultRecord>* const result_writer_pointer{ result_writer.has_value() ? &result_writer.value() : nullptr };
+
+    BoundedQueue<BatchJob> queue{ options_.queue_capacity };
+    std::mutex output_mutex{};
+    std::atomic<std::uint64_t> num_invalid_positions{ 0 };
+
+    const std::size_t num_threads{ std::max<std::size_t>(options_.num_threads, 1) };
+    std::vector<std::thread> workers{};
+    std::vector<std::exception_ptr> worker_exceptions(num_threads);
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        workers.emplace_back([&, i]()
+        {
+            try
+            {
+                NegamaxSolver solver{ std::make_shared<TranspositionTable>(options_.transposition_table_size_bytes, options_.use_huge_pages),
+                                      /*num_threads*/ 1 };
+                solver.setOpeningBook(options_.opening_book);
+
+                for (std::optional<BatchJob> job{ queue.pop() }; job.has_value(); job = queue.pop())
+                {
+                    if (!job->position.has_value())
+                    {
+                        ++num_invalid_positions;
+
+                        std::lock_guard<std::mutex> lock{ output_mutex };
+                        writeResult(output, result_writer_pointer, job.value(), nullptr);
+                        continue;
+                    }
+
+                    const NegamaxResult result{ analyzePosition(solver, job->position.value(), options_) };
+
+                    std::lock_guard<std::mutex> lock{ output_mutex };
+                    writeResult(output, result_writer_pointer, job.value(), &result);
+                }
+            }
+            catch (...)
+            {
+                // Closing the queue stops the reader, which may be blocked on a full queue, and the other workers once
+                // they have drained it
+                worker_exceptions[i] = std::current_exception();
+                queue.close();
+            }
+        });
+    }
+
+    // Workers are always joined, even if reading fails part way through
+    std::exception_ptr read_exception{};
+    std::uint64_t num_positions{ 0 };
+    try
+    {
+        BatchJob job{};
+        while (readJob(input, position_reader.has_value() ? &position_reader.value() : nullptr, num_positions, job))
+        {
+            // Only fails once a worker has failed and closed the queue
+            if (!queue.push(std::move(job)))
+            {
+                break;
+            }
+            ++num_positions;
+        }
+    }
+    catch (...)
+    {
+        read_exception = std::current_exception();
+    }
+
+    queue.close();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    for (const std::exception_ptr& worker_exception : worker_exceptions)
+    {
+        if (worker_exception != nullptr)
+        {
+            std::rethrow_exception(worker_exception);
+        }
+    }
+    if (result_writer.has_value())
+    {
+        result_writer->flush();
+    }
+    output.flush();
+
+    if (read_exception != nullptr)
+    {
+        std::rethrow_exception(read_exception);
+    }
+
+    return BatchSummary{ num_positions, num_invalid_positions.load(), std::chrono::steady_clock::now() - start_time };
+}
@@ -0,0 +1,92 @@
+#include <binary_records.h>
+
+#include <cstring>
+
+namespace
+{
+
+constexpr char kMagic[8]{ 'M', 'N', 'C', 'L', 'R', 'E', 'C', 'S' };
+
+} // namespace
+
+RecordFileHeader makeRecordFileHeader(const RecordType record_type, const std::size_t record_size)
+{
+    RecordFileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.format_version = kRecordFormatVersion;
+    header.record_type = record_type;
+    header.record_size = static_cast<std::uint32_t>(record_size);
+
+    return header;
+}
+
+void checkRecordFileHeader(const RecordFileHeader& header, const RecordType record_type, const std::size_t record_size)
+{
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0)
+    {
+        throw std::runtime_error("Input is not a record file");
+    }
+    if (header.format_version != kRecordFormatVersion)
+    {
+        throw std::runtime_error("Unsupported record file format version " + std::to_string(header.format_version));
+    }
+    if ((header.record_type != record_type) || (header.record_size != record_size))
+    {
+        throw std::runtime_error(std::string{ "Expected a record file of " } +
+                                 ((record_type == RecordType::kPosition) ? "positions" : "results"));
+    }
+}
+
+PositionRecord makePositionRecord(const Position& position)
+{
+    const std::size_t num_pits{ position.board_state.getNumPits() };
+
+    PositionRecord record{};
+    record.num_pits = static_cast<std::uint8_t>(num_pits);
+    record.active_player_index = static_cast<std::uint8_t>(position.active_player_index);
+    const SinglePlayerBoardState* player_board_states[2]{ &position.board_state.getPlayer0BoardState(),
+                                                          &position.board_state.getPlayer1BoardState() };
+    for (std::size_t player_index = 0; player_index < 2; ++player_index)
+    {
+        record.banks[player_index] = static_cast<std::uint8_t>(player_board_states[player_index]->getNumStonesInBank());
+        for (std::size_t i = 0; i < num_pits; ++i)
+        {
+            record.pits[player_index][i] = static_cast<std::uint8_t>(player_board_states[player_index]->getNumStonesInPitUnchecked(i));
+        }
+    }
+
+    return record;
+}
+
+Position parsePositionRecord(const PositionRecord& record)
+{
+    if ((record.num_pits == 0) || (record.num_pits > kMaxNumPits))
+    {
+        throw std::invalid_argument("Number of pits must be in the range [1-" + std::to_string(kMaxNumPits) + "]");
+    }
+    if (record.active_player_index > 1)
+    {
+        throw std::invalid_argument("Player to move must be 0 or 1");
+    }
+
+    const auto makePlayerBoardState{ [&](const std::size_t player_index)
+    {
+        return SinglePlayerBoardState{ std::vector<int>(record.pits[player_index], record.pits[player_index] + record.num_pits),
+                                       record.banks[player_index] };
+    } };
+
+    return Position{ BoardState{ makePlayerBoardState(0), makePlayerBoardState(1) }, record.active_player_index };
+}
+
+ResultRecord makeResultRecord(const std::uint64_t index, const NegamaxResult& result)
+{
+    ResultRecord record{};
+    record.index = index;
+    record.num_nodes = result.num_nodes;
+    record.value = static_cast<std::int16_t>(result.value);
+    record.best_pit_index =
+        result.best_pit_index.has_value() ? static_cast<std::uint8_t>(result.best_pit_index.value()) : ResultRecord::kNoPitIndex;
+    record.flags = result.proven ? ResultRecord::kProvenFlag : 0;
+
+    return record;
+}
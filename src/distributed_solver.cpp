@@ -0,0 +1,558 @@
+#include <distributed_solver.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <move_generator.h>
+#include <negamax_solver.h>
+#include <position_text.h>
+#include <zobrist.h>
+
+namespace
+{
+
+constexpr char kCheckpointMagic[8]{ 'M', 'N', 'C', 'L', 'D', 'I', 'S', 'T' };
+constexpr std::uint32_t kCheckpointFormatVersion{ 1 };
+
+//! TCP keepalive probes start after a connection has been idle this long, and a worker that misses
+//! `kKeepAliveProbeCount` probes `kKeepAliveProbeIntervalSeconds` apart is taken to be gone. The worker's kernel answers
+//! the probes while it is busy solving, so this only fails connections to hosts that died or dropped off the network.
+constexpr int kKeepAliveIdleSeconds{ 60 };
+constexpr int kKeepAliveProbeIntervalSeconds{ 10 };
+constexpr int kKeepAliveProbeCount{ 6 };
+
+struct CheckpointHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint8_t num_pits;
+    std::uint8_t reserved[3];
+};
+
+static_assert(sizeof(CheckpointHeader) == 16);
+
+struct CheckpointRecord
+{
+    std::uint64_t key;
+    std::int32_t value;
+    std::uint8_t reserved[4];
+};
+
+static_assert(sizeof(CheckpointRecord) == 16);
+
+//! Loads the values of a checkpoint, creating it if it does not exist, and opens it for appending. Throws
+//! `std::runtime_error` for a file that is not a checkpoint for boards with `num_pits` pits.
+std::ofstream openCheckpoint(const std::string& path, const std::size_t num_pits, std::unordered_map<std::uint64_t, int>& values)
+{
+    std::uintmax_t num_valid_bytes{ 0 };
+    {
+        std::ifstream input{ path, std::ios::binary };
+        CheckpointHeader header{};
+        if (input && input.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        {
+            if ((std::memcmp(header.magic, kCheckpointMagic, sizeof(kCheckpointMagic)) != 0) ||
+                (header.version != kCheckpointFormatVersion))
+            {
+                throw std::runtime_error("`" + path + "` is not a distributed solve checkpoint");
+            }
+            if (header.num_pits != num_pits)
+            {
+                throw std::runtime_error("`" + path + "` is a checkpoint for boards with " + std::to_string(header.num_pits) + " pits");
+            }
+
+            num_valid_bytes = sizeof(header);
+            CheckpointRecord record{};
+            while (input.read(reinterpret_cast<char*>(&record), sizeof(record)))
+            {
+                values[record.key] = record.value;
+                num_valid_bytes += sizeof(record);
+            }
+        }
+    }
+
+    if (num_valid_bytes == 0)
+    {
+        // Missing, or killed before the header was complete
+        std::ofstream output{ path, std::ios::binary | std::ios::trunc };
+        CheckpointHeader header{};
+        std::memcpy(header.magic, kCheckpointMagic, sizeof(kCheckpointMagic));
+        header.version = kCheckpointFormatVersion;
+        header.num_pits = static_cast<std::uint8_t>(num_pits);
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!output)
+        {
+            throw std::runtime_error("Could not create `" + path + "`");
+        }
+    }
+    else
+    {
+        // Drop a record that was only partly written
+        std::filesystem::resize_file(path, num_valid_bytes);
+    }
+
+    std::ofstream checkpoint{ path, std::ios::binary | std::ios::app };
+    if (!checkpoint)
+    {
+        throw std::runtime_error("Could not open `" + path + "` for writing");
+    }
+
+    return checkpoint;
+}
+
+//! Thrown for malformed addresses and answers, which retrying cannot fix
+struct WorkerError : std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+//! Connection to a `SolverServer`, sending one request line at a time
+class WorkerConnection
+{
+public:
+    //! Throws `std::runtime_error` if the worker cannot be reached, or `WorkerError` if the address is malformed. Without a
+    //! `response_timeout`, `send()` waits for answers as long as the connection is alive.
+    WorkerConnection(const std::string& address, const std::optional<std::chrono::milliseconds>& response_timeout) :
+                response_timeout_{ response_timeout }
+    {
+        const std::size_t separator{ address.find(':') };
+        const std::string transport{ address.substr(0, separator) };
+        const std::string location{ (separator == std::string::npos) ? std::string{} : address.substr(separator + 1) };
+        if (transport == "tcp")
+        {
+            const std::size_t port_separator{ location.rfind(':') };
+            if (port_separator == std::string::npos)
+            {
+                throw WorkerError("Worker address `" + address + "` has no port");
+            }
+            const std::uint16_t port{ parsePort(address, location.substr(port_separator + 1)) };
+
+            sockaddr_in socket_address{};
+            socket_address.sin_family = AF_INET;
+            socket_address.sin_port = htons(port);
+            if (::inet_pton(AF_INET, location.substr(0, port_separator).c_str(), &socket_address.sin_addr) != 1)
+            {
+                throw WorkerError("Invalid IPv4 address in worker address `" + address + "`");
+            }
+            connect(AF_INET, reinterpret_cast<const sockaddr*>(&socket_address), sizeof(socket_address), address);
+            enableKeepAlive();
+        }
+        else if (transport == "unix")
+        {
+            sockaddr_un socket_address{};
+            socket_address.sun_family = AF_UNIX;
+            if (location.empty() || (location.size() >= sizeof(socket_address.sun_path)))
+            {
+                throw WorkerError("Invalid socket path in worker address `" + address + "`");
+            }
+            std::memcpy(socket_address.sun_path, location.c_str(), location.size() + 1);
+            connect(AF_UNIX, reinterpret_cast<const sockaddr*>(&socket_address), sizeof(socket_address), address);
+        }
+        else
+        {
+            throw WorkerError("Worker address `" + address + "` must start with `tcp:` or `unix:`");
+        }
+    }
+
+    WorkerConnection(const WorkerConnection&) = delete;
+    WorkerConnection& operator=(const WorkerConnection&) = delete;
+
+    ~WorkerConnection()
+    {
+        ::close(fd_);
+    }
+
+    //! Sends `request` and returns the response line. Throws `std::runtime_error` if the connection fails or the response
+    //! timeout passes first.
+    std::string send(const std::string& request)
+    {
+        const std::string line{ request + "\n" };
+        std::size_t num_sent_bytes{ 0 };
+        while (num_sent_bytes < line.size())
+        {
+            const ssize_t n{ ::send(fd_, line.data() + num_sent_bytes, line.size() - num_sent_bytes, MSG_NOSIGNAL) };
+            if ((n < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            if (n < 0)
+            {
+                throw std::runtime_error(std::string{ "Could not send to worker: " } + std::strerror(errno));
+            }
+            num_sent_bytes += static_cast<std::size_t>(n);
+        }
+
+        const auto deadline{ std::chrono::steady_clock::now() + response_timeout_.value_or(std::chrono::milliseconds{ 0 }) };
+        std::size_t line_end{ buffer_.find('\n') };
+        char chunk[4096];
+        while (line_end == std::string::npos)
+        {
+            if (response_timeout_.has_value())
+            {
+                waitForResponse(deadline);
+            }
+
+            const ssize_t n{ ::recv(fd_, chunk, sizeof(chunk), 0) };
+            if ((n < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                throw std::runtime_error("Worker closed the connection");
+            }
+            buffer_.append(chunk, static_cast<std::size_t>(n));
+            line_end = buffer_.find('\n');
+        }
+
+        const std::string response{ buffer_.substr(0, line_end) };
+        buffer_.erase(0, line_end + 1);
+
+        return response;
+    }
+
+private:
+    //! Throws `WorkerError` unless `port` is a decimal number in the range of a port, with nothing else around it
+    static std::uint16_t parsePort(const std::string& address, const std::string& port)
+    {
+        // `std::stoul()` would also take leading whitespace and a sign, so only digits get that far
+        if (port.empty() || (port.find_first_not_of("0123456789") != std::string::npos))
+        {
+            throw WorkerError("Port of worker address `" + address + "` is not a number");
+        }
+
+        std::size_t num_parsed_chars{ 0 };
+        unsigned long value{ 0 };
+        try
+        {
+            value = std::stoul(port, &num_parsed_chars);
+        }
+        catch (const std::out_of_range&)
+        {
+            throw WorkerError("Port of worker address `" + address + "` is out of range");
+        }
+        if (num_parsed_chars != port.size())
+        {
+            throw WorkerError("Port of worker address `" + address + "` is not a number");
+        }
+        if (value > std::numeric_limits<std::uint16_t>::max())
+        {
+            throw WorkerError("Port of worker address `" + address + "` is out of range");
+        }
+
+        return static_cast<std::uint16_t>(value);
+    }
+
+    //! Blocks until there is data to read. Throws `std::runtime_error` once `deadline` has passed.
+    void waitForResponse(const std::chrono::steady_clock::time_point deadline) const
+    {
+        while (true)
+        {
+            const auto time_left{ std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()) };
+            if (time_left.count() <= 0)
+            {
+                throw std::runtime_error("Worker did not answer within " + std::to_string(response_timeout_->count()) + " ms");
+            }
+
+            pollfd poll_fd{ fd_, POLLIN, 0 };
+            const int timeout_ms{ static_cast<int>(std::min<std::chrono::milliseconds::rep>(time_left.count(), std::numeric_limits<int>::max())) };
+            const int num_ready{ ::poll(&poll_fd, 1, timeout_ms) };
+            if ((num_ready < 0) && (errno != EINTR))
+            {
+                throw std::runtime_error(std::string{ "Could not wait for worker: " } + std::strerror(errno));
+            }
+            if (num_ready > 0)
+            {
+                // Also set for a closed or failed connection, which the following `recv()` reports
+                return;
+            }
+        }
+    }
+
+    //! Without keepalive, a worker host that goes away while solving would leave `send()` waiting forever, since a
+    //! solve can legitimately take longer than any fixed response timeout
+    void enableKeepAlive()
+    {
+        const int enable{ 1 };
+        ::setsockopt(fd_, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_KEEPIDLE, &kKeepAliveIdleSeconds, sizeof(kKeepAliveIdleSeconds));
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_KEEPINTVL, &kKeepAliveProbeIntervalSeconds, sizeof(kKeepAliveProbeIntervalSeconds));
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_KEEPCNT, &kKeepAliveProbeCount, sizeof(kKeepAliveProbeCount));
+    }
+
+    void connect(const int domain, const sockaddr* socket_address, const socklen_t socket_address_size, const std::string& address)
+    {
+        fd_ = ::socket(domain, SOCK_STREAM, 0);
+        if (fd_ < 0)
+        {
+            throw std::runtime_error(std::string{ "Could not create socket: " } + std::strerror(errno));
+        }
+        if (::connect(fd_, socket_address, socket_address_size) != 0)
+        {
+            const std::string message{ "Could not connect to worker `" + address + "`: " + std::strerror(errno) };
+            ::close(fd_);
+            throw std::runtime_error(message);
+        }
+    }
+
+    std::optional<std::chrono::milliseconds> response_timeout_;
+    int fd_{ -1 };
+    std::string buffer_{};
+};
+
+//! Parses `ok <best_pit_index> <value> <proven>` for a solve
+int parseSolveResponse(const std::string& response)
+{
+    std::istringstream stream{ response };
+    std::string status{};
+    std::string best_pit_index{};
+    int value{ 0 };
+    int proven{ 0 };
+    if (!(stream >> status >> best_pit_index >> value >> proven) || (status != "ok") || (proven != 1))
+    {
+        throw WorkerError("Unexpected answer from worker: " + response);
+    }
+
+    return value;
+}
+
+} // namespace
+
+DistributedSolver::DistributedSolver(const DistributedSolverOptions& options) : options_{ options }
+{
+    if (options_.worker_addresses.empty())
+    {
+        throw std::invalid_argument("A distributed solve needs at least one worker");
+    }
+}
+
+DistributedSolveResult DistributedSolver::solve(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor) const
+{
+    DistributedSolveResult result{};
+
+    std::unordered_set<std::uint64_t> keys{};
+    std::vector<Job> jobs{};
+    collectJobs(board_state, game_mechanics_executor, options_.split_ply, keys, jobs, result.num_frontier_positions);
+    result.num_jobs = jobs.size();
+
+    std::unordered_map<std::uint64_t, int> values{};
+    std::ofstream checkpoint{};
+    if (!options_.checkpoint_path.empty())
+    {
+        checkpoint = openCheckpoint(options_.checkpoint_path, board_state.getNumPits(), values);
+        result.num_checkpointed_jobs = static_cast<std::size_t>(
+            std::count_if(jobs.begin(), jobs.end(), [&](const Job& job) { return values.count(job.key) > 0; }));
+    }
+
+    runJobs(jobs, values, options_.checkpoint_path.empty() ? nullptr : &checkpoint, result.num_retried_jobs);
+    result.value = mergeValues(board_state, game_mechanics_executor, options_.split_ply, values, &result.best_pit_index);
+
+    return result;
+}
+
+void DistributedSolver::collectJobs(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+                                    const std::size_t num_plies, std::unordered_set<std::uint64_t>& keys, std::vector<Job>& jobs,
+                                    std::size_t& num_frontier_positions) const
+{
+    if (game_mechanics_executor.isGameFinished(board_state))
+    {
+        return;
+    }
+
+    const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
+    if (num_plies == 0)
+    {
+        ++num_frontier_positions;
+        const std::uint64_t key{ ZobristHasher::hashPits(board_state, active_player_index) };
+        if (keys.insert(key).second)
+        {
+            jobs.push_back(Job{ key, board_state.getCanonical(active_player_index) });
+        }
+        return;
+    }
+
+    for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+    {
+        BoardState board_state_i{ board_state };
+        GameMechanicsExecutor game_mechanics_executor_i{ game_mechanics_executor };
+        if (game_mechanics_executor_i.playTurn(i, board_state_i))
+        {
+            collectJobs(board_state_i, game_mechanics_executor_i, num_plies - 1, keys, jobs, num_frontier_positions);
+        }
+    }
+}
+
+void DistributedSolver::runJobs(const std::vector<Job>& jobs, std::unordered_map<std::uint64_t, int>& values, std::ostream* checkpoint,
+                                std::size_t& num_retried_jobs) const
+{
+    std::mutex mutex{};
+    std::condition_variable condition{};
+    std::deque<const Job*> pending_jobs{};
+    for (const Job& job : jobs)
+    {
+        if (values.count(job.key) == 0)
+        {
+            pending_jobs.push_back(&job);
+        }
+    }
+    std::size_t num_unsolved_jobs{ pending_jobs.size() };
+    std::exception_ptr error{};
+    //! Message of the most recent failure of any connection, for when they all give up
+    std::string last_connection_error{};
+
+    const auto runConnection{ [&](const std::string& address)
+    {
+        std::size_t num_failures{ 0 };
+        std::unique_ptr<WorkerConnection> connection{};
+        while (true)
+        {
+            const Job* job{ nullptr };
+            {
+                std::unique_lock<std::mutex> lock{ mutex };
+                condition.wait(lock, [&]() { return !pending_jobs.empty() || (num_unsolved_jobs == 0) || (error != nullptr); });
+                if (pending_jobs.empty())
+                {
+                    break;
+                }
+                job = pending_jobs.front();
+                pending_jobs.pop_front();
+            }
+
+            try
+            {
+                if (connection == nullptr)
+                {
+                    connection = std::make_unique<WorkerConnection>(address, options_.response_timeout);
+                }
+                const int value{ parseSolveResponse(connection->send("solve " + formatTextPosition(Position{ job->board_state, 0 }))) };
+                num_failures = 0;
+
+                // Workers answer with the final bank differential, which is stored relative to the banks
+                std::lock_guard<std::mutex> lock{ mutex };
+                const int relative_value{ value - NegamaxSolver::getBankDifferential(job->board_state, 0) };
+                values[job->key] = relative_value;
+                if (checkpoint != nullptr)
+                {
+                    const CheckpointRecord record{ job->key, relative_value, {} };
+                    checkpoint->write(reinterpret_cast<const char*>(&record), sizeof(record));
+                    checkpoint->flush();
+                }
+                if (--num_unsolved_jobs == 0)
+                {
+                    condition.notify_all();
+                }
+            }
+            catch (const WorkerError&)
+            {
+                std::lock_guard<std::mutex> lock{ mutex };
+                error = std::current_exception();
+                pending_jobs.clear();
+                condition.notify_all();
+                break;
+            }
+            catch (const std::exception& e)
+            {
+                connection.reset();
+                {
+                    std::lock_guard<std::mutex> lock{ mutex };
+                    last_connection_error = e.what();
+                    pending_jobs.push_front(job);
+                    ++num_retried_jobs;
+                    condition.notify_all();
+                }
+
+                if (++num_failures >= options_.max_connect_attempts)
+                {
+                    break;
+                }
+                std::this_thread::sleep_for(options_.retry_interval);
+            }
+        }
+    } };
+
+    std::vector<std::thread> threads{};
+    for (const std::string& address : options_.worker_addresses)
+    {
+        for (std::size_t c = 0; c < std::max<std::size_t>(options_.connections_per_worker, 1); ++c)
+        {
+            threads.emplace_back(runConnection, address);
+        }
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (error != nullptr)
+    {
+        std::rethrow_exception(error);
+    }
+    if ((checkpoint != nullptr) && !*checkpoint)
+    {
+        throw std::runtime_error("Could not write the checkpoint");
+    }
+    if (num_unsolved_jobs > 0)
+    {
+        throw std::runtime_error("All worker connections failed with " + std::to_string(num_unsolved_jobs) +
+                                 " jobs left, last error: " + last_connection_error);
+    }
+}
+
+int DistributedSolver::mergeValues(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+                                   const std::size_t num_plies, const std::unordered_map<std::uint64_t, int>& values,
+                                   std::optional<std::size_t>* best_pit_index) const
+{
+    const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
+    if (game_mechanics_executor.isGameFinished(board_state))
+    {
+        return GameMechanicsExecutor::getFinalBankDifferential(board_state, active_player_index);
+    }
+    if (num_plies == 0)
+    {
+        return values.at(ZobristHasher::hashPits(board_state, active_player_index)) + NegamaxSolver::getBankDifferential(board_state, active_player_index);
+    }
+
+    int best_value{ std::numeric_limits<int>::min() };
+    for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+    {
+        BoardState board_state_i{ board_state };
+        GameMechanicsExecutor game_mechanics_executor_i{ game_mechanics_executor };
+        if (!game_mechanics_executor_i.playTurn(i, board_state_i))
+        {
+            continue;
+        }
+
+        // Extra turns keep the same perspective
+        const int value_i{ mergeValues(board_state_i, game_mechanics_executor_i, num_plies - 1, values, nullptr) };
+        const int value{ (game_mechanics_executor_i.getActivePlayerIndex() == active_player_index) ? value_i : -value_i };
+        if (value > best_value)
+        {
+            best_value = value;
+            if (best_pit_index != nullptr)
+            {
+                *best_pit_index = i;
+            }
+        }
+    }
+
+    return best_value;
+}
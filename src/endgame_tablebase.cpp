@@ -0,0 +1,221 @@
+#include <endgame_tablebase.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <game_mechanics.h>
+
+namespace
+{
+
+constexpr char kMagic[8]{ 'M', 'N', 'C', 'L', 'E', 'G', 'T', 'B' };
+
+struct FileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t num_pits;
+    std::uint32_t max_stones;
+    std::uint32_t reserved;
+    std::uint64_t num_entries;
+};
+
+} // namespace
+
+EndgameTablebase::EndgameTablebase(const std::size_t num_pits, const int max_stones) :
+            num_pits_{ num_pits }, max_stones_{ max_stones }, position_indexer_{ num_pits, max_stones }, layer_offsets_{}, num_entries_{ 0 },
+            generated_values_{}, mapped_file_{}, values_{ nullptr }
+{
+    if ((num_pits == 0) || (num_pits > kMaxNumPits))
+    {
+        std::stringstream msg{};
+        msg << "Number of pits (" << num_pits << ") must be in the range [1-" << kMaxNumPits << "]";
+
+        throw std::invalid_argument(msg.str());
+    }
+
+    if ((max_stones < 0) || (max_stones > kMaxSupportedStones))
+    {
+        std::stringstream msg{};
+        msg << "Maximum number of stones (" << max_stones << ") must be in the range [0-" << kMaxSupportedStones << "]";
+
+        throw std::invalid_argument(msg.str());
+    }
+
+    for (int s = 0; s <= max_stones; ++s)
+    {
+        layer_offsets_.push_back(num_entries_);
+        num_entries_ += position_indexer_.getNumDistributions(s);
+    }
+}
+
+EndgameTablebase EndgameTablebase::generate(const std::size_t num_pits, const int max_stones)
+{
+    EndgameTablebase tablebase{ num_pits, max_stones };
+    tablebase.generated_values_.assign(tablebase.num_entries_, kUnknownValue);
+    tablebase.values_ = tablebase.generated_values_.data();
+
+    // Indices are ordered by layer, so a plain sweep solves every smaller layer before the current one
+    for (std::uint64_t index = 0; index < tablebase.num_entries_; ++index)
+    {
+        if (tablebase.generated_values_[index] == kUnknownValue)
+        {
+            tablebase.solvePosition(index);
+        }
+    }
+
+    return tablebase;
+}
+
+EndgameTablebase EndgameTablebase::load(const std::string& path)
+{
+    MappedFile mapped_file{ path };
+
+    FileHeader header{};
+    if (mapped_file.getSize() >= sizeof(header))
+    {
+        std::memcpy(&header, mapped_file.getData(), sizeof(header));
+    }
+    if ((mapped_file.getSize() < kMappedFilePageSize) || (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) ||
+        (header.version != kFormatVersion))
+    {
+        throw std::runtime_error("`" + path + "` is not a supported endgame tablebase");
+    }
+
+    EndgameTablebase tablebase{ header.num_pits, static_cast<int>(header.max_stones) };
+    if (header.num_entries != tablebase.num_entries_)
+    {
+        throw std::runtime_error("Endgame tablebase `" + path + "` has an inconsistent number of entries");
+    }
+    if (mapped_file.getSize() < (kMappedFilePageSize + tablebase.num_entries_))
+    {
+        throw std::runtime_error("Endgame tablebase `" + path + "` is truncated");
+    }
+
+    // Probes jump around the whole table
+    mapped_file.adviseRandomAccess();
+    tablebase.values_ = reinterpret_cast<const std::int8_t*>(mapped_file.getData() + kMappedFilePageSize);
+    tablebase.mapped_file_ = std::move(mapped_file);
+
+    return tablebase;
+}
+
+void EndgameTablebase::save(const std::string& path) const
+{
+    std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.num_pits = static_cast<std::uint32_t>(num_pits_);
+    header.max_stones = static_cast<std::uint32_t>(max_stones_);
+    header.num_entries = num_entries_;
+
+    // Pad the header to a full page so the values start page-aligned
+    std::vector<char> header_page(kMappedFilePageSize, 0);
+    std::memcpy(header_page.data(), &header, sizeof(header));
+
+    file.write(header_page.data(), static_cast<std::streamsize>(header_page.size()));
+    file.write(reinterpret_cast<const char*>(values_), static_cast<std::streamsize>(num_entries_));
+    if (!file)
+    {
+        throw std::runtime_error("Could not write endgame tablebase `" + path + "`");
+    }
+}
+
+std::optional<int> EndgameTablebase::probe(const BoardState& board_state, const std::size_t active_player_index) const
+{
+    if (board_state.getNumPits() != num_pits_)
+    {
+        return std::nullopt;
+    }
+
+    const BoardState canonical_board_state{ board_state.getCanonical(active_player_index) };
+    const SinglePlayerBoardState& active_player_board_state{ canonical_board_state.getPlayer0BoardState() };
+    const SinglePlayerBoardState& opposing_player_board_state{ canonical_board_state.getPlayer1BoardState() };
+    const int num_stones{ active_player_board_state.sumOfStonesInPits() + opposing_player_board_state.sumOfStonesInPits() };
+    if (num_stones > max_stones_)
+    {
+        return std::nullopt;
+    }
+
+    const int bank_differential{ active_player_board_state.getNumStonesInBank() - opposing_player_board_state.getNumStonesInBank() };
+    return values_[getIndex(PositionIndexer::getCells(canonical_board_state), num_stones)] + bank_differential;
+}
+
+std::uint64_t EndgameTablebase::getNumPositions(const int num_stones, const std::size_t num_cells)
+{
+    return PositionIndexer::countDistributions(num_stones, num_cells);
+}
+
+std::uint64_t EndgameTablebase::getIndex(const Cells& cells, const int num_stones) const
+{
+    // All smaller layers come first
+    return layer_offsets_[static_cast<std::size_t>(num_stones)] + position_indexer_.rankCells(cells);
+}
+
+EndgameTablebase::Cells EndgameTablebase::getCells(const std::uint64_t index, int& num_stones) const
+{
+    num_stones = static_cast<int>(std::upper_bound(layer_offsets_.begin(), layer_offsets_.end(), index) - layer_offsets_.begin()) - 1;
+
+    return position_indexer_.unrankCells(index - layer_offsets_[static_cast<std::size_t>(num_stones)], num_stones);
+}
+
+int EndgameTablebase::solvePosition(const std::uint64_t index)
+{
+    int num_stones{ 0 };
+    const Cells cells{ getCells(index, num_stones) };
+
+    std::vector<int> active_player_pits(num_pits_);
+    std::vector<int> opposing_player_pits(num_pits_);
+    int num_active_player_stones{ 0 };
+    for (std::size_t i = 0; i < num_pits_; ++i)
+    {
+        active_player_pits[i] = cells[i];
+        opposing_player_pits[i] = cells[num_pits_ + i];
+        num_active_player_stones += cells[i];
+    }
+    const int num_opposing_player_stones{ num_stones - num_active_player_stones };
+
+    // The active player is always player 0, with both banks empty
+    const BoardState board_state{ SinglePlayerBoardState{ active_player_pits, /*bank*/ 0 },
+                                  SinglePlayerBoardState{ opposing_player_pits, /*bank*/ 0 } };
+
+    // The game is over once either side is empty and the remaining stones are swept into the banks
+    if ((num_active_player_stones == 0) || (num_opposing_player_stones == 0))
+    {
+        const int value{ GameMechanicsExecutor::getFinalBankDifferential(board_state, /*player_index*/ 0) };
+        generated_values_[index] = static_cast<std::int8_t>(value);
+        return value;
+    }
+    const TurnExecutor turn_executor{};
+
+    int best_value{ std::numeric_limits<int>::min() };
+    for (std::size_t i = 0; i < num_pits_; ++i)
+    {
+        BoardState board_state_i{ board_state };
+        const TurnResult result{ turn_executor.playTurn(/*player_index*/ 0, i, board_state_i) };
+        if (!result.valid)
+        {
+            continue;
+        }
+
+        // Only the active player's bank can change during their turn
+        const int gain{ board_state_i.getPlayer0BoardState().getNumStonesInBank() };
+
+        const Cells child_cells{ PositionIndexer::getCells(board_state_i.getCanonical(result.ended_in_bank ? 0 : 1)) };
+        const std::uint64_t child_index{ getIndex(child_cells, num_stones - gain) };
+        const int child_value{ (generated_values_[child_index] == kUnknownValue) ? solvePosition(child_index)
+                                                                                  : generated_values_[child_index] };
+
+        best_value = std::max(best_value, gain + (result.ended_in_bank ? child_value : -child_value));
+    }
+
+    generated_values_[index] = static_cast<std::int8_t>(best_value);
+    return best_value;
+}
@@ -0,0 +1,309 @@
+#include <game_tree_statistics.h>
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <binary_records.h>
+#include <move_generator.h>
+#include <work_stealing_pool.h>
+#include <zobrist.h>
+
+namespace
+{
+
+//! A parallel count expands the root until there are this many distinct subtrees per thread, for load balancing
+constexpr std::size_t kMinSubtreesPerThread{ 16 };
+
+//! Canonical form of a position packed with its `ZobristHasher::hashCanonical()`. The memo compares the packed
+//! position in full, so a hash collision can never mix up the counts of two positions.
+struct MemoKey
+{
+    std::uint64_t hash;
+    PositionRecord position;
+};
+
+struct MemoKeyHash
+{
+    std::size_t operator()(const MemoKey& key) const
+    {
+        return static_cast<std::size_t>(key.hash);
+    }
+};
+
+struct MemoKeyEqual
+{
+    bool operator()(const MemoKey& a, const MemoKey& b) const
+    {
+        return (a.hash == b.hash) && (std::memcmp(&a.position, &b.position, sizeof(a.position)) == 0);
+    }
+};
+
+MemoKey makeMemoKey(const BoardState& board_state, const std::size_t active_player_index)
+{
+    return MemoKey{ ZobristHasher::hashCanonical(board_state, active_player_index),
+                    makePositionRecord(Position{ board_state.getCanonical(active_player_index), 0 }) };
+}
+
+//! Memoized counts of at most `max_num_entries` positions. Split into shards with a lock each, so threads rarely wait
+//! on each other. Two threads may count the same position at once; both get the same counts, so the second insert is
+//! harmless.
+class GameCountMemo
+{
+public:
+    explicit GameCountMemo(const std::uint64_t max_num_entries) : max_num_entries_{ max_num_entries }
+    {
+    }
+
+    std::optional<GameCounts> find(const MemoKey& key) const
+    {
+        const Shard& shard{ getShard(key.hash) };
+        std::lock_guard<std::mutex> lock{ shard.mutex };
+        const auto it{ shard.counts.find(key) };
+        if (it == shard.counts.end())
+        {
+            return std::nullopt;
+        }
+
+        return it->second;
+    }
+
+    //! Throws `std::runtime_error` if the memo is full
+    void insert(const MemoKey& key, const GameCounts& counts)
+    {
+        Shard& shard{ getShard(key.hash) };
+        std::lock_guard<std::mutex> lock{ shard.mutex };
+        if (shard.counts.count(key) > 0)
+        {
+            return;
+        }
+        if (num_entries_.fetch_add(1) >= max_num_entries_)
+        {
+            throw std::runtime_error("More than " + std::to_string(max_num_entries_) + " distinct positions to count");
+        }
+        shard.counts.emplace(key, counts);
+    }
+
+    std::uint64_t size() const
+    {
+        return num_entries_.load();
+    }
+
+private:
+    static constexpr std::size_t kNumShards{ 64 };
+
+    struct Shard
+    {
+        mutable std::mutex mutex{};
+        std::unordered_map<MemoKey, GameCounts, MemoKeyHash, MemoKeyEqual> counts{};
+    };
+
+    // Zobrist keys are uniformly distributed, so the top bits pick a shard independently of the bucket the shard's
+    // map uses
+    const Shard& getShard(const std::uint64_t hash) const
+    {
+        return shards_[(hash >> 58) % kNumShards];
+    }
+
+    Shard& getShard(const std::uint64_t hash)
+    {
+        return shards_[(hash >> 58) % kNumShards];
+    }
+
+    std::uint64_t max_num_entries_;
+    std::atomic<std::uint64_t> num_entries_{ 0 };
+    std::array<Shard, kNumShards> shards_{};
+};
+
+std::uint64_t addCount(const std::uint64_t a, const std::uint64_t b)
+{
+    std::uint64_t sum{ 0 };
+    if (__builtin_add_overflow(a, b, &sum))
+    {
+        throw std::overflow_error("Too many games to count in 64 bits");
+    }
+
+    return sum;
+}
+
+//! Adds the counts of a child position, which are from the perspective of the player to move there
+void addChildCounts(const GameCounts& child_counts, const bool same_player_to_move, GameCounts& counts)
+{
+    counts.num_wins = addCount(counts.num_wins, same_player_to_move ? child_counts.num_wins : child_counts.num_losses);
+    counts.num_draws = addCount(counts.num_draws, child_counts.num_draws);
+    counts.num_losses = addCount(counts.num_losses, same_player_to_move ? child_counts.num_losses : child_counts.num_wins);
+}
+
+GameCounts countGames(const BoardState& board_state, const std::size_t active_player_index, GameCountMemo& memo);
+
+//! Counts of the position after a turn, which is a single game if the turn finished it
+GameCounts countGamesAfterTurn(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor, GameCountMemo& memo)
+{
+    const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
+    const std::optional<std::size_t> winner_player_index{ game_mechanics_executor.getWinnerPlayerIndex(board_state) };
+    if (!winner_player_index.has_value())
+    {
+        return countGames(board_state, active_player_index, memo);
+    }
+
+    GameCounts counts{};
+    if (winner_player_index.value() == active_player_index)
+    {
+        counts.num_wins = 1;
+    }
+    else if (winner_player_index.value() == 2)
+    {
+        counts.num_draws = 1;
+    }
+    else
+    {
+        counts.num_losses = 1;
+    }
+
+    return counts;
+}
+
+//! Counts of an unfinished position
+GameCounts countGames(const BoardState& board_state, const std::size_t active_player_index, GameCountMemo& memo)
+{
+    const MemoKey key{ makeMemoKey(board_state, active_player_index) };
+    const std::optional<GameCounts> memoized_counts{ memo.find(key) };
+    if (memoized_counts.has_value())
+    {
+        return memoized_counts.value();
+    }
+
+    GameCounts counts{};
+    for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+    {
+        BoardState board_state_i{ board_state };
+        GameMechanicsExecutor game_mechanics_executor_i{ TurnExecutor{}, active_player_index };
+        if (!game_mechanics_executor_i.playTurn(i, board_state_i))
+        {
+            continue;
+        }
+
+        addChildCounts(countGamesAfterTurn(board_state_i, game_mechanics_executor_i, memo),
+                       game_mechanics_executor_i.getActivePlayerIndex() == active_player_index, counts);
+    }
+    memo.insert(key, counts);
+
+    return counts;
+}
+
+//! Counts the distinct positions a few turns below the root on `num_threads` threads, so the root moves only have to
+//! add up memoized counts
+void countFrontier(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor, const std::size_t num_threads,
+                   GameCountMemo& memo)
+{
+    // Expand breadth-first one turn at a time until there are enough subtrees to keep every thread busy. Transpositions
+    // and finished games are dropped from the frontier.
+    std::vector<Position> frontier{ Position{ board_state, game_mechanics_executor.getActivePlayerIndex() } };
+    while (!frontier.empty() && (frontier.size() < (kMinSubtreesPerThread * num_threads)))
+    {
+        std::vector<Position> next_frontier{};
+        std::unordered_set<std::uint64_t> keys{};
+        for (const Position& position : frontier)
+        {
+            for (std::size_t i = 0; i < position.board_state.getNumPits(); ++i)
+            {
+                BoardState board_state_i{ position.board_state };
+                GameMechanicsExecutor game_mechanics_executor_i{ TurnExecutor{}, position.active_player_index };
+                if (!game_mechanics_executor_i.playTurn(i, board_state_i) || game_mechanics_executor_i.isGameFinished(board_state_i))
+                {
+                    continue;
+                }
+
+                const std::size_t active_player_index_i{ game_mechanics_executor_i.getActivePlayerIndex() };
+                if (keys.insert(ZobristHasher::hashCanonical(board_state_i, active_player_index_i)).second)
+                {
+                    next_frontier.push_back(Position{ board_state_i, active_player_index_i });
+                }
+            }
+        }
+        frontier = std::move(next_frontier);
+    }
+
+    std::atomic<std::size_t> num_pending_subtrees{ frontier.size() };
+    std::mutex exception_mutex{};
+    std::exception_ptr subtree_exception{};
+    WorkStealingPool pool{ num_threads };
+    for (const Position& position : frontier)
+    {
+        pool.push(/*worker_index*/ 0, [&memo, &num_pending_subtrees, &exception_mutex, &subtree_exception, position](std::size_t)
+        {
+            try
+            {
+                countGames(position.board_state, position.active_player_index, memo);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{ exception_mutex };
+                subtree_exception = std::current_exception();
+            }
+
+            num_pending_subtrees.fetch_sub(1);
+        });
+    }
+
+    while (num_pending_subtrees.load() > 0)
+    {
+        if (!pool.runPendingTask(/*worker_index*/ 0))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    if (subtree_exception != nullptr)
+    {
+        std::rethrow_exception(subtree_exception);
+    }
+}
+
+} // namespace
+
+std::uint64_t GameCounts::getNumGames() const
+{
+    return addCount(addCount(num_wins, num_draws), num_losses);
+}
+
+GameTreeStatisticsResult GameTreeStatistics::count(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+                                                   const std::size_t num_threads, const std::uint64_t max_num_distinct_positions)
+{
+    GameTreeStatisticsResult result{};
+    result.game_counts_per_pit.resize(board_state.getNumPits());
+    if (game_mechanics_executor.isGameFinished(board_state))
+    {
+        return result;
+    }
+
+    GameCountMemo memo{ max_num_distinct_positions };
+    if (num_threads > 1)
+    {
+        countFrontier(board_state, game_mechanics_executor, num_threads, memo);
+    }
+
+    const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
+    for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+    {
+        BoardState board_state_i{ board_state };
+        GameMechanicsExecutor game_mechanics_executor_i{ game_mechanics_executor };
+        if (!game_mechanics_executor_i.playTurn(i, board_state_i))
+        {
+            continue;
+        }
+
+        addChildCounts(countGamesAfterTurn(board_state_i, game_mechanics_executor_i, memo),
+                       game_mechanics_executor_i.getActivePlayerIndex() == active_player_index, result.game_counts_per_pit[i]);
+    }
+    result.num_distinct_positions = memo.size();
+
+    return result;
+}
@@ -0,0 +1,85 @@
+#include <mapped_file.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path)
+{
+    const int fd{ ::open(path.c_str(), O_RDONLY) };
+    if (fd < 0)
+    {
+        throw std::runtime_error("Could not open `" + path + "`: " + std::strerror(errno));
+    }
+
+    struct stat file_status{};
+    if (::fstat(fd, &file_status) != 0)
+    {
+        const int error{ errno };
+        ::close(fd);
+        throw std::runtime_error("Could not stat `" + path + "`: " + std::strerror(error));
+    }
+
+    size_ = static_cast<std::size_t>(file_status.st_size);
+    if (size_ > 0)
+    {
+        void* const data{ ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0) };
+        if (data == MAP_FAILED)
+        {
+            const int error{ errno };
+            ::close(fd);
+            throw std::runtime_error("Could not map `" + path + "`: " + std::strerror(error));
+        }
+
+        data_ = static_cast<const unsigned char*>(data);
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+            data_{ std::exchange(other.data_, nullptr) }, size_{ std::exchange(other.size_, 0) }
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        unmap();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+void MappedFile::adviseRandomAccess() const
+{
+    if (data_ != nullptr)
+    {
+        ::madvise(const_cast<unsigned char*>(data_), size_, MADV_RANDOM);
+    }
+}
+
+void MappedFile::unmap()
+{
+    if (data_ != nullptr)
+    {
+        ::munmap(const_cast<unsigned char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
@@ -0,0 +1,201 @@
+#include <opening_book.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+#include <move_generator.h>
+#include <negamax_solver.h>
+#include <zobrist.h>
+
+namespace
+{
+
+constexpr char kMagic[8]{ 'M', 'N', 'C', 'L', 'B', 'O', 'O', 'K' };
+
+struct FileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t num_pits;
+    std::uint64_t num_entries;
+};
+
+struct BookPosition
+{
+    Position position;
+    std::uint64_t key;
+};
+
+//! Collects every unfinished position up to `num_plies` turns from the root, once per canonical form, in increasing ply.
+//! The search is breadth-first, so every position is expanded from the shallowest ply where it is reached.
+std::vector<BookPosition> collectPositions(const BoardState& board_state, const std::size_t active_player_index,
+                                           const std::size_t num_plies)
+{
+    const GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, active_player_index };
+    if (game_mechanics_executor.isGameFinished(board_state))
+    {
+        return {};
+    }
+
+    std::vector<BookPosition> positions{};
+    std::unordered_set<std::uint64_t> visited_keys{};
+
+    std::vector<Position> layer{ Position{ board_state, active_player_index } };
+    const std::uint64_t root_key{ ZobristHasher::hashPits(board_state, active_player_index) };
+    visited_keys.insert(root_key);
+    positions.push_back(BookPosition{ layer.front(), root_key });
+
+    const MoveGenerator move_generator{};
+    std::vector<ExpandedChild> children{};
+    for (std::size_t ply = 1; (ply <= num_plies) && !layer.empty(); ++ply)
+    {
+        children.clear();
+        move_generator.expandBatch(layer, children);
+
+        std::vector<Position> next_layer{};
+        for (const ExpandedChild& child : children)
+        {
+            const std::size_t parent_active_player_index{ layer[child.parent_index].active_player_index };
+            const Position position{ child.board_state,
+                                     child.result.ended_in_bank ? parent_active_player_index : (1 - parent_active_player_index) };
+            if (game_mechanics_executor.isGameFinished(position.board_state))
+            {
+                continue;
+            }
+
+            const std::uint64_t key{ ZobristHasher::hashPits(position.board_state, position.active_player_index) };
+            if (visited_keys.insert(key).second)
+            {
+                next_layer.push_back(position);
+                positions.push_back(BookPosition{ position, key });
+            }
+        }
+
+        layer = std::move(next_layer);
+    }
+
+    return positions;
+}
+
+} // namespace
+
+OpeningBook::OpeningBook(const std::size_t num_pits) :
+            num_pits_{ num_pits }, num_entries_{ 0 }, built_records_{}, mapped_file_{}, records_{ nullptr }
+{
+}
+
+OpeningBook OpeningBook::build(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+                               const std::size_t num_plies, const std::size_t num_threads,
+                               const std::size_t transposition_table_size_bytes)
+{
+    std::vector<BookPosition> positions{ collectPositions(board_state, game_mechanics_executor.getActivePlayerIndex(), num_plies) };
+
+    // Positions come out in increasing ply, and the deepest ones are solved first
+    std::reverse(positions.begin(), positions.end());
+
+    OpeningBook book{ board_state.getNumPits() };
+    book.built_records_.reserve(positions.size());
+
+    NegamaxSolver solver{ transposition_table_size_bytes, num_threads };
+    for (const BookPosition& book_position : positions)
+    {
+        const BoardState& position_board_state{ book_position.position.board_state };
+        const std::size_t active_player_index{ book_position.position.active_player_index };
+        const GameMechanicsExecutor position_game_mechanics_executor{ TurnExecutor{}, active_player_index };
+
+        const NegamaxResult result{ solver.solve(position_board_state, position_game_mechanics_executor) };
+
+        Record record{};
+        record.key = book_position.key;
+        record.value = static_cast<std::int16_t>(result.value - NegamaxSolver::getBankDifferential(position_board_state, active_player_index));
+        record.best_pit_index = static_cast<std::uint8_t>(result.best_pit_index.value());
+        book.built_records_.push_back(record);
+    }
+
+    std::sort(book.built_records_.begin(), book.built_records_.end(), [](const Record& lhs, const Record& rhs)
+    {
+        return lhs.key < rhs.key;
+    });
+    book.num_entries_ = book.built_records_.size();
+    book.records_ = book.built_records_.data();
+
+    return book;
+}
+
+OpeningBook OpeningBook::load(const std::string& path)
+{
+    MappedFile mapped_file{ path };
+
+    FileHeader header{};
+    if (mapped_file.getSize() >= sizeof(header))
+    {
+        std::memcpy(&header, mapped_file.getData(), sizeof(header));
+    }
+    if ((mapped_file.getSize() < kMappedFilePageSize) || (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) ||
+        (header.version != kFormatVersion) || (header.num_pits == 0) || (header.num_pits > kMaxNumPits))
+    {
+        throw std::runtime_error("`" + path + "` is not a supported opening book");
+    }
+    if (((mapped_file.getSize() - kMappedFilePageSize) / sizeof(Record)) < header.num_entries)
+    {
+        throw std::runtime_error("Opening book `" + path + "` is truncated");
+    }
+
+    OpeningBook book{ header.num_pits };
+    book.num_entries_ = header.num_entries;
+
+    // Binary searches touch a handful of scattered pages
+    mapped_file.adviseRandomAccess();
+    book.records_ = reinterpret_cast<const Record*>(mapped_file.getData() + kMappedFilePageSize);
+    book.mapped_file_ = std::move(mapped_file);
+
+    return book;
+}
+
+void OpeningBook::save(const std::string& path) const
+{
+    std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.num_pits = static_cast<std::uint32_t>(num_pits_);
+    header.num_entries = num_entries_;
+
+    // Pad the header to a full page so the records start page-aligned
+    std::vector<char> header_page(kMappedFilePageSize, 0);
+    std::memcpy(header_page.data(), &header, sizeof(header));
+
+    file.write(header_page.data(), static_cast<std::streamsize>(header_page.size()));
+    file.write(reinterpret_cast<const char*>(records_), static_cast<std::streamsize>(num_entries_ * sizeof(Record)));
+    if (!file)
+    {
+        throw std::runtime_error("Could not write opening book `" + path + "`");
+    }
+}
+
+std::optional<OpeningBookEntry> OpeningBook::probe(const BoardState& board_state, const std::size_t active_player_index) const
+{
+    if (board_state.getNumPits() != num_pits_)
+    {
+        return std::nullopt;
+    }
+
+    const std::uint64_t key{ ZobristHasher::hashPits(board_state, active_player_index) };
+    const Record* const end{ records_ + num_entries_ };
+    const Record* const record{ std::lower_bound(records_, end, key, [](const Record& lhs, const std::uint64_t rhs)
+    {
+        return lhs.key < rhs;
+    }) };
+    if ((record == end) || (record->key != key))
+    {
+        return std::nullopt;
+    }
+
+    return OpeningBookEntry{ record->best_pit_index,
+                             record->value + NegamaxSolver::getBankDifferential(board_state, active_player_index) };
+}
@@ -0,0 +1,482 @@
+#include <perft.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+
+#include <move_generator.h>
+#include <negamax_solver.h>
+#include <reference_turn_executor.h>
+#include <work_stealing_pool.h>
+#include <zobrist.h>
+
+namespace
+{
+
+//! A parallel bulk count expands the root until there are this many subtrees per thread, for load balancing
+constexpr std::size_t kMinSubtreesPerThread{ 16 };
+
+//! Kalah with only the capture rule flipped. `FlippedKalahRules` sows into the opposing bank, which `MoveGenerator`
+//! leaves to the scalar kernel, so this is what checks the capture rule in the vectorized kernel.
+struct CapturesFromEmptyPitKalahRules : KalahRules
+{
+    static constexpr bool kCapturesFromEmptyOpposingPit{ true };
+};
+
+void countPositionsFrom(BoardState& board_state, GameMechanicsExecutor& game_mechanics_executor, const std::size_t ply,
+                        const std::size_t depth, const bool count_unique_positions, PerftResult& result,
+                        std::vector<std::unordered_set<std::uint64_t>>& unique_positions)
+{
+    ++result.num_positions[ply];
+    if (count_unique_positions)
+    {
+        unique_positions[ply].insert(ZobristHasher::hash(board_state, game_mechanics_executor.getActivePlayerIndex()));
+    }
+
+    if (game_mechanics_executor.isGameFinished(board_state))
+    {
+        ++result.num_finished_games[ply];
+        return;
+    }
+
+    if (ply == depth)
+    {
+        return;
+    }
+
+    for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+    {
+        MoveUndo undo{};
+        if (game_mechanics_executor.makeMove(i, board_state, undo))
+        {
+            countPositionsFrom(board_state, game_mechanics_executor, ply + 1, depth, count_unique_positions, result,
+                               unique_positions);
+            game_mechanics_executor.unmakeMove(undo, board_state);
+        }
+    }
+}
+
+std::size_t getNumLegalMoves(const BoardState& board_state, const std::size_t active_player_index)
+{
+    const SinglePlayerBoardState& active_player_board_state{ (active_player_index == 0) ? board_state.getPlayer0BoardState()
+                                                                                      : board_state.getPlayer1BoardState() };
+
+    std::size_t num_legal_moves{ 0 };
+    for (std::size_t i = 0; i < active_player_board_state.getNumPits(); ++i)
+    {
+        num_legal_moves += (active_player_board_state.getNumStonesInPitUnchecked(i) > 0) ? 1 : 0;
+    }
+
+    return num_legal_moves;
+}
+
+//! Counts the descendants of a position already counted at `ply`
+void bulkCountDescendants(BoardState& board_state, GameMechanicsExecutor& game_mechanics_executor, const std::size_t ply,
+                          const std::size_t depth, std::vector<std::uint64_t>& num_positions)
+{
+    if ((ply == depth) || game_mechanics_executor.isGameFinished(board_state))
+    {
+        return;
+    }
+
+    if ((ply + 1) == depth)
+    {
+        num_positions[depth] += getNumLegalMoves(board_state, game_mechanics_executor.getActivePlayerIndex());
+        return;
+    }
+
+    for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+    {
+        MoveUndo undo{};
+        if (game_mechanics_executor.makeMove(i, board_state, undo))
+        {
+            ++num_positions[ply + 1];
+            bulkCountDescendants(board_state, game_mechanics_executor, ply + 1, depth, num_positions);
+            game_mechanics_executor.unmakeMove(undo, board_state);
+        }
+    }
+}
+
+bool isSameBoard(const SinglePlayerBoardState& lhs, const SinglePlayerBoardState& rhs)
+{
+    if ((lhs.getNumPits() != rhs.getNumPits()) || (lhs.getNumStonesInBank() != rhs.getNumStonesInBank()) ||
+        (lhs.sumOfStonesInPits() != rhs.sumOfStonesInPits()))
+    {
+        return false;
+    }
+
+    int num_stones_in_pits{ 0 };
+    for (std::size_t i = 0; i < lhs.getNumPits(); ++i)
+    {
+        if (lhs.getNumStonesInPit(i) != rhs.getNumStonesInPit(i))
+        {
+            return false;
+        }
+        num_stones_in_pits += lhs.getNumStonesInPit(i);
+    }
+
+    // Also catches a stale running total, which the comparison above would miss if both kernels got it wrong the same way
+    return num_stones_in_pits == lhs.sumOfStonesInPits();
+}
+
+bool isSameBoard(const BoardState& lhs, const BoardState& rhs)
+{
+    return isSameBoard(lhs.getPlayer0BoardState(), rhs.getPlayer0BoardState()) &&
+           isSameBoard(lhs.getPlayer1BoardState(), rhs.getPlayer1BoardState());
+}
+
+bool isSameResult(const TurnResult& lhs, const TurnResult& rhs)
+{
+    return (lhs.valid == rhs.valid) && (lhs.ended_in_bank == rhs.ended_in_bank);
+}
+
+[[noreturn]] void throwMismatch(const char* kernel_name, const BoardState& board_state, const std::size_t player_index,
+                                const std::size_t pit_index)
+{
+    std::stringstream msg{};
+    msg << "`" << kernel_name << "` disagrees with `ReferenceTurnExecutor` for player " << player_index << ", pit "
+        << pit_index << " on board:\n" << board_state.printForPlayer0();
+
+    throw std::runtime_error(msg.str());
+}
+
+//! Checks that the scoring of a finished game matches the banks after `finalize()`
+template <typename Rules>
+void verifyFinishedGame(const BoardState& board_state, const BasicGameMechanicsExecutor<Rules>& game_mechanics_executor)
+{
+    BoardState final_board_state{ board_state };
+    game_mechanics_executor.finalize(final_board_state);
+    const int final_bank_differential{ final_board_state.getPlayer0BoardState().getNumStonesInBank() -
+                                       final_board_state.getPlayer1BoardState().getNumStonesInBank() };
+    const std::size_t winner_player_index{ (final_bank_differential > 0) ? 0U : ((final_bank_differential < 0) ? 1U : 2U) };
+    if ((final_board_state.getPlayer0BoardState().sumOfStonesInPits() != 0) ||
+        (final_board_state.getPlayer1BoardState().sumOfStonesInPits() != 0) ||
+        (BasicGameMechanicsExecutor<Rules>::getFinalBankDifferential(board_state, /*player_index*/ 0) != final_bank_differential) ||
+        (game_mechanics_executor.getWinnerPlayerIndex(board_state) != winner_player_index))
+    {
+        std::stringstream msg{};
+        msg << "Scoring disagrees with `GameMechanicsExecutor::finalize()` on board:\n" << board_state.printForPlayer0();
+
+        throw std::runtime_error(msg.str());
+    }
+}
+
+template <typename Rules>
+void verifyPositionsFrom(BoardState& board_state, BasicGameMechanicsExecutor<Rules>& game_mechanics_executor, const std::size_t ply,
+                         const std::size_t depth, PerftResult& result, std::vector<ExpandedChild>& children)
+{
+    ++result.num_positions[ply];
+    if (game_mechanics_executor.isGameFinished(board_state))
+    {
+        ++result.num_finished_games[ply];
+        verifyFinishedGame(board_state, game_mechanics_executor);
+        return;
+    }
+
+    if (ply == depth)
+    {
+        return;
+    }
+
+    const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
+    const BasicTurnExecutor<Rules> turn_executor{};
+    const BasicReferenceTurnExecutor<Rules> reference_turn_executor{};
+    const BasicMoveGenerator<Rules> move_generator{};
+
+    // Shared by the whole recursion, this node's children live after everything its ancestors appended
+    const std::size_t first_child{ children.size() };
+    move_generator.expand(board_state, active_player_index, children);
+    const std::size_t end_child{ children.size() };
+
+    std::size_t n{ first_child };
+    for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+    {
+        BoardState reference_board_state{ board_state };
+        const TurnResult reference_result{ reference_turn_executor.playTurn(active_player_index, i, reference_board_state) };
+
+        BoardState fast_board_state{ board_state };
+        if (!isSameResult(turn_executor.playTurn(active_player_index, i, fast_board_state), reference_result) ||
+            !isSameBoard(fast_board_state, reference_board_state))
+        {
+            throwMismatch("TurnExecutor::playTurn()", board_state, active_player_index, i);
+        }
+
+        if (reference_result.valid)
+        {
+            if ((n == end_child) || (children[n].pit_index != i) || !isSameResult(children[n].result, reference_result) ||
+                !isSameBoard(children[n].board_state, reference_board_state))
+            {
+                throwMismatch("MoveGenerator::expand()", board_state, active_player_index, i);
+            }
+            ++n;
+        }
+
+        const BoardState original_board_state{ board_state };
+        MoveUndo undo{};
+        if (game_mechanics_executor.makeMove(i, board_state, undo) != reference_result.valid)
+        {
+            throwMismatch("TurnExecutor::makeMove()", original_board_state, active_player_index, i);
+        }
+        if (!reference_result.valid)
+        {
+            continue;
+        }
+        if (!isSameResult(undo.result, reference_result) || !isSameBoard(board_state, reference_board_state))
+        {
+            throwMismatch("TurnExecutor::makeMove()", original_board_state, active_player_index, i);
+        }
+
+        verifyPositionsFrom(board_state, game_mechanics_executor, ply + 1, depth, result, children);
+
+        game_mechanics_executor.unmakeMove(undo, board_state);
+        if (!isSameBoard(board_state, original_board_state) || (game_mechanics_executor.getActivePlayerIndex() != active_player_index))
+        {
+            throwMismatch("TurnExecutor::unmakeMove()", original_board_state, active_player_index, i);
+        }
+    }
+
+    if (n != end_child)
+    {
+        throwMismatch("MoveGenerator::expand()", board_state, active_player_index, board_state.getNumPits());
+    }
+    children.erase(children.begin() + static_cast<std::ptrdiff_t>(first_child), children.end());
+}
+
+//! Exact final bank differential for the player to move, by plain minimax over `BasicReferenceTurnExecutor` without
+//! pruning or a transposition table
+template <typename Rules>
+int solveByBruteForce(const BoardState& board_state, const std::size_t active_player_index)
+{
+    const BasicGameMechanicsExecutor<Rules> game_mechanics_executor{ BasicTurnExecutor<Rules>{}, active_player_index };
+    if (game_mechanics_executor.isGameFinished(board_state))
+    {
+        return BasicGameMechanicsExecutor<Rules>::getFinalBankDifferential(board_state, active_player_index);
+    }
+
+    const BasicReferenceTurnExecutor<Rules> reference_turn_executor{};
+    int best_value{ std::numeric_limits<int>::min() };
+    for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+    {
+        BoardState board_state_i{ board_state };
+        const TurnResult result{ reference_turn_executor.playTurn(active_player_index, i, board_state_i) };
+        if (!result.valid)
+        {
+            continue;
+        }
+
+        const int value{ result.ended_in_bank ? solveByBruteForce<Rules>(board_state_i, active_player_index)
+                                              : -solveByBruteForce<Rules>(board_state_i, 1 - active_player_index) };
+        best_value = std::max(best_value, value);
+    }
+
+    return best_value;
+}
+
+[[noreturn]] void throwSolveMismatch(const char* what, const BoardState& board_state, const std::size_t player_index,
+                                     const int value, const int brute_force_value)
+{
+    std::stringstream msg{};
+    msg << "`BasicNegamaxSolver` " << what << " is " << value << " for player " << player_index << ", but the brute force value is "
+        << brute_force_value << " on board:\n" << board_state.printForPlayer0();
+
+    throw std::runtime_error(msg.str());
+}
+
+PerftResult makeEmptyResult(const std::size_t depth, const bool count_unique_positions, const bool count_finished_games)
+{
+    PerftResult result{};
+    result.num_positions.assign(depth + 1, 0);
+    if (count_unique_positions)
+    {
+        result.num_unique_positions.assign(depth + 1, 0);
+    }
+    if (count_finished_games)
+    {
+        result.num_finished_games.assign(depth + 1, 0);
+    }
+
+    return result;
+}
+
+} // namespace
+
+PerftResult Perft::run(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor, const std::size_t depth,
+                       const bool count_unique_positions)
+{
+    PerftResult result{ makeEmptyResult(depth, count_unique_positions, /*count_finished_games*/ true) };
+    std::vector<std::unordered_set<std::uint64_t>> unique_positions(count_unique_positions ? (depth + 1) : 0);
+
+    BoardState search_board_state{ board_state };
+    GameMechanicsExecutor search_game_mechanics_executor{ game_mechanics_executor };
+    countPositionsFrom(search_board_state, search_game_mechanics_executor, /*ply*/ 0, depth, count_unique_positions, result,
+                       unique_positions);
+
+    for (std::size_t ply = 0; ply < unique_positions.size(); ++ply)
+    {
+        result.num_unique_positions[ply] = unique_positions[ply].size();
+    }
+
+    return result;
+}
+
+PerftResult Perft::runBulk(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+                           const std::size_t depth, const std::size_t num_threads)
+{
+    PerftResult result{ makeEmptyResult(depth, /*count_unique_positions*/ false, /*count_finished_games*/ false) };
+    result.num_positions[0] = 1;
+
+    if (num_threads <= 1)
+    {
+        BoardState search_board_state{ board_state };
+        GameMechanicsExecutor search_game_mechanics_executor{ game_mechanics_executor };
+        bulkCountDescendants(search_board_state, search_game_mechanics_executor, /*ply*/ 0, depth, result.num_positions);
+
+        return result;
+    }
+
+    // Expand breadth-first until there are enough subtrees to keep every thread busy. Finished games are counted but
+    // not kept in the frontier.
+    const MoveGenerator move_generator{};
+    std::vector<Position> frontier{};
+    if (!game_mechanics_executor.isGameFinished(board_state))
+    {
+        frontier.push_back(Position{ board_state, game_mechanics_executor.getActivePlayerIndex() });
+    }
+
+    std::size_t frontier_ply{ 0 };
+    std::vector<ExpandedChild> children{};
+    while (!frontier.empty() && ((frontier_ply + 1) < depth) && (frontier.size() < (kMinSubtreesPerThread * num_threads)))
+    {
+        children.clear();
+        result.num_positions[frontier_ply + 1] += move_generator.expandBatch(frontier, children);
+
+        std::vector<Position> next_frontier{};
+        for (const ExpandedChild& child : children)
+        {
+            const std::size_t parent_active_player_index{ frontier[child.parent_index].active_player_index };
+            const Position position{ child.board_state,
+                                     child.result.ended_in_bank ? parent_active_player_index : (1 - parent_active_player_index) };
+
+            const GameMechanicsExecutor child_game_mechanics_executor{ TurnExecutor{}, position.active_player_index };
+            if (!child_game_mechanics_executor.isGameFinished(position.board_state))
+            {
+                next_frontier.push_back(position);
+            }
+        }
+
+        frontier = std::move(next_frontier);
+        ++frontier_ply;
+    }
+
+    std::mutex result_mutex{};
+    std::atomic<std::size_t> num_pending_subtrees{ frontier.size() };
+    WorkStealingPool pool{ num_threads };
+    for (const Position& position : frontier)
+    {
+        pool.push(/*worker_index*/ 0, [&result, &result_mutex, &num_pending_subtrees, position, frontier_ply, depth](std::size_t)
+        {
+            BoardState subtree_board_state{ position.board_state };
+            GameMechanicsExecutor subtree_game_mechanics_executor{ TurnExecutor{}, position.active_player_index };
+            std::vector<std::uint64_t> num_positions(depth + 1, 0);
+            bulkCountDescendants(subtree_board_state, subtree_game_mechanics_executor, frontier_ply, depth, num_positions);
+
+            {
+                std::lock_guard<std::mutex> lock{ result_mutex };
+                for (std::size_t ply = 0; ply <= depth; ++ply)
+                {
+                    result.num_positions[ply] += num_positions[ply];
+                }
+            }
+
+            num_pending_subtrees.fetch_sub(1);
+        });
+    }
+
+    while (num_pending_subtrees.load() > 0)
+    {
+        if (!pool.runPendingTask(/*worker_index*/ 0))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    return result;
+}
+
+PerftResult Perft::verify(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+                          const std::size_t depth)
+{
+    PerftResult result{ makeEmptyResult(depth, /*count_unique_positions*/ false, /*count_finished_games*/ true) };
+
+    BoardState search_board_state{ board_state };
+    GameMechanicsExecutor search_game_mechanics_executor{ game_mechanics_executor };
+    std::vector<ExpandedChild> children{};
+    verifyPositionsFrom(search_board_state, search_game_mechanics_executor, /*ply*/ 0, depth, result, children);
+
+    return result;
+}
+
+PerftResult Perft::verifyRuleVariant(const BoardState& board_state, const std::size_t depth)
+{
+    PerftResult result{ makeEmptyResult(depth, /*count_unique_positions*/ false, /*count_finished_games*/ true) };
+
+    BoardState search_board_state{ board_state };
+    BasicGameMechanicsExecutor<FlippedKalahRules> search_game_mechanics_executor{ BasicTurnExecutor<FlippedKalahRules>{} };
+    std::vector<ExpandedChild> children{};
+    verifyPositionsFrom(search_board_state, search_game_mechanics_executor, /*ply*/ 0, depth, result, children);
+
+    PerftResult capture_result{ makeEmptyResult(depth, /*count_unique_positions*/ false, /*count_finished_games*/ true) };
+    BoardState capture_board_state{ board_state };
+    BasicGameMechanicsExecutor<CapturesFromEmptyPitKalahRules> capture_game_mechanics_executor{
+        BasicTurnExecutor<CapturesFromEmptyPitKalahRules>{} };
+    verifyPositionsFrom(capture_board_state, capture_game_mechanics_executor, /*ply*/ 0, depth, capture_result, children);
+
+    return result;
+}
+
+int Perft::verifyRuleVariantSolve(const BoardState& board_state, const std::size_t transposition_table_size_bytes)
+{
+    const BasicGameMechanicsExecutor<FlippedKalahRules> game_mechanics_executor{ BasicTurnExecutor<FlippedKalahRules>{} };
+    const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
+    BasicNegamaxSolver<FlippedKalahRules> solver{ transposition_table_size_bytes };
+
+    const NegamaxResult result{ solver.solve(board_state, game_mechanics_executor) };
+    const int brute_force_value{ solveByBruteForce<FlippedKalahRules>(board_state, active_player_index) };
+    if (result.value != brute_force_value)
+    {
+        throwSolveMismatch("value", board_state, active_player_index, result.value, brute_force_value);
+    }
+
+    // Every root move is solved on its own too, and the best move has to achieve the root value
+    for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+    {
+        BoardState board_state_i{ board_state };
+        BasicGameMechanicsExecutor<FlippedKalahRules> game_mechanics_executor_i{ game_mechanics_executor };
+        if (!game_mechanics_executor_i.playTurn(i, board_state_i))
+        {
+            continue;
+        }
+
+        const std::size_t active_player_index_i{ game_mechanics_executor_i.getActivePlayerIndex() };
+        const NegamaxResult result_i{ solver.solve(board_state_i, game_mechanics_executor_i) };
+        const int brute_force_value_i{ solveByBruteForce<FlippedKalahRules>(board_state_i, active_player_index_i) };
+        if (result_i.value != brute_force_value_i)
+        {
+            throwSolveMismatch("value", board_state_i, active_player_index_i, result_i.value, brute_force_value_i);
+        }
+
+        const int root_value_i{ (active_player_index_i == active_player_index) ? brute_force_value_i : -brute_force_value_i };
+        if ((result.best_pit_index == i) && (root_value_i != brute_force_value))
+        {
+            throwSolveMismatch("best move value", board_state, active_player_index, root_value_i, brute_force_value);
+        }
+    }
+
+    return result.value;
+}
@@ -0,0 +1,197 @@
+#include <position_indexer.h>
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+PositionIndexer::PositionIndexer(const std::size_t num_pits, const int max_stones) :
+            num_pits_{ num_pits }, num_cells_{ 2 * num_pits }, max_stones_{ max_stones }
+{
+    if ((num_pits == 0) || (num_pits > kMaxNumPits))
+    {
+        std::stringstream msg{};
+        msg << "Number of pits (" << num_pits << ") must be in the range [1-" << kMaxNumPits << "]";
+
+        throw std::invalid_argument(msg.str());
+    }
+
+    if ((max_stones < 0) || (max_stones > kMaxNumStones))
+    {
+        std::stringstream msg{};
+        msg << "Maximum number of stones (" << max_stones << ") must be in the range [0-" << kMaxNumStones << "]";
+
+        throw std::invalid_argument(msg.str());
+    }
+
+    // Pascal's triangle, saturating instead of wrapping around
+    constexpr std::uint64_t kSaturated{ std::numeric_limits<std::uint64_t>::max() };
+    const std::size_t num_rows{ static_cast<std::size_t>(max_stones) + num_cells_ };
+    binomials_.assign(num_rows * num_cells_, 0);
+    for (std::size_t n = 0; n < num_rows; ++n)
+    {
+        binomials_[n * num_cells_] = 1;
+        for (std::size_t k = 1; (k <= n) && (k < num_cells_); ++k)
+        {
+            const std::uint64_t a{ binomials_[(n - 1) * num_cells_ + k - 1] };
+            const std::uint64_t b{ binomials_[(n - 1) * num_cells_ + k] };
+            binomials_[n * num_cells_ + k] = (a > (kSaturated - b)) ? kSaturated : (a + b);
+        }
+    }
+
+    // Every term of a rank is at most the number of distributions, so this bounds all of them
+    if (getNumDistributions(max_stones) == kSaturated)
+    {
+        throw std::overflow_error("Too many distributions of " + std::to_string(max_stones) + " stones over " +
+                                  std::to_string(num_cells_) + " pits to rank");
+    }
+
+    std::uint64_t num_positions{ 0 };
+    for (int s = 0; s <= max_stones; ++s)
+    {
+        position_offsets_.push_back(num_positions);
+
+        const std::uint64_t num_pits_positions{ getNumDistributions(s) };
+        const std::uint64_t num_positions_per_distribution{ 2 * getNumBankSplits(s) };
+        if ((num_pits_positions > ((kSaturated - num_positions) / num_positions_per_distribution)))
+        {
+            positions_overflow_ = true;
+            break;
+        }
+        num_positions += num_pits_positions * num_positions_per_distribution;
+    }
+    position_offsets_.push_back(num_positions);
+}
+
+std::uint64_t PositionIndexer::countDistributions(const int num_stones, const std::size_t num_cells)
+{
+    if (num_stones < 0)
+    {
+        return 0;
+    }
+    if (num_cells == 0)
+    {
+        return (num_stones == 0) ? 1 : 0;
+    }
+
+    // Multiplicative formula for C(n, k) with k = num_cells - 1, exact at every step
+    const std::uint64_t n{ static_cast<std::uint64_t>(num_stones) + num_cells - 1 };
+    const std::uint64_t k{ std::min<std::uint64_t>(num_cells - 1, static_cast<std::uint64_t>(num_stones)) };
+    std::uint64_t result{ 1 };
+    for (std::uint64_t i = 1; i <= k; ++i)
+    {
+        const std::uint64_t factor{ n - k + i };
+        if (result > (std::numeric_limits<std::uint64_t>::max() / factor))
+        {
+            throw std::overflow_error("Too many distributions of " + std::to_string(num_stones) + " stones over " +
+                                      std::to_string(num_cells) + " pits to count");
+        }
+        result = (result * factor) / i;
+    }
+
+    return result;
+}
+
+PositionIndexer::Cells PositionIndexer::unrankCells(std::uint64_t rank, const int num_stones) const
+{
+    // Greedily take the largest bar position whose term still fits, from the last bar down
+    std::array<std::size_t, 2 * kMaxNumPits> bars{};
+    std::size_t bar{ static_cast<std::size_t>(num_stones) + num_cells_ - 2 };
+    for (std::size_t j = num_cells_ - 1; j-- > 0;)
+    {
+        while (getBinomial(bar, j + 1) > rank)
+        {
+            --bar;
+        }
+        rank -= getBinomial(bar, j + 1);
+        bars[j] = bar--;
+    }
+
+    Cells cells{};
+    cells[0] = static_cast<std::uint8_t>(bars[0]);
+    for (std::size_t j = 1; (j + 1) < num_cells_; ++j)
+    {
+        cells[j] = static_cast<std::uint8_t>(bars[j] - bars[j - 1] - 1);
+    }
+    cells[num_cells_ - 1] = static_cast<std::uint8_t>(static_cast<std::size_t>(num_stones) + num_cells_ - 2 - bars[num_cells_ - 2]);
+
+    return cells;
+}
+
+PositionIndexer::Cells PositionIndexer::getCells(const BoardState& board_state)
+{
+    const std::size_t num_pits{ board_state.getNumPits() };
+
+    Cells cells{};
+    for (std::size_t i = 0; i < num_pits; ++i)
+    {
+        cells[i] = static_cast<std::uint8_t>(board_state.getPlayer0BoardState().getNumStonesInPitUnchecked(i));
+        cells[num_pits + i] = static_cast<std::uint8_t>(board_state.getPlayer1BoardState().getNumStonesInPitUnchecked(i));
+    }
+
+    return cells;
+}
+
+std::uint64_t PositionIndexer::getNumPositions() const
+{
+    checkPositionsCountable();
+
+    return position_offsets_.back();
+}
+
+std::uint64_t PositionIndexer::getIndex(const BoardState& board_state, const std::size_t active_player_index) const
+{
+    checkPositionsCountable();
+
+    const SinglePlayerBoardState& player_0_board_state{ board_state.getPlayer0BoardState() };
+    const SinglePlayerBoardState& player_1_board_state{ board_state.getPlayer1BoardState() };
+    const int num_stones_in_pits{ player_0_board_state.sumOfStonesInPits() + player_1_board_state.sumOfStonesInPits() };
+    if ((board_state.getNumPits() != num_pits_) ||
+        ((num_stones_in_pits + player_0_board_state.getNumStonesInBank() + player_1_board_state.getNumStonesInBank()) != max_stones_))
+    {
+        std::stringstream msg{};
+        msg << "Only boards with " << num_pits_ << " pits and " << max_stones_ << " stones can be indexed";
+
+        throw std::invalid_argument(msg.str());
+    }
+
+    const std::uint64_t pits_rank{ rankCells(getCells(board_state)) };
+
+    return position_offsets_[static_cast<std::size_t>(num_stones_in_pits)] +
+           (((pits_rank * getNumBankSplits(num_stones_in_pits)) + player_0_board_state.getNumStonesInBank()) * 2) +
+           active_player_index;
+}
+
+Position PositionIndexer::getPosition(const std::uint64_t index) const
+{
+    if (index >= getNumPositions())
+    {
+        throw std::out_of_range("Position index " + std::to_string(index) + " is out of range");
+    }
+
+    const int num_stones_in_pits{ static_cast<int>(
+        std::upper_bound(position_offsets_.begin(), position_offsets_.end(), index) - position_offsets_.begin()) - 1 };
+    const std::uint64_t num_bank_splits{ getNumBankSplits(num_stones_in_pits) };
+
+    std::uint64_t within_layer{ index - position_offsets_[static_cast<std::size_t>(num_stones_in_pits)] };
+    const std::size_t active_player_index{ static_cast<std::size_t>(within_layer % 2) };
+    within_layer /= 2;
+    const int player_0_bank{ static_cast<int>(within_layer % num_bank_splits) };
+    const Cells cells{ unrankCells(within_layer / num_bank_splits, num_stones_in_pits) };
+
+    std::vector<int> player_0_pits(cells.begin(), cells.begin() + num_pits_);
+    std::vector<int> player_1_pits(cells.begin() + num_pits_, cells.begin() + num_cells_);
+
+    return Position{ BoardState{ SinglePlayerBoardState{ player_0_pits, player_0_bank },
+                                 SinglePlayerBoardState{ player_1_pits, max_stones_ - num_stones_in_pits - player_0_bank } },
+                     active_player_index };
+}
+
+void PositionIndexer::checkPositionsCountable() const
+{
+    if (positions_overflow_)
+    {
+        throw std::overflow_error("Too many positions with " + std::to_string(max_stones_) + " stones over " +
+                                  std::to_string(num_pits_) + " pits per side to index");
+    }
+}
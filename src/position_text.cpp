@@ -0,0 +1,79 @@
+#include <position_text.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+Position parseTextPosition(const std::string& text)
+{
+    std::istringstream stream{ text };
+    std::vector<int> values{};
+    std::string token{};
+    while (stream >> token)
+    {
+        std::size_t num_parsed_chars{ 0 };
+        int value{ 0 };
+        try
+        {
+            value = std::stoi(token, &num_parsed_chars);
+        }
+        catch (const std::logic_error&)
+        {
+        }
+        if ((num_parsed_chars == 0) || (num_parsed_chars != token.size()))
+        {
+            throw std::invalid_argument("`" + token + "` is not an integer");
+        }
+        values.push_back(value);
+    }
+
+    // Player to move, then `num_pits + 1` values for each player
+    if ((values.size() < 5) || ((values.size() % 2) == 0))
+    {
+        throw std::invalid_argument("Expected the player to move followed by the pits and bank of each player");
+    }
+    if ((values[0] != 0) && (values[0] != 1))
+    {
+        throw std::invalid_argument("Player to move must be 0 or 1");
+    }
+
+    const std::size_t num_pits{ (values.size() - 1) / 2 - 1 };
+    const auto player_begin{ [&](const std::size_t player_index) { return values.begin() + 1 + player_index * (num_pits + 1); } };
+
+    return Position{ BoardState{ SinglePlayerBoardState{ std::vector<int>(player_begin(0), player_begin(0) + num_pits), *(player_begin(0) + num_pits) },
+                                 SinglePlayerBoardState{ std::vector<int>(player_begin(1), player_begin(1) + num_pits), *(player_begin(1) + num_pits) } },
+                     static_cast<std::size_t>(values[0]) };
+}
+
+std::string formatTextPosition(const Position& position)
+{
+    std::ostringstream stream{};
+    stream << position.active_player_index;
+    for (const SinglePlayerBoardState* single_player_board_state :
+         { &position.board_state.getPlayer0BoardState(), &position.board_state.getPlayer1BoardState() })
+    {
+        for (std::size_t i = 0; i < position.board_state.getNumPits(); ++i)
+        {
+            stream << " " << single_player_board_state->getNumStonesInPitUnchecked(i);
+        }
+        stream << " " << single_player_board_state->getNumStonesInBank();
+    }
+
+    return stream.str();
+}
+
+std::string formatTextResult(const NegamaxResult& result)
+{
+    std::ostringstream stream{};
+    if (result.best_pit_index.has_value())
+    {
+        stream << result.best_pit_index.value();
+    }
+    else
+    {
+        stream << "-";
+    }
+    stream << " " << result.value << " " << (result.proven ? 1 : 0);
+
+    return stream.str();
+}
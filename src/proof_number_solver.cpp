@@ -0,0 +1,274 @@
+#include <proof_number_solver.h>
+
+#include <algorithm>
+#include <utility>
+
+#include <zobrist.h>
+
+namespace
+{
+
+//! Spreads the targets of one position over unrelated keys
+constexpr std::uint64_t kTargetKeyMultiplier{ 0x9e3779b97f4a7c15 };
+
+std::uint32_t addSaturating(const std::uint32_t a, const std::uint32_t b)
+{
+    return (a > (std::numeric_limits<std::uint32_t>::max() - b)) ? std::numeric_limits<std::uint32_t>::max() : (a + b);
+}
+
+int getNumStonesInPits(const BoardState& board_state)
+{
+    return board_state.getPlayer0BoardState().sumOfStonesInPits() + board_state.getPlayer1BoardState().sumOfStonesInPits();
+}
+
+} // namespace
+
+ProofNumberSolver::ProofNumberSolver(const std::size_t proof_table_size_bytes, std::shared_ptr<TranspositionTable> transposition_table) :
+            transposition_table_{ std::move(transposition_table) }
+{
+    // Round down to a power of two so the bucket index is a mask of the key
+    std::size_t num_buckets{ 1 };
+    while ((num_buckets * 2 * sizeof(Bucket)) <= proof_table_size_bytes)
+    {
+        num_buckets *= 2;
+    }
+
+    buckets_.resize(num_buckets, Bucket{});
+    bucket_mask_ = num_buckets - 1;
+}
+
+ProofNumberResult ProofNumberSolver::solve(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+                                           const int target, const std::optional<std::size_t> max_nodes)
+{
+    num_nodes_ = 0;
+    max_nodes_ = max_nodes;
+
+    const BoardState canonical_board_state{ board_state.getCanonical(game_mechanics_executor.getActivePlayerIndex()) };
+    const int relative_target{ target - (canonical_board_state.getPlayer0BoardState().getNumStonesInBank() -
+                                         canonical_board_state.getPlayer1BoardState().getNumStonesInBank()) };
+
+    ProofNumberResult result{};
+    const std::optional<bool> finished_game_answer{ getFinishedGameAnswer(canonical_board_state, relative_target) };
+    if (finished_game_answer.has_value())
+    {
+        result.outcome = finished_game_answer.value() ? ProofOutcome::kProven : ProofOutcome::kDisproven;
+        return result;
+    }
+
+    std::size_t best_pit_index{ kNoBestPitIndex };
+    const ProofNumbers numbers{ search(canonical_board_state, getKey(canonical_board_state, relative_target), relative_target,
+                                       kInfinity, kInfinity, &best_pit_index) };
+    if (numbers.proof == 0)
+    {
+        result.outcome = ProofOutcome::kProven;
+        result.best_pit_index = best_pit_index;
+    }
+    else if (numbers.disproof == 0)
+    {
+        result.outcome = ProofOutcome::kDisproven;
+    }
+    result.num_nodes = num_nodes_;
+
+    return result;
+}
+
+ProofNumberSolver::ProofNumbers ProofNumberSolver::search(const BoardState& board_state, const std::uint64_t key, const int target,
+                                                          const std::uint32_t proof_threshold, const std::uint32_t disproof_threshold,
+                                                          std::size_t* best_pit_index_out)
+{
+    ++num_nodes_;
+    const std::size_t first_node{ num_nodes_ };
+
+    // Children are generated once per visit
+    const TurnExecutor turn_executor{};
+    const int bank{ board_state.getPlayer0BoardState().getNumStonesInBank() };
+    std::vector<Child> children{};
+    children.reserve(board_state.getNumPits());
+    for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+    {
+        BoardState board_state_i{ board_state };
+        const TurnResult turn_result{ turn_executor.playTurn(/*player_index*/ 0, i, board_state_i) };
+        if (!turn_result.valid)
+        {
+            continue;
+        }
+
+        // After an extra turn the mover still needs the rest of the target. Otherwise the mover reaches the target if and
+        // only if the opponent cannot get more than the stones just banked minus the target.
+        const int gain{ board_state_i.getPlayer0BoardState().getNumStonesInBank() - bank };
+        const BoardState child_board_state{ turn_result.ended_in_bank ? board_state_i : board_state_i.getMirrored() };
+        const int child_target{ turn_result.ended_in_bank ? (target - gain) : (gain - target + 1) };
+        children.push_back(Child{ child_board_state, getKey(child_board_state, child_target), child_target, turn_result.ended_in_bank,
+                                  static_cast<std::uint8_t>(i), getFinishedGameAnswer(child_board_state, child_target) });
+    }
+
+    // The numbers of a child just searched are kept from its return value rather than looked up again, since its entry
+    // may already have been replaced, which would send the search back into it forever
+    std::vector<ProofNumbers> children_numbers{};
+    children_numbers.reserve(children.size());
+    for (const Child& child : children)
+    {
+        children_numbers.push_back(lookUp(child));
+    }
+
+    while (true)
+    {
+        // The node is an OR node of its player to move: proven by any child, disproven by all of them
+        ProofNumbers numbers{ kInfinity, 0 };
+        std::uint32_t second_best_proof{ kInfinity };
+        std::uint32_t best_child_disproof{ 0 };
+        std::size_t best_child_index{ 0 };
+        for (std::size_t c = 0; c < children.size(); ++c)
+        {
+            const ProofNumbers& child_numbers{ children_numbers[c] };
+            const std::uint32_t proof{ children[c].extra_turn ? child_numbers.proof : child_numbers.disproof };
+            const std::uint32_t disproof{ children[c].extra_turn ? child_numbers.disproof : child_numbers.proof };
+
+            if (proof < numbers.proof)
+            {
+                second_best_proof = numbers.proof;
+                numbers.proof = proof;
+                best_child_disproof = disproof;
+                best_child_index = c;
+            }
+            else if (proof < second_best_proof)
+            {
+                second_best_proof = proof;
+            }
+            numbers.disproof = addSaturating(numbers.disproof, disproof);
+        }
+
+        if ((numbers.proof == 0) && (best_pit_index_out != nullptr))
+        {
+            *best_pit_index_out = children[best_child_index].pit_index;
+        }
+
+        const bool limit_reached{ max_nodes_.has_value() && (num_nodes_ >= max_nodes_.value()) };
+        if ((numbers.proof >= proof_threshold) || (numbers.disproof >= disproof_threshold) || limit_reached)
+        {
+            const std::size_t work{ num_nodes_ - first_node + 1 };
+            store(key, numbers, static_cast<std::uint32_t>(std::min<std::size_t>(work, kInfinity)));
+            if ((numbers.proof == 0) || (numbers.disproof == 0))
+            {
+                storeResult(board_state, target, numbers.proof == 0);
+            }
+
+            return numbers;
+        }
+
+        // 1 + epsilon trick: let the best child run a quarter past its sibling before switching, instead of switching as soon
+        // as it falls behind
+        const std::uint32_t child_proof_threshold{ std::min(
+            proof_threshold, addSaturating(second_best_proof, std::max<std::uint32_t>(1, second_best_proof / 4))) };
+        const std::uint32_t child_disproof_threshold{ (disproof_threshold == kInfinity)
+                                                          ? kInfinity
+                                                          : (disproof_threshold - numbers.disproof + best_child_disproof) };
+
+        const Child& child{ children[best_child_index] };
+        if (child.extra_turn)
+        {
+            children_numbers[best_child_index] =
+                search(child.board_state, child.key, child.target, child_proof_threshold, child_disproof_threshold, nullptr);
+        }
+        else
+        {
+            children_numbers[best_child_index] =
+                search(child.board_state, child.key, child.target, child_disproof_threshold, child_proof_threshold, nullptr);
+        }
+    }
+}
+
+ProofNumberSolver::ProofNumbers ProofNumberSolver::lookUp(const Child& child) const
+{
+    if (child.finished_game_answer.has_value())
+    {
+        return child.finished_game_answer.value() ? ProofNumbers{ 0, kInfinity } : ProofNumbers{ kInfinity, 0 };
+    }
+
+    const Bucket& bucket{ buckets_[child.key & bucket_mask_] };
+    for (const Entry& entry : bucket.entries)
+    {
+        if ((entry.key == child.key) && (entry.work != 0))
+        {
+            return entry.numbers;
+        }
+    }
+
+    if (transposition_table_ != nullptr)
+    {
+        const std::optional<TranspositionEntry> entry{ transposition_table_->probe(ZobristHasher::hashPits(child.board_state, 0)) };
+        if (entry.has_value() && (entry->draft == kFullDraft))
+        {
+            if (((entry->bound == Bound::kExact) || (entry->bound == Bound::kLower)) && (entry->value >= child.target))
+            {
+                return ProofNumbers{ 0, kInfinity };
+            }
+            if (((entry->bound == Bound::kExact) || (entry->bound == Bound::kUpper)) && (entry->value < child.target))
+            {
+                return ProofNumbers{ kInfinity, 0 };
+            }
+        }
+    }
+
+    return ProofNumbers{ 1, 1 };
+}
+
+void ProofNumberSolver::store(const std::uint64_t key, const ProofNumbers numbers, const std::uint32_t work)
+{
+    Bucket& bucket{ buckets_[key & bucket_mask_] };
+
+    // Empty entries have no work, so they are replaced first
+    Entry* replaced_entry{ &bucket.entries[0] };
+    for (Entry& entry : bucket.entries)
+    {
+        if (entry.key == key)
+        {
+            replaced_entry = &entry;
+            break;
+        }
+        if (entry.work < replaced_entry->work)
+        {
+            replaced_entry = &entry;
+        }
+    }
+
+    const std::uint32_t previous_work{ (replaced_entry->key == key) ? replaced_entry->work : 0 };
+    *replaced_entry = Entry{ key, numbers, addSaturating(previous_work, work) };
+}
+
+void ProofNumberSolver::storeResult(const BoardState& board_state, const int target, const bool proven) const
+{
+    if (transposition_table_ == nullptr)
+    {
+        return;
+    }
+
+    // Keep an exact value from `NegamaxSolver` rather than replace it with a bound
+    const std::uint64_t key{ ZobristHasher::hashPits(board_state, 0) };
+    const std::optional<TranspositionEntry> entry{ transposition_table_->probe(key) };
+    if (entry.has_value() && (entry->draft == kFullDraft) && (entry->bound == Bound::kExact))
+    {
+        return;
+    }
+
+    transposition_table_->store(key, proven ? target : (target - 1), proven ? Bound::kLower : Bound::kUpper, kNoBestPitIndex,
+                                static_cast<std::uint8_t>(getNumStonesInPits(board_state)));
+}
+
+std::optional<bool> ProofNumberSolver::getFinishedGameAnswer(const BoardState& board_state, const int target)
+{
+    if ((board_state.getPlayer0BoardState().sumOfStonesInPits() == 0) || (board_state.getPlayer1BoardState().sumOfStonesInPits() == 0))
+    {
+        // Only the stones still in the pits count, since the target is relative to the banks
+        const int bank_differential{ board_state.getPlayer0BoardState().getNumStonesInBank() -
+                                     board_state.getPlayer1BoardState().getNumStonesInBank() };
+        return (GameMechanicsExecutor::getFinalBankDifferential(board_state, /*player_index*/ 0) - bank_differential) >= target;
+    }
+
+    return std::nullopt;
+}
+
+std::uint64_t ProofNumberSolver::getKey(const BoardState& board_state, const int target)
+{
+    return ZobristHasher::hashPits(board_state, 0) ^ (static_cast<std::uint64_t>(static_cast<std::int64_t>(target)) * kTargetKeyMultiplier);
+}
@@ -0,0 +1,1043 @@
+#include <retrograde_solver.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <list>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <game_mechanics.h>
+#include <position_indexer.h>
+
+namespace
+{
+
+constexpr char kMagic[8]{ 'M', 'N', 'C', 'L', 'R', 'E', 'T', 'R' };
+constexpr std::uint32_t kFormatVersion{ 2 };
+
+//! Values are stored in one signed byte, and a position's value is bounded by the number of stones in its pits
+constexpr int kMaxSupportedStones{ 127 };
+
+//! Records per chunk of a layer file. Lookups decode a whole chunk, so this trades index size against decoding work.
+constexpr std::size_t kChunkNumRecords{ 4096 };
+
+//! Read-ahead for each run merged during enumeration
+constexpr std::size_t kRunReadBufferSize{ std::size_t{ 16 } << 10 };
+
+//! Encoded runs are written out in pieces of about this size
+constexpr std::size_t kRunWriteBufferSize{ std::size_t{ 1 } << 20 };
+
+using Cells = PositionIndexer::Cells;
+
+struct ManifestHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t num_pits;
+    std::uint32_t max_stones;
+    std::uint32_t reserved;
+};
+
+//! On-disk header of a chunk, followed by the deltas between consecutive keys as varints and, for value files, one value
+//! byte per record
+struct ChunkHeader
+{
+    std::uint64_t first_key;
+    std::uint32_t num_records;
+    std::uint32_t payload_size;
+};
+
+static_assert(sizeof(ChunkHeader) == 16);
+
+enum class KeyOrder
+{
+    kAscending,
+    kDescending
+};
+
+std::runtime_error makeFileError(const std::string& action, const std::string& path)
+{
+    return std::runtime_error("Could not " + action + " `" + path + "`: " + std::strerror(errno));
+}
+
+//! File descriptor with positional reads and writes, so readers and the writer of a layer never share a file offset
+class File
+{
+public:
+    File(const std::string& path, const int flags) : path_{ path }, fd_{ ::open(path.c_str(), flags | O_CLOEXEC, 0644) }
+    {
+        if (fd_ < 0)
+        {
+            throw makeFileError("open", path);
+        }
+    }
+
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    ~File()
+    {
+        ::close(fd_);
+    }
+
+    const std::string& getPath() const
+    {
+        return path_;
+    }
+
+    std::uint64_t getSize() const
+    {
+        struct stat file_status{};
+        if (::fstat(fd_, &file_status) != 0)
+        {
+            throw makeFileError("stat", path_);
+        }
+
+        return static_cast<std::uint64_t>(file_status.st_size);
+    }
+
+    void writeAt(const void* data, const std::size_t size, const std::uint64_t offset) const
+    {
+        const char* const bytes{ static_cast<const char*>(data) };
+        std::size_t num_written_bytes{ 0 };
+        while (num_written_bytes < size)
+        {
+            const ssize_t n{ ::pwrite(fd_, bytes + num_written_bytes, size - num_written_bytes,
+                                      static_cast<off_t>(offset + num_written_bytes)) };
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw makeFileError("write", path_);
+            }
+            num_written_bytes += static_cast<std::size_t>(n);
+        }
+    }
+
+    //! Reads exactly `size` bytes. Throws if the file ends first.
+    void readAt(void* data, const std::size_t size, const std::uint64_t offset) const
+    {
+        char* const bytes{ static_cast<char*>(data) };
+        std::size_t num_read_bytes{ 0 };
+        while (num_read_bytes < size)
+        {
+            const ssize_t n{ ::pread(fd_, bytes + num_read_bytes, size - num_read_bytes, static_cast<off_t>(offset + num_read_bytes)) };
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw makeFileError("read", path_);
+            }
+            if (n == 0)
+            {
+                throw std::runtime_error("`" + path_ + "` is truncated");
+            }
+            num_read_bytes += static_cast<std::size_t>(n);
+        }
+    }
+
+private:
+    std::string path_;
+    int fd_;
+};
+
+void appendVarint(std::uint64_t value, std::vector<std::uint8_t>& output)
+{
+    while (value >= 0x80)
+    {
+        output.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    output.push_back(static_cast<std::uint8_t>(value));
+}
+
+std::uint64_t readVarint(const std::uint8_t*& data, const std::uint8_t* const end)
+{
+    std::uint64_t value{ 0 };
+    for (int shift = 0; (data != end) && (shift < 64); shift += 7)
+    {
+        const std::uint8_t byte{ *data++ };
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return value;
+        }
+    }
+
+    throw std::runtime_error("Retrograde database chunk is corrupt");
+}
+
+//! Sorted, duplicate-free keys in a spill file, delta- and varint-encoded starting from `0`
+struct Run
+{
+    std::uint64_t offset;
+    std::uint64_t num_bytes;
+};
+
+//! Scratch file holding the runs of one layer while it is enumerated. Deleted on destruction.
+class SpillFile
+{
+public:
+    explicit SpillFile(const std::string& path) : file_{ path, O_RDWR | O_CREAT | O_TRUNC }
+    {
+    }
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    ~SpillFile()
+    {
+        ::unlink(file_.getPath().c_str());
+    }
+
+    const File& getFile() const
+    {
+        return file_;
+    }
+
+    //! Sorts and deduplicates `keys` and writes them as a new run
+    Run append(std::vector<std::uint64_t>& keys)
+    {
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+        const Run run{ size_, 0 };
+        std::vector<std::uint8_t> buffer{};
+        buffer.reserve(kRunWriteBufferSize + 10);
+        std::uint64_t previous_key{ 0 };
+        for (const std::uint64_t key : keys)
+        {
+            appendVarint(key - previous_key, buffer);
+            previous_key = key;
+            if (buffer.size() >= kRunWriteBufferSize)
+            {
+                flush(buffer);
+            }
+        }
+        flush(buffer);
+
+        return Run{ run.offset, size_ - run.offset };
+    }
+
+private:
+    void flush(std::vector<std::uint8_t>& buffer)
+    {
+        file_.writeAt(buffer.data(), buffer.size(), size_);
+        size_ += buffer.size();
+        buffer.clear();
+    }
+
+    File file_;
+    std::uint64_t size_{ 0 };
+};
+
+//! Streams the keys of one run through a small read-ahead buffer
+class RunReader
+{
+public:
+    RunReader(const File& file, const Run& run) : file_{ file }, next_offset_{ run.offset }, end_offset_{ run.offset + run.num_bytes }
+    {
+    }
+
+    //! Returns false at the end of the run
+    bool next(std::uint64_t& key)
+    {
+        if ((position_ == buffer_.size()) && (next_offset_ == end_offset_))
+        {
+            return false;
+        }
+
+        std::uint64_t delta{ 0 };
+        for (int shift = 0;; shift += 7)
+        {
+            const std::uint8_t byte{ readByte() };
+            delta |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                break;
+            }
+        }
+
+        key_ += delta;
+        key = key_;
+        return true;
+    }
+
+private:
+    std::uint8_t readByte()
+    {
+        if (position_ == buffer_.size())
+        {
+            const std::size_t size{ static_cast<std::size_t>(std::min<std::uint64_t>(kRunReadBufferSize, end_offset_ - next_offset_)) };
+            if (size == 0)
+            {
+                throw std::runtime_error("Run in `" + file_.getPath() + "` is corrupt");
+            }
+            buffer_.resize(size);
+            file_.readAt(buffer_.data(), size, next_offset_);
+            next_offset_ += size;
+            position_ = 0;
+        }
+
+        return buffer_[position_++];
+    }
+
+    const File& file_;
+    std::uint64_t next_offset_;
+    std::uint64_t end_offset_;
+    std::vector<std::uint8_t> buffer_{};
+    std::size_t position_{ 0 };
+    std::uint64_t key_{ 0 };
+};
+
+struct DecodedChunk
+{
+    std::vector<std::uint64_t> keys;
+    //! Empty for positions files
+    std::vector<std::int8_t> values;
+};
+
+//! Position reached by a move, in canonical form
+struct Successor
+{
+    Cells cells;
+    int num_stones;
+    //! Stones the mover put in their bank
+    int gain;
+    bool extra_turn;
+};
+
+//! Value of a finished game for the player to move, once the remaining stones have gone to their owners' banks, or
+//! nothing if the game goes on
+std::optional<int> getFinishedGameValue(const Cells& cells, const std::size_t num_pits, const int num_stones)
+{
+    int num_active_player_stones{ 0 };
+    for (std::size_t i = 0; i < num_pits; ++i)
+    {
+        num_active_player_stones += cells[i];
+    }
+    const int num_opposing_player_stones{ num_stones - num_active_player_stones };
+
+    if ((num_active_player_stones == 0) || (num_opposing_player_stones == 0))
+    {
+        return num_active_player_stones - num_opposing_player_stones;
+    }
+
+    return std::nullopt;
+}
+
+//! Plays every move of the canonical position `cells` on a copy of `empty_board_state` (a board of the right size with
+//! no stones), with the mover as player 0 and both banks empty
+void generateSuccessors(const BoardState& empty_board_state, const Cells& cells, const int num_stones,
+                        std::vector<Successor>& successors)
+{
+    const std::size_t num_pits{ empty_board_state.getNumPits() };
+
+    BoardState board_state{ empty_board_state };
+    for (std::size_t i = 0; i < num_pits; ++i)
+    {
+        board_state.getPlayer0BoardState().addStonesToPitUnchecked(i, cells[i]);
+        board_state.getPlayer1BoardState().addStonesToPitUnchecked(i, cells[num_pits + i]);
+    }
+
+    const TurnExecutor turn_executor{};
+    successors.clear();
+    for (std::size_t i = 0; i < num_pits; ++i)
+    {
+        BoardState board_state_i{ board_state };
+        const TurnResult result{ turn_executor.playTurn(/*player_index*/ 0, i, board_state_i) };
+        if (!result.valid)
+        {
+            continue;
+        }
+
+        // Only the active player's bank can change during their turn
+        const int gain{ board_state_i.getPlayer0BoardState().getNumStonesInBank() };
+        successors.push_back(Successor{ PositionIndexer::getCells(board_state_i.getCanonical(result.ended_in_bank ? 0 : 1)), num_stones - gain,
+                                        gain, result.ended_in_bank });
+    }
+}
+
+} // namespace
+
+//! Maps the canonical positions of a layer to keys ordered by potential first and `PositionIndexer` rank second
+class RetrogradeDatabase::KeyIndexer
+{
+public:
+    KeyIndexer(const std::size_t num_pits, const int max_stones) : num_pits_{ num_pits }, position_indexer_{ num_pits, max_stones }
+    {
+        for (int s = 0; s <= max_stones; ++s)
+        {
+            // The largest potential has every stone in the last pit
+            const std::uint64_t num_potentials{ static_cast<std::uint64_t>(num_pits - 1) * static_cast<std::uint64_t>(s) + 1 };
+            if (position_indexer_.getNumDistributions(s) > (std::numeric_limits<std::uint64_t>::max() / num_potentials))
+            {
+                throw std::overflow_error("Retrograde database is too large to index");
+            }
+        }
+    }
+
+    std::uint64_t getKey(const Cells& cells, const int num_stones) const
+    {
+        std::uint64_t potential{ 0 };
+        for (std::size_t i = 0; i < num_pits_; ++i)
+        {
+            potential += i * (static_cast<std::uint64_t>(cells[i]) + cells[num_pits_ + i]);
+        }
+
+        return (potential * position_indexer_.getNumDistributions(num_stones)) + position_indexer_.rankCells(cells);
+    }
+
+    Cells getCells(const std::uint64_t key, const int num_stones) const
+    {
+        return position_indexer_.unrankCells(key % position_indexer_.getNumDistributions(num_stones), num_stones);
+    }
+
+    std::uint64_t getPotential(const std::uint64_t key, const int num_stones) const
+    {
+        return key / position_indexer_.getNumDistributions(num_stones);
+    }
+
+private:
+    std::size_t num_pits_;
+    PositionIndexer position_indexer_;
+};
+
+//! Sorted keys of one layer, with a value per key for solved layers, appended in order and stored in chunks
+class RetrogradeDatabase::LayerFile
+{
+public:
+    //! Creates an empty file if `create` is set, otherwise opens an existing one and indexes its chunks
+    LayerFile(const std::string& path, const int num_stones, const KeyOrder order, const bool has_values, const bool create) :
+                file_{ path, create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY }, num_stones_{ num_stones }, order_{ order },
+                has_values_{ has_values }
+    {
+        if (create)
+        {
+            return;
+        }
+
+        const std::uint64_t file_size{ file_.getSize() };
+        while (size_ < file_size)
+        {
+            ChunkHeader header{};
+            file_.readAt(&header, sizeof(header), size_);
+            chunks_.push_back(ChunkInfo{ header.first_key, size_, header.num_records, header.payload_size });
+            size_ += sizeof(header) + header.payload_size;
+            num_records_ += header.num_records;
+        }
+        if (size_ != file_size)
+        {
+            throw std::runtime_error("`" + path + "` is truncated");
+        }
+    }
+
+    int getNumStones() const
+    {
+        return num_stones_;
+    }
+
+    std::uint64_t getNumRecords() const
+    {
+        return num_records_ + pending_keys_.size();
+    }
+
+    std::size_t getNumChunks() const
+    {
+        return chunks_.size();
+    }
+
+    //! Keys must come in the file's order. `value` is ignored for positions files.
+    void append(const std::uint64_t key, const std::int8_t value)
+    {
+        pending_keys_.push_back(key);
+        if (has_values_)
+        {
+            pending_values_.push_back(value);
+        }
+        if (pending_keys_.size() == kChunkNumRecords)
+        {
+            writeChunk();
+        }
+    }
+
+    //! Writes out the last partial chunk
+    void finish()
+    {
+        writeChunk();
+    }
+
+    DecodedChunk readChunk(const std::size_t chunk_index) const
+    {
+        const ChunkInfo& chunk{ chunks_[chunk_index] };
+        std::vector<std::uint8_t> payload(chunk.payload_size);
+        file_.readAt(payload.data(), payload.size(), chunk.offset + sizeof(ChunkHeader));
+
+        DecodedChunk decoded{};
+        decoded.keys.reserve(chunk.num_records);
+        decoded.keys.push_back(chunk.first_key);
+        const std::uint8_t* data{ payload.data() };
+        const std::uint8_t* const end{ payload.data() + payload.size() };
+        for (std::uint32_t i = 1; i < chunk.num_records; ++i)
+        {
+            const std::uint64_t delta{ readVarint(data, end) };
+            decoded.keys.push_back((order_ == KeyOrder::kAscending) ? (decoded.keys.back() + delta) : (decoded.keys.back() - delta));
+        }
+
+        const std::size_t num_value_bytes{ has_values_ ? chunk.num_records : 0 };
+        if (static_cast<std::size_t>(end - data) != num_value_bytes)
+        {
+            throw std::runtime_error("Chunk in `" + file_.getPath() + "` is corrupt");
+        }
+        decoded.values.assign(reinterpret_cast<const std::int8_t*>(data), reinterpret_cast<const std::int8_t*>(end));
+
+        return decoded;
+    }
+
+    //! Value stored for `key`, including keys appended to the chunk that has not been written yet
+    std::optional<std::int8_t> find(const std::uint64_t key, ChunkCache& chunk_cache) const;
+
+private:
+    struct ChunkInfo
+    {
+        std::uint64_t first_key;
+        std::uint64_t offset;
+        std::uint32_t num_records;
+        std::uint32_t payload_size;
+    };
+
+    bool isBefore(const std::uint64_t a, const std::uint64_t b) const
+    {
+        return (order_ == KeyOrder::kAscending) ? (a < b) : (a > b);
+    }
+
+    void writeChunk()
+    {
+        if (pending_keys_.empty())
+        {
+            return;
+        }
+
+        std::vector<std::uint8_t> buffer(sizeof(ChunkHeader));
+        for (std::size_t i = 1; i < pending_keys_.size(); ++i)
+        {
+            appendVarint((order_ == KeyOrder::kAscending) ? (pending_keys_[i] - pending_keys_[i - 1])
+                                                          : (pending_keys_[i - 1] - pending_keys_[i]),
+                         buffer);
+        }
+        for (const std::int8_t value : pending_values_)
+        {
+            buffer.push_back(static_cast<std::uint8_t>(value));
+        }
+
+        const ChunkHeader header{ pending_keys_.front(), static_cast<std::uint32_t>(pending_keys_.size()),
+                                  static_cast<std::uint32_t>(buffer.size() - sizeof(ChunkHeader)) };
+        std::memcpy(buffer.data(), &header, sizeof(header));
+        file_.writeAt(buffer.data(), buffer.size(), size_);
+
+        chunks_.push_back(ChunkInfo{ header.first_key, size_, header.num_records, header.payload_size });
+        size_ += buffer.size();
+        num_records_ += pending_keys_.size();
+        pending_keys_.clear();
+        pending_values_.clear();
+    }
+
+    File file_;
+    int num_stones_;
+    KeyOrder order_;
+    bool has_values_;
+    std::vector<ChunkInfo> chunks_{};
+    std::uint64_t size_{ 0 };
+    std::uint64_t num_records_{ 0 };
+    std::vector<std::uint64_t> pending_keys_{};
+    std::vector<std::int8_t> pending_values_{};
+};
+
+//! Decoded chunks of the value files, evicting the least recently used chunk once over capacity
+class RetrogradeDatabase::ChunkCache
+{
+public:
+    explicit ChunkCache(const std::size_t capacity_bytes) : capacity_bytes_{ capacity_bytes }
+    {
+    }
+
+    std::shared_ptr<const DecodedChunk> get(const LayerFile& layer, const std::size_t chunk_index)
+    {
+        // Layers are identified by their number of stones, which is unique within a database
+        const std::uint64_t id{ (static_cast<std::uint64_t>(layer.getNumStones()) << 48) | chunk_index };
+        const auto it{ entries_.find(id) };
+        if (it != entries_.end())
+        {
+            lru_ids_.splice(lru_ids_.begin(), lru_ids_, it->second.lru_position);
+            return it->second.chunk;
+        }
+
+        std::shared_ptr<const DecodedChunk> chunk{ std::make_shared<const DecodedChunk>(layer.readChunk(chunk_index)) };
+        lru_ids_.push_front(id);
+        entries_.emplace(id, Entry{ chunk, lru_ids_.begin() });
+        size_bytes_ += getSizeBytes(*chunk);
+
+        // The chunk just read always stays, even if it alone exceeds the capacity
+        while ((size_bytes_ > capacity_bytes_) && (lru_ids_.size() > 1))
+        {
+            const auto evicted{ entries_.find(lru_ids_.back()) };
+            size_bytes_ -= getSizeBytes(*evicted->second.chunk);
+            entries_.erase(evicted);
+            lru_ids_.pop_back();
+        }
+
+        return chunk;
+    }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<const DecodedChunk> chunk;
+        std::list<std::uint64_t>::iterator lru_position;
+    };
+
+    static std::size_t getSizeBytes(const DecodedChunk& chunk)
+    {
+        return sizeof(DecodedChunk) + (chunk.keys.size() * sizeof(std::uint64_t)) + chunk.values.size();
+    }
+
+    std::size_t capacity_bytes_;
+    std::size_t size_bytes_{ 0 };
+    std::list<std::uint64_t> lru_ids_{};
+    std::unordered_map<std::uint64_t, Entry> entries_{};
+};
+
+std::optional<std::int8_t> RetrogradeDatabase::LayerFile::find(const std::uint64_t key, ChunkCache& chunk_cache) const
+{
+    const auto isBeforeKey{ [this](const std::uint64_t a, const std::uint64_t b) { return isBefore(a, b); } };
+
+    const std::vector<std::uint64_t>* keys{ nullptr };
+    const std::vector<std::int8_t>* values{ nullptr };
+    std::shared_ptr<const DecodedChunk> chunk{};
+    if (!pending_keys_.empty() && !isBefore(key, pending_keys_.front()))
+    {
+        keys = &pending_keys_;
+        values = &pending_values_;
+    }
+    else
+    {
+        // The chunk holding `key`, if any, is the last one that starts at or before it
+        const auto next_chunk{ std::partition_point(chunks_.begin(), chunks_.end(),
+                                                    [&](const ChunkInfo& info) { return !isBefore(key, info.first_key); }) };
+        if (next_chunk == chunks_.begin())
+        {
+            return std::nullopt;
+        }
+
+        chunk = chunk_cache.get(*this, static_cast<std::size_t>(next_chunk - chunks_.begin()) - 1);
+        keys = &chunk->keys;
+        values = &chunk->values;
+    }
+
+    const auto it{ std::lower_bound(keys->begin(), keys->end(), key, isBeforeKey) };
+    if ((it == keys->end()) || (*it != key))
+    {
+        return std::nullopt;
+    }
+
+    return (*values)[static_cast<std::size_t>(it - keys->begin())];
+}
+
+RetrogradeDatabase::RetrogradeDatabase(const std::string& directory, const std::size_t num_pits, const int max_stones,
+                                       const RetrogradeOptions& options) :
+            directory_{ directory }, num_pits_{ num_pits }, max_stones_{ max_stones },
+            key_indexer_{ std::make_unique<KeyIndexer>(num_pits, max_stones) },
+            chunk_cache_{ std::make_unique<ChunkCache>(options.chunk_cache_size_bytes) },
+            layers_(static_cast<std::size_t>(max_stones) + 1)
+{
+}
+
+RetrogradeDatabase::RetrogradeDatabase(RetrogradeDatabase&&) noexcept = default;
+RetrogradeDatabase& RetrogradeDatabase::operator=(RetrogradeDatabase&&) noexcept = default;
+RetrogradeDatabase::~RetrogradeDatabase() = default;
+
+RetrogradeDatabase RetrogradeDatabase::solve(const BoardState& board_state, const std::size_t active_player_index,
+                                             const std::string& directory, const RetrogradeOptions& options)
+{
+    const BoardState canonical_board_state{ board_state.getCanonical(active_player_index) };
+    const int max_stones{ canonical_board_state.getPlayer0BoardState().sumOfStonesInPits() +
+                          canonical_board_state.getPlayer1BoardState().sumOfStonesInPits() };
+    if (max_stones > kMaxSupportedStones)
+    {
+        std::stringstream msg{};
+        msg << "Number of stones in the pits (" << max_stones << ") must not exceed " << kMaxSupportedStones;
+
+        throw std::invalid_argument(msg.str());
+    }
+
+    std::filesystem::create_directories(directory);
+
+    RetrogradeDatabase database{ directory, canonical_board_state.getNumPits(), max_stones, options };
+    database.solveLayers(database.enumeratePositions(canonical_board_state, options));
+    database.writeManifest();
+
+    return database;
+}
+
+RetrogradeDatabase RetrogradeDatabase::open(const std::string& directory, const RetrogradeOptions& options)
+{
+    const std::string manifest_path{ (std::filesystem::path{ directory } / "manifest").string() };
+    std::ifstream file{ manifest_path, std::ios::binary };
+
+    ManifestHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) || (header.version != kFormatVersion) ||
+        (header.num_pits == 0) || (header.num_pits > kMaxNumPits) || (header.max_stones > kMaxSupportedStones))
+    {
+        throw std::runtime_error("`" + directory + "` is not a supported retrograde database");
+    }
+
+    std::vector<std::uint64_t> num_positions(header.max_stones + 1);
+    file.read(reinterpret_cast<char*>(num_positions.data()), static_cast<std::streamsize>(num_positions.size() * sizeof(std::uint64_t)));
+    if (!file)
+    {
+        throw std::runtime_error("Retrograde database manifest `" + manifest_path + "` is truncated");
+    }
+
+    RetrogradeDatabase database{ directory, header.num_pits, static_cast<int>(header.max_stones), options };
+    for (int s = 0; s <= database.max_stones_; ++s)
+    {
+        if (num_positions[static_cast<std::size_t>(s)] == 0)
+        {
+            continue;
+        }
+
+        auto layer{ std::make_unique<LayerFile>(database.getLayerPath(s, "values"), s, KeyOrder::kDescending, /*has_values*/ true,
+                                                /*create*/ false) };
+        if (layer->getNumRecords() != num_positions[static_cast<std::size_t>(s)])
+        {
+            throw std::runtime_error("Retrograde database `" + directory + "` has an inconsistent number of positions");
+        }
+        database.layers_[static_cast<std::size_t>(s)] = std::move(layer);
+    }
+
+    return database;
+}
+
+std::uint64_t RetrogradeDatabase::getNumPositions(const int num_stones) const
+{
+    if ((num_stones < 0) || (num_stones > max_stones_) || (layers_[static_cast<std::size_t>(num_stones)] == nullptr))
+    {
+        return 0;
+    }
+
+    return layers_[static_cast<std::size_t>(num_stones)]->getNumRecords();
+}
+
+std::uint64_t RetrogradeDatabase::getNumPositions() const
+{
+    std::uint64_t num_positions{ 0 };
+    for (int s = 0; s <= max_stones_; ++s)
+    {
+        num_positions += getNumPositions(s);
+    }
+
+    return num_positions;
+}
+
+std::optional<int> RetrogradeDatabase::probe(const BoardState& board_state, const std::size_t active_player_index) const
+{
+    if (board_state.getNumPits() != num_pits_)
+    {
+        return std::nullopt;
+    }
+
+    const BoardState canonical_board_state{ board_state.getCanonical(active_player_index) };
+    const int num_stones{ canonical_board_state.getPlayer0BoardState().sumOfStonesInPits() +
+                          canonical_board_state.getPlayer1BoardState().sumOfStonesInPits() };
+    if (num_stones > max_stones_)
+    {
+        return std::nullopt;
+    }
+
+    const int bank_differential{ canonical_board_state.getPlayer0BoardState().getNumStonesInBank() -
+                                 canonical_board_state.getPlayer1BoardState().getNumStonesInBank() };
+    const Cells cells{ PositionIndexer::getCells(canonical_board_state) };
+    if (const std::optional<int> value{ getFinishedGameValue(cells, num_pits_, num_stones) })
+    {
+        return value.value() + bank_differential;
+    }
+
+    const LayerFile* const layer{ layers_[static_cast<std::size_t>(num_stones)].get() };
+    if (layer == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    const std::optional<std::int8_t> value{ layer->find(key_indexer_->getKey(cells, num_stones), *chunk_cache_) };
+    if (!value.has_value())
+    {
+        return std::nullopt;
+    }
+
+    return value.value() + bank_differential;
+}
+
+std::vector<std::uint64_t> RetrogradeDatabase::enumeratePositions(const BoardState& canonical_board_state,
+                                                                  const RetrogradeOptions& options) const
+{
+    const std::size_t num_layers{ static_cast<std::size_t>(max_stones_) + 1 };
+    const BoardState empty_board_state{ num_pits_, 0 };
+
+    // Keys not yet spilled, and the runs spilled so far, per layer
+    std::vector<std::vector<std::uint64_t>> buffers(num_layers);
+    std::vector<std::unique_ptr<SpillFile>> spill_files(num_layers);
+    std::vector<std::vector<Run>> runs(num_layers);
+    std::size_t num_buffered_keys{ 0 };
+
+    const auto spill{ [&](const int s) -> std::optional<Run>
+    {
+        std::vector<std::uint64_t>& buffer{ buffers[static_cast<std::size_t>(s)] };
+        if (buffer.empty())
+        {
+            return std::nullopt;
+        }
+
+        std::unique_ptr<SpillFile>& spill_file{ spill_files[static_cast<std::size_t>(s)] };
+        if (spill_file == nullptr)
+        {
+            spill_file = std::make_unique<SpillFile>(getLayerPath(s, "spill"));
+        }
+
+        num_buffered_keys -= buffer.size();
+        const Run run{ spill_file->append(buffer) };
+        buffer.clear();
+        buffer.shrink_to_fit();
+
+        return run;
+    } };
+
+    const Cells root_cells{ PositionIndexer::getCells(canonical_board_state) };
+    if (!getFinishedGameValue(root_cells, num_pits_, max_stones_).has_value())
+    {
+        buffers.back().push_back(key_indexer_->getKey(root_cells, max_stones_));
+        num_buffered_keys = 1;
+    }
+
+    std::vector<std::uint64_t> num_positions(num_layers, 0);
+    std::vector<Successor> successors{};
+    for (int s = max_stones_; s > 0; --s)
+    {
+        std::vector<std::uint64_t>& buffer{ buffers[static_cast<std::size_t>(s)] };
+        if (const std::optional<Run> run{ spill(s) })
+        {
+            runs[static_cast<std::size_t>(s)].push_back(run.value());
+        }
+        if (runs[static_cast<std::size_t>(s)].empty())
+        {
+            continue;
+        }
+
+        // External priority queue: the smallest head of all runs of the layer comes next
+        using HeapEntry = std::pair<std::uint64_t, std::size_t>;
+        std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap{};
+        std::vector<std::unique_ptr<RunReader>> readers{};
+        const auto addRun{ [&](const Run& run)
+        {
+            readers.push_back(std::make_unique<RunReader>(spill_files[static_cast<std::size_t>(s)]->getFile(), run));
+            std::uint64_t key{ 0 };
+            if (readers.back()->next(key))
+            {
+                heap.emplace(key, readers.size() - 1);
+            }
+        } };
+        for (const Run& run : runs[static_cast<std::size_t>(s)])
+        {
+            addRun(run);
+        }
+        runs[static_cast<std::size_t>(s)].clear();
+
+        LayerFile positions{ getLayerPath(s, "positions"), s, KeyOrder::kAscending, /*has_values*/ false, /*create*/ true };
+        std::optional<std::uint64_t> last_key{};
+        std::uint64_t last_potential{ 0 };
+        while (true)
+        {
+            // Buffered children of this layer all have a higher potential than the last key taken. Once the queue moves on
+            // to a higher potential they may come next, so they join the queue as a new run.
+            if (!buffer.empty() && (heap.empty() || (key_indexer_->getPotential(heap.top().first, s) > last_potential)))
+            {
+                addRun(spill(s).value());
+            }
+            if (heap.empty())
+            {
+                break;
+            }
+
+            const auto [key, reader_index]{ heap.top() };
+            heap.pop();
+            std::uint64_t next_key{ 0 };
+            if (readers[reader_index]->next(next_key))
+            {
+                heap.emplace(next_key, reader_index);
+            }
+            else
+            {
+                readers[reader_index].reset();
+            }
+
+            // Duplicates come out of the queue one after the other
+            if (last_key == key)
+            {
+                continue;
+            }
+            last_key = key;
+            last_potential = key_indexer_->getPotential(key, s);
+            positions.append(key, 0);
+
+            generateSuccessors(empty_board_state, key_indexer_->getCells(key, s), s, successors);
+            for (const Successor& successor : successors)
+            {
+                if (getFinishedGameValue(successor.cells, num_pits_, successor.num_stones).has_value())
+                {
+                    continue;
+                }
+
+                const std::uint64_t successor_key{ key_indexer_->getKey(successor.cells, successor.num_stones) };
+                if ((successor.num_stones == s) && (key_indexer_->getPotential(successor_key, s) <= last_potential))
+                {
+                    throw std::logic_error("Move within a layer does not increase the potential");
+                }
+                buffers[static_cast<std::size_t>(successor.num_stones)].push_back(successor_key);
+                ++num_buffered_keys;
+            }
+
+            if (num_buffered_keys > options.max_buffered_positions)
+            {
+                if (const std::optional<Run> run{ spill(s) })
+                {
+                    addRun(run.value());
+                }
+                for (int smaller_s = 1; smaller_s < s; ++smaller_s)
+                {
+                    if (const std::optional<Run> run{ spill(smaller_s) })
+                    {
+                        runs[static_cast<std::size_t>(smaller_s)].push_back(run.value());
+                    }
+                }
+            }
+        }
+
+        positions.finish();
+        num_positions[static_cast<std::size_t>(s)] = positions.getNumRecords();
+        readers.clear();
+        spill_files[static_cast<std::size_t>(s)].reset();
+    }
+
+    return num_positions;
+}
+
+void RetrogradeDatabase::solveLayers(const std::vector<std::uint64_t>& num_positions)
+{
+    const BoardState empty_board_state{ num_pits_, 0 };
+
+    std::vector<Successor> successors{};
+    for (int s = 1; s <= max_stones_; ++s)
+    {
+        if (num_positions[static_cast<std::size_t>(s)] == 0)
+        {
+            continue;
+        }
+
+        const std::string positions_path{ getLayerPath(s, "positions") };
+        auto values{ std::make_unique<LayerFile>(getLayerPath(s, "values"), s, KeyOrder::kDescending, /*has_values*/ true,
+                                                 /*create*/ true) };
+        {
+            const LayerFile positions{ positions_path, s, KeyOrder::kAscending, /*has_values*/ false, /*create*/ false };
+
+            // Descending key order visits the children within the layer before their parents
+            for (std::size_t c = positions.getNumChunks(); c-- > 0;)
+            {
+                const DecodedChunk chunk{ positions.readChunk(c) };
+                for (auto it = chunk.keys.rbegin(); it != chunk.keys.rend(); ++it)
+                {
+                    generateSuccessors(empty_board_state, key_indexer_->getCells(*it, s), s, successors);
+
+                    int best_value{ std::numeric_limits<int>::min() };
+                    for (const Successor& successor : successors)
+                    {
+                        std::optional<int> successor_value{ getFinishedGameValue(successor.cells, num_pits_, successor.num_stones) };
+                        if (!successor_value.has_value())
+                        {
+                            const LayerFile* const layer{ (successor.num_stones == s) ? values.get()
+                                                                                          : layers_[static_cast<std::size_t>(successor.num_stones)].get() };
+                            const std::optional<std::int8_t> stored_value{
+                                (layer == nullptr) ? std::nullopt
+                                                   : layer->find(key_indexer_->getKey(successor.cells, successor.num_stones), *chunk_cache_) };
+                            if (!stored_value.has_value())
+                            {
+                                throw std::logic_error("Retrograde database is missing a reachable position");
+                            }
+                            successor_value = stored_value.value();
+                        }
+
+                        best_value = std::max(best_value, successor.gain + (successor.extra_turn ? successor_value.value()
+                                                                                                 : -successor_value.value()));
+                    }
+
+                    values->append(*it, static_cast<std::int8_t>(best_value));
+                }
+            }
+        }
+
+        values->finish();
+        layers_[static_cast<std::size_t>(s)] = std::move(values);
+        std::filesystem::remove(positions_path);
+    }
+}
+
+void RetrogradeDatabase::writeManifest() const
+{
+    const std::string manifest_path{ (std::filesystem::path{ directory_ } / "manifest").string() };
+    std::ofstream file{ manifest_path, std::ios::binary | std::ios::trunc };
+
+    ManifestHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.num_pits = static_cast<std::uint32_t>(num_pits_);
+    header.max_stones = static_cast<std::uint32_t>(max_stones_);
+
+    std::vector<std::uint64_t> num_positions{};
+    for (int s = 0; s <= max_stones_; ++s)
+    {
+        num_positions.push_back(getNumPositions(s));
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(num_positions.data()),
+               static_cast<std::streamsize>(num_positions.size() * sizeof(std::uint64_t)));
+    if (!file)
+    {
+        throw std::runtime_error("Could not write retrograde database manifest `" + manifest_path + "`");
+    }
+}
+
+std::string RetrogradeDatabase::getLayerPath(const int num_stones, const std::string& extension) const
+{
+    std::stringstream name{};
+    name << "layer_" << std::setw(3) << std::setfill('0') << num_stones << "." << extension;
+
+    return (std::filesystem::path{ directory_ } / name.str()).string();
+}
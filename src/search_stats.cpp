@@ -0,0 +1,128 @@
+#include <search_stats.h>
+
+#include <iomanip>
+
+namespace
+{
+
+double getFraction(const std::uint64_t count, const std::uint64_t total)
+{
+    return (total == 0) ? 0.0 : (static_cast<double>(count) / static_cast<double>(total));
+}
+
+} // namespace
+
+void SearchStats::merge(const SearchStats& other)
+{
+    num_nodes += other.num_nodes;
+    elapsed += other.elapsed;
+
+    num_transposition_hits += other.num_transposition_hits;
+    num_transposition_misses += other.num_transposition_misses;
+    num_transposition_collisions += other.num_transposition_collisions;
+
+    for (std::size_t i = 0; i < kMaxNumPits; ++i)
+    {
+        num_cutoffs_by_move_index[i] += other.num_cutoffs_by_move_index[i];
+        root_moves[i].num_nodes += other.root_moves[i].num_nodes;
+        root_moves[i].elapsed += other.root_moves[i].elapsed;
+    }
+
+    for (std::size_t ply = 0; ply < kMaxPly; ++ply)
+    {
+        num_interior_nodes_by_ply[ply] += other.num_interior_nodes_by_ply[ply];
+        num_children_by_ply[ply] += other.num_children_by_ply[ply];
+    }
+}
+
+double SearchStats::getNodesPerSecond() const
+{
+    const double seconds{ std::chrono::duration<double>(elapsed).count() };
+
+    return (seconds > 0.0) ? (static_cast<double>(num_nodes) / seconds) : 0.0;
+}
+
+double SearchStats::getTranspositionHitRate() const
+{
+    return getFraction(num_transposition_hits, getNumTranspositionProbes());
+}
+
+double SearchStats::getTranspositionMissRate() const
+{
+    return getFraction(num_transposition_misses, getNumTranspositionProbes());
+}
+
+double SearchStats::getTranspositionCollisionRate() const
+{
+    return getFraction(num_transposition_collisions, getNumTranspositionProbes());
+}
+
+std::uint64_t SearchStats::getNumCutoffs() const
+{
+    std::uint64_t num_cutoffs{ 0 };
+    for (const std::uint64_t num_move_cutoffs : num_cutoffs_by_move_index)
+    {
+        num_cutoffs += num_move_cutoffs;
+    }
+
+    return num_cutoffs;
+}
+
+double SearchStats::getBranchingFactor(const std::size_t ply) const
+{
+    return getFraction(num_children_by_ply[ply], num_interior_nodes_by_ply[ply]);
+}
+
+std::ostream& operator<<(std::ostream& os, const SearchStats& search_stats)
+{
+    const std::ios_base::fmtflags flags{ os.flags() };
+    os << std::fixed << std::setprecision(3);
+
+    os << "nodes: " << search_stats.num_nodes << "\n";
+    os << "elapsed: " << std::chrono::duration<double>(search_stats.elapsed).count() << " s\n";
+    os << "nodes/s: " << search_stats.getNodesPerSecond() << "\n";
+
+    if (!kSearchStatsEnabled)
+    {
+        os << "(detailed statistics compiled out)";
+        os.flags(flags);
+        return os;
+    }
+
+    os << "tt probes: " << search_stats.getNumTranspositionProbes()
+       << " (hit " << search_stats.getTranspositionHitRate()
+       << ", miss " << search_stats.getTranspositionMissRate()
+       << ", collision " << search_stats.getTranspositionCollisionRate() << ")\n";
+
+    const std::uint64_t num_cutoffs{ search_stats.getNumCutoffs() };
+    os << "cutoffs: " << num_cutoffs << " (by move index:";
+    for (const std::uint64_t num_move_cutoffs : search_stats.num_cutoffs_by_move_index)
+    {
+        os << " " << getFraction(num_move_cutoffs, num_cutoffs);
+    }
+    os << ")\n";
+
+    os << "branching factor by ply:";
+    for (std::size_t ply = 0; ply < SearchStats::kMaxPly; ++ply)
+    {
+        if (search_stats.num_interior_nodes_by_ply[ply] == 0)
+        {
+            break;
+        }
+        os << " " << search_stats.getBranchingFactor(ply);
+    }
+    os << "\n";
+
+    os << "root moves (pit: nodes, seconds):";
+    for (std::size_t i = 0; i < kMaxNumPits; ++i)
+    {
+        const RootMoveStats& root_move{ search_stats.root_moves[i] };
+        if (root_move.num_nodes > 0)
+        {
+            os << " " << i << ": " << root_move.num_nodes << ", " << std::chrono::duration<double>(root_move.elapsed).count() << ";";
+        }
+    }
+
+    os.flags(flags);
+    return os;
+}
@@ -0,0 +1,345 @@
+#include <self_play.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <game_mechanics.h>
+#include <negamax_solver.h>
+
+namespace
+{
+
+constexpr char kGameLogMagic[8]{ 'M', 'N', 'C', 'L', 'G', 'A', 'M', 'E' };
+constexpr std::uint32_t kGameLogFormatVersion{ 1 };
+
+struct GameLogHeader
+{
+    char magic[8];
+    std::uint32_t format_version;
+    std::uint8_t num_pits;
+    std::uint8_t num_stones_per_pit;
+    std::uint8_t reserved[2];
+};
+
+static_assert(sizeof(GameLogHeader) == 16);
+
+struct GameLogRecordHeader
+{
+    std::uint16_t num_moves;
+    std::int16_t final_bank_differential;
+    std::uint8_t starting_player_index;
+    std::uint8_t reserved[3];
+};
+
+static_assert(sizeof(GameLogRecordHeader) == 8);
+
+//! Legal moves of the player to move, in pit order
+std::vector<std::size_t> getLegalPitIndices(const BoardState& board_state, const std::size_t active_player_index)
+{
+    const SinglePlayerBoardState& active_player_board_state{ (active_player_index == 0) ? board_state.getPlayer0BoardState()
+                                                                                         : board_state.getPlayer1BoardState() };
+
+    std::vector<std::size_t> pit_indices{};
+    for (std::size_t i = 0; i < board_state.getNumPits(); ++i)
+    {
+        if (active_player_board_state.getNumStonesInPitUnchecked(i) > 0)
+        {
+            pit_indices.push_back(i);
+        }
+    }
+
+    return pit_indices;
+}
+
+std::size_t pickGreedyPitIndex(const BoardState& board_state, const GameMechanicsExecutor& game_mechanics_executor,
+                               const std::vector<std::size_t>& legal_pit_indices, std::mt19937_64& random_engine)
+{
+    const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
+    const auto getBank{ [&](const BoardState& b)
+    {
+        return ((active_player_index == 0) ? b.getPlayer0BoardState() : b.getPlayer1BoardState()).getNumStonesInBank();
+    } };
+
+    // Twice the stones banked, plus one for an extra turn
+    int best_score{ -1 };
+    std::vector<std::size_t> best_pit_indices{};
+    for (const std::size_t pit_index : legal_pit_indices)
+    {
+        BoardState board_state_i{ board_state };
+        GameMechanicsExecutor game_mechanics_executor_i{ game_mechanics_executor };
+        game_mechanics_executor_i.playTurn(pit_index, board_state_i);
+
+        const bool extra_turn{ game_mechanics_executor_i.getActivePlayerIndex() == active_player_index };
+        const int score{ 2 * (getBank(board_state_i) - getBank(board_state)) + (extra_turn ? 1 : 0) };
+        if (score > best_score)
+        {
+            best_score = score;
+            best_pit_indices.clear();
+        }
+        if (score == best_score)
+        {
+            best_pit_indices.push_back(pit_index);
+        }
+    }
+
+    return best_pit_indices[std::uniform_int_distribution<std::size_t>{ 0, best_pit_indices.size() - 1 }(random_engine)];
+}
+
+} // namespace
+
+SelfPlayPolicy parseSelfPlayPolicy(const std::string& name)
+{
+    if (name == "random")
+    {
+        return SelfPlayPolicy::kRandom;
+    }
+    if (name == "greedy")
+    {
+        return SelfPlayPolicy::kGreedy;
+    }
+    if (name == "solver")
+    {
+        return SelfPlayPolicy::kSolver;
+    }
+
+    throw std::invalid_argument("Unknown self-play policy `" + name + "`");
+}
+
+GameLogWriter::GameLogWriter(std::ostream& output, const std::size_t num_pits, const int num_stones_per_pit) : output_{ output }
+{
+    GameLogHeader header{};
+    std::memcpy(header.magic, kGameLogMagic, sizeof(header.magic));
+    header.format_version = kGameLogFormatVersion;
+    header.num_pits = static_cast<std::uint8_t>(num_pits);
+    header.num_stones_per_pit = static_cast<std::uint8_t>(num_stones_per_pit);
+
+    output_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void GameLogWriter::write(const GameRecord& game_record)
+{
+    if (game_record.pit_indices.size() > std::numeric_limits<std::uint16_t>::max())
+    {
+        throw std::overflow_error("Game with " + std::to_string(game_record.pit_indices.size()) + " moves is too long to log");
+    }
+
+    GameLogRecordHeader record_header{};
+    record_header.num_moves = static_cast<std::uint16_t>(game_record.pit_indices.size());
+    record_header.final_bank_differential = static_cast<std::int16_t>(game_record.final_bank_differential);
+    record_header.starting_player_index = static_cast<std::uint8_t>(game_record.starting_player_index);
+
+    output_.write(reinterpret_cast<const char*>(&record_header), sizeof(record_header));
+    output_.write(reinterpret_cast<const char*>(game_record.pit_indices.data()),
+                  static_cast<std::streamsize>(game_record.pit_indices.size()));
+    if (!output_)
+    {
+        throw std::runtime_error("Could not write to the game log");
+    }
+}
+
+GameLogReader::GameLogReader(std::istream& input) : input_{ input }
+{
+    GameLogHeader header{};
+    input_.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if ((static_cast<std::size_t>(input_.gcount()) != sizeof(header)) ||
+        (std::memcmp(header.magic, kGameLogMagic, sizeof(header.magic)) != 0))
+    {
+        throw std::runtime_error("Input is not a game log");
+    }
+    if (header.format_version != kGameLogFormatVersion)
+    {
+        throw std::runtime_error("Unsupported game log format version " + std::to_string(header.format_version));
+    }
+
+    num_pits_ = header.num_pits;
+    num_stones_per_pit_ = header.num_stones_per_pit;
+}
+
+bool GameLogReader::read(GameRecord& game_record)
+{
+    GameLogRecordHeader record_header{};
+    input_.read(reinterpret_cast<char*>(&record_header), sizeof(record_header));
+    if (input_.gcount() == 0)
+    {
+        return false;
+    }
+    if (static_cast<std::size_t>(input_.gcount()) != sizeof(record_header))
+    {
+        throw std::runtime_error("Game log ends with a truncated game");
+    }
+
+    game_record.starting_player_index = record_header.starting_player_index;
+    game_record.final_bank_differential = record_header.final_bank_differential;
+    game_record.pit_indices.resize(record_header.num_moves);
+    input_.read(reinterpret_cast<char*>(game_record.pit_indices.data()), static_cast<std::streamsize>(record_header.num_moves));
+    if (static_cast<std::size_t>(input_.gcount()) != record_header.num_moves)
+    {
+        throw std::runtime_error("Game log ends with a truncated game");
+    }
+
+    return true;
+}
+
+std::vector<Position> GameLogReader::replay(const GameRecord& game_record) const
+{
+    BoardState board_state{ num_pits_, num_stones_per_pit_ };
+    GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, game_record.starting_player_index };
+
+    std::vector<Position> positions{};
+    positions.reserve(game_record.pit_indices.size());
+    for (const std::uint8_t pit_index : game_record.pit_indices)
+    {
+        positions.push_back(Position{ board_state, game_mechanics_executor.getActivePlayerIndex() });
+        if (game_mechanics_executor.isGameFinished(board_state) || (pit_index >= num_pits_) ||
+            !game_mechanics_executor.playTurn(pit_index, board_state))
+        {
+            std::stringstream msg{};
+            msg << "Game log has an illegal move " << static_cast<int>(pit_index) << " after " << (positions.size() - 1) << " moves";
+
+            throw std::runtime_error(msg.str());
+        }
+    }
+
+    return positions;
+}
+
+SelfPlay::SelfPlay(const SelfPlayOptions& options) : options_{ options }
+{
+    // Constructing the starting board validates its dimensions
+    const BoardState board_state{ options_.num_pits, options_.num_stones_per_pit };
+}
+
+SelfPlaySummary SelfPlay::run(GameLogWriter* game_log) const
+{
+    const auto start_time{ std::chrono::steady_clock::now() };
+
+    const bool uses_solver{ (options_.policies[0] == SelfPlayPolicy::kSolver) || (options_.policies[1] == SelfPlayPolicy::kSolver) };
+    std::atomic<std::uint64_t> next_game_index{ 0 };
+    std::mutex mutex{};
+    SelfPlaySummary totals{};
+
+    const std::size_t num_threads{ std::max<std::size_t>(options_.num_threads, 1) };
+    std::vector<std::thread> workers{};
+    std::vector<std::exception_ptr> worker_exceptions(num_threads);
+    for (std::size_t t = 0; t < num_threads; ++t)
+    {
+        workers.emplace_back([&, t]()
+        {
+            try
+            {
+                std::unique_ptr<NegamaxSolver> solver{};
+                if (uses_solver)
+                {
+                    solver = std::make_unique<NegamaxSolver>(
+                        std::make_shared<TranspositionTable>(options_.transposition_table_size_bytes, options_.use_huge_pages),
+                        /*num_threads*/ 1);
+                    solver->setOpeningBook(options_.opening_book);
+                }
+
+                // Totals of this thread, merged at the end
+                SelfPlaySummary counters{};
+                for (std::uint64_t game_index = next_game_index++; game_index < options_.num_games; game_index = next_game_index++)
+                {
+                    std::seed_seq seed_sequence{ static_cast<std::uint32_t>(options_.seed), static_cast<std::uint32_t>(options_.seed >> 32),
+                                                 static_cast<std::uint32_t>(game_index), static_cast<std::uint32_t>(game_index >> 32) };
+                    std::mt19937_64 random_engine{ seed_sequence };
+
+                    GameRecord game_record{};
+                    game_record.starting_player_index = static_cast<std::size_t>(game_index % 2);
+                    BoardState board_state{ options_.num_pits, options_.num_stones_per_pit };
+                    GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, game_record.starting_player_index };
+                    while (!game_mechanics_executor.isGameFinished(board_state))
+                    {
+                        const std::size_t active_player_index{ game_mechanics_executor.getActivePlayerIndex() };
+                        const std::vector<std::size_t> legal_pit_indices{ getLegalPitIndices(board_state, active_player_index) };
+
+                        std::size_t pit_index{ 0 };
+                        switch (options_.policies[active_player_index])
+                        {
+                            case SelfPlayPolicy::kRandom:
+                                pit_index = legal_pit_indices[std::uniform_int_distribution<std::size_t>{
+                                    0, legal_pit_indices.size() - 1 }(random_engine)];
+                                break;
+                            case SelfPlayPolicy::kGreedy:
+                                pit_index = pickGreedyPitIndex(board_state, game_mechanics_executor, legal_pit_indices, random_engine);
+                                break;
+                            case SelfPlayPolicy::kSolver:
+                            {
+                                const auto solve_start_time{ std::chrono::steady_clock::now() };
+                                SearchLimits limits{};
+                                if (options_.solver_time_limit_per_move.has_value())
+                                {
+                                    limits.deadline = solve_start_time + options_.solver_time_limit_per_move.value();
+                                }
+                                pit_index = solver->solveWithLimits(board_state, game_mechanics_executor, limits).best_pit_index.value();
+
+                                const std::chrono::duration<double> solve_time{ std::chrono::steady_clock::now() - solve_start_time };
+                                ++counters.num_solver_moves;
+                                counters.total_solver_time += solve_time;
+                                counters.max_solver_time = std::max(counters.max_solver_time, solve_time);
+                                break;
+                            }
+                        }
+
+                        game_mechanics_executor.playTurn(pit_index, board_state);
+                        game_record.pit_indices.push_back(static_cast<std::uint8_t>(pit_index));
+                    }
+
+                    game_record.final_bank_differential = GameMechanicsExecutor::getFinalBankDifferential(board_state, /*player_index*/ 0);
+
+                    ++counters.num_games;
+                    counters.num_moves += game_record.pit_indices.size();
+                    ++counters.num_results[game_mechanics_executor.getWinnerPlayerIndex(board_state).value()];
+
+                    if (game_log != nullptr)
+                    {
+                        std::lock_guard<std::mutex> lock{ mutex };
+                        game_log->write(game_record);
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock{ mutex };
+                totals.num_games += counters.num_games;
+                totals.num_moves += counters.num_moves;
+                for (std::size_t r = 0; r < totals.num_results.size(); ++r)
+                {
+                    totals.num_results[r] += counters.num_results[r];
+                }
+                totals.num_solver_moves += counters.num_solver_moves;
+                totals.total_solver_time += counters.total_solver_time;
+                totals.max_solver_time = std::max(totals.max_solver_time, counters.max_solver_time);
+            }
+            catch (...)
+            {
+                // Stop the other workers after their current game
+                worker_exceptions[t] = std::current_exception();
+                next_game_index = options_.num_games;
+            }
+        });
+    }
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    for (const std::exception_ptr& worker_exception : worker_exceptions)
+    {
+        if (worker_exception != nullptr)
+        {
+            std::rethrow_exception(worker_exception);
+        }
+    }
+
+    totals.elapsed = std::chrono::steady_clock::now() - start_time;
+
+    return totals;
+}
@@ -0,0 +1,103 @@
+#include <solver.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <binary_records.h>
+
+namespace
+{
+
+constexpr char kCheckpointMagic[8]{ 'M', 'N', 'C', 'L', 'S', 'C', 'K', 'P' };
+constexpr std::uint32_t kCheckpointFormatVersion{ 2 };
+
+//! Followed by the saved transposition table unless the solve has finished
+struct CheckpointHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint8_t next_pit_index;
+    std::uint8_t has_solution;
+    std::uint8_t solution_pit_index;
+    std::uint8_t solution_guaranteed_win;
+    PositionRecord root;
+};
+
+static_assert(sizeof(CheckpointHeader) == 48);
+
+} // namespace
+
+void Solver::saveCheckpoint(const std::optional<std::pair<std::size_t, bool>>& solution) const
+{
+    const std::string& path{ checkpoint_settings_->path };
+    const std::string temporary_path{ path + ".tmp" };
+    {
+        std::ofstream output{ temporary_path, std::ios::binary | std::ios::trunc };
+        if (!output)
+        {
+            throw std::runtime_error("Could not open `" + temporary_path + "` for writing");
+        }
+
+        CheckpointHeader header{};
+        std::memcpy(header.magic, kCheckpointMagic, sizeof(kCheckpointMagic));
+        header.version = kCheckpointFormatVersion;
+        header.next_pit_index = static_cast<std::uint8_t>(current_root_pit_index_);
+        header.has_solution = solution.has_value() ? 1 : 0;
+        if (solution.has_value())
+        {
+            header.solution_pit_index = static_cast<std::uint8_t>(solution->first);
+            header.solution_guaranteed_win = solution->second ? 1 : 0;
+        }
+        header.root = makePositionRecord(Position{ checkpoint_board_state_.value(), checkpoint_active_player_index_ });
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        transposition_table_.save(output);
+        output.flush();
+        if (!output)
+        {
+            throw std::runtime_error("Could not write `" + temporary_path + "`");
+        }
+    }
+
+    if (std::rename(temporary_path.c_str(), path.c_str()) != 0)
+    {
+        throw std::runtime_error("Could not replace `" + path + "`");
+    }
+}
+
+std::optional<Solver::CheckpointProgress> Solver::loadCheckpoint()
+{
+    const std::string& path{ checkpoint_settings_->path };
+    std::ifstream input{ path, std::ios::binary };
+    if (!input)
+    {
+        return std::nullopt;
+    }
+
+    CheckpointHeader header{};
+    input.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if ((static_cast<std::size_t>(input.gcount()) != sizeof(header)) ||
+        (std::memcmp(header.magic, kCheckpointMagic, sizeof(kCheckpointMagic)) != 0) || (header.version != kCheckpointFormatVersion))
+    {
+        throw std::runtime_error("`" + path + "` is not a solver checkpoint");
+    }
+
+    const PositionRecord root{ makePositionRecord(Position{ checkpoint_board_state_.value(), checkpoint_active_player_index_ }) };
+    if (std::memcmp(&header.root, &root, sizeof(root)) != 0)
+    {
+        throw std::runtime_error("`" + path + "` is a checkpoint of another position");
+    }
+
+    CheckpointProgress progress{ header.next_pit_index, std::nullopt };
+    if (header.has_solution != 0)
+    {
+        progress.solution = std::make_pair(static_cast<std::size_t>(header.solution_pit_index), header.solution_guaranteed_win != 0);
+        return progress;
+    }
+
+    transposition_table_.load(input);
+
+    return progress;
+}
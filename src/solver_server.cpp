@@ -0,0 +1,346 @@
+#include <solver_server.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <game_mechanics.h>
+#include <position_text.h>
+
+namespace
+{
+
+//! Longer request lines are rejected rather than buffered, so a misbehaving client cannot exhaust memory
+constexpr std::size_t kMaxRequestLength{ 4096 };
+
+constexpr int kListenBacklog{ 64 };
+
+std::runtime_error makeSocketError(const std::string& action)
+{
+    return std::runtime_error("Could not " + action + ": " + std::strerror(errno));
+}
+
+//! Writes all of `data`, returning false if the connection is gone
+bool sendAll(const int fd, const std::string& data)
+{
+    std::size_t num_sent_bytes{ 0 };
+    while (num_sent_bytes < data.size())
+    {
+        // Without `MSG_NOSIGNAL`, writing to a connection the client has closed would kill the process with `SIGPIPE`
+        const ssize_t n{ ::send(fd, data.data() + num_sent_bytes, data.size() - num_sent_bytes, MSG_NOSIGNAL) };
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        num_sent_bytes += static_cast<std::size_t>(n);
+    }
+
+    return true;
+}
+
+} // namespace
+
+SolverServer::SolverServer(const SolverServerOptions& options) :
+            options_{ options }, transposition_table_{ std::make_shared<TranspositionTable>(options.transposition_table_size_bytes,
+                                                                                                   options.use_huge_pages) },
+            request_queue_{ options.queue_capacity }
+{
+    const std::size_t num_workers{ std::max<std::size_t>(options_.num_workers, 1) };
+    for (std::size_t i = 0; i < num_workers; ++i)
+    {
+        workers_.emplace_back([this]() { runWorker(); });
+    }
+}
+
+SolverServer::~SolverServer()
+{
+    stop();
+
+    {
+        std::unique_lock<std::mutex> lock{ connections_mutex_ };
+        connections_finished_condition_.wait(lock, [this]() { return num_connection_threads_ == 0; });
+    }
+
+    request_queue_.close();
+    for (std::thread& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void SolverServer::serveTcp(const std::string& host, const std::uint16_t port)
+{
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (::inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+    {
+        throw std::invalid_argument("`" + host + "` is not an IPv4 address");
+    }
+
+    const int listen_fd{ ::socket(AF_INET, SOCK_STREAM, 0) };
+    if (listen_fd < 0)
+    {
+        throw makeSocketError("create a TCP socket");
+    }
+
+    // Allows restarting the server right away instead of waiting for connections in `TIME_WAIT` to expire
+    const int reuse_address{ 1 };
+    ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse_address, sizeof(reuse_address));
+
+    if ((::bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) ||
+        (::listen(listen_fd, kListenBacklog) != 0))
+    {
+        const std::runtime_error error{ makeSocketError("listen on " + host + ":" + std::to_string(port)) };
+        ::close(listen_fd);
+        throw error;
+    }
+
+    serve(listen_fd);
+}
+
+void SolverServer::serveUnix(const std::string& path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        throw std::invalid_argument("Socket path `" + path + "` is too long");
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    const int listen_fd{ ::socket(AF_UNIX, SOCK_STREAM, 0) };
+    if (listen_fd < 0)
+    {
+        throw makeSocketError("create a Unix domain socket");
+    }
+
+    // A socket file left behind by a previous server would make `bind()` fail
+    ::unlink(path.c_str());
+    if ((::bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) ||
+        (::listen(listen_fd, kListenBacklog) != 0))
+    {
+        const std::runtime_error error{ makeSocketError("listen on `" + path + "`") };
+        ::close(listen_fd);
+        throw error;
+    }
+
+    serve(listen_fd);
+    ::unlink(path.c_str());
+}
+
+void SolverServer::stop()
+{
+    // Also interrupts the workers' solves, which poll the flag
+    stop_requested_.store(true);
+
+    // Shutting the sockets down wakes up the threads blocked in `accept()` and `recv()`. They close the descriptors.
+    std::lock_guard<std::mutex> lock{ connections_mutex_ };
+    if (listen_fd_ >= 0)
+    {
+        ::shutdown(listen_fd_, SHUT_RDWR);
+    }
+    for (const int connection_fd : connection_fds_)
+    {
+        ::shutdown(connection_fd, SHUT_RDWR);
+    }
+}
+
+std::string SolverServer::handleRequest(const std::string& request, bool& close_connection)
+{
+    close_connection = false;
+
+    std::istringstream stream{ request };
+    std::string command{};
+    stream >> command;
+
+    if (command == "ping")
+    {
+        return "ok";
+    }
+    if (command == "quit")
+    {
+        close_connection = true;
+        return "ok";
+    }
+    if ((command != "solve") && (command != "search"))
+    {
+        return "error Unknown command `" + command + "`";
+    }
+
+    std::optional<std::chrono::milliseconds> time_limit{};
+    std::optional<Position> position{};
+    try
+    {
+        if (command == "search")
+        {
+            long time_limit_ms{ -1 };
+            stream >> time_limit_ms;
+            if (!stream || (time_limit_ms < 0))
+            {
+                return "error Expected a time limit in milliseconds";
+            }
+            time_limit = std::chrono::milliseconds{ time_limit_ms };
+        }
+
+        std::string position_text{};
+        std::getline(stream, position_text);
+        position = parseTextPosition(position_text);
+    }
+    catch (const std::exception& e)
+    {
+        return std::string{ "error " } + e.what();
+    }
+
+    Request queued_request{ position.value(), time_limit, {} };
+    std::future<NegamaxResult> result{ queued_request.result.get_future() };
+    if (!request_queue_.push(std::move(queued_request)))
+    {
+        return "error Server is stopping";
+    }
+
+    try
+    {
+        return "ok " + formatTextResult(result.get());
+    }
+    catch (const std::exception& e)
+    {
+        return std::string{ "error " } + e.what();
+    }
+}
+
+void SolverServer::serve(const int listen_fd)
+{
+    {
+        std::lock_guard<std::mutex> lock{ connections_mutex_ };
+        listen_fd_ = listen_fd;
+    }
+
+    while (!stop_requested_.load())
+    {
+        const int connection_fd{ ::accept(listen_fd, nullptr, nullptr) };
+        if (connection_fd < 0)
+        {
+            if ((errno == EINTR) || (errno == ECONNABORTED))
+            {
+                continue;
+            }
+            // `stop()` shut the socket down, or it failed for good
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock{ connections_mutex_ };
+        if (stop_requested_.load())
+        {
+            ::close(connection_fd);
+            break;
+        }
+        connection_fds_.insert(connection_fd);
+        ++num_connection_threads_;
+        std::thread{ [this, connection_fd]() { serveConnection(connection_fd); } }.detach();
+    }
+
+    std::lock_guard<std::mutex> lock{ connections_mutex_ };
+    listen_fd_ = -1;
+    ::close(listen_fd);
+}
+
+void SolverServer::serveConnection(const int connection_fd)
+{
+    std::string buffer{};
+    char chunk[4096];
+    bool close_connection{ false };
+    while (!close_connection && !stop_requested_.load())
+    {
+        const std::size_t line_end{ buffer.find('\n') };
+        if (line_end == std::string::npos)
+        {
+            if (buffer.size() > kMaxRequestLength)
+            {
+                sendAll(connection_fd, "error Request is too long\n");
+                break;
+            }
+
+            const ssize_t n{ ::recv(connection_fd, chunk, sizeof(chunk), 0) };
+            if ((n < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                break;
+            }
+            buffer.append(chunk, static_cast<std::size_t>(n));
+            continue;
+        }
+
+        std::string request{ buffer.substr(0, line_end) };
+        buffer.erase(0, line_end + 1);
+        if (!request.empty() && (request.back() == '\r'))
+        {
+            request.pop_back();
+        }
+
+        if (!sendAll(connection_fd, handleRequest(request, close_connection) + "\n"))
+        {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock{ connections_mutex_ };
+    connection_fds_.erase(connection_fd);
+    ::close(connection_fd);
+    --num_connection_threads_;
+    connections_finished_condition_.notify_all();
+}
+
+void SolverServer::runWorker()
+{
+    NegamaxSolver solver{ transposition_table_, /*num_threads*/ 1 };
+    solver.setOpeningBook(options_.opening_book);
+    solver.setEndgameTablebase(options_.endgame_tablebase);
+    // Interrupts the solve in flight once `stop()` is called, so connection threads waiting for it can finish
+    solver.setStopFlag(&stop_requested_);
+
+    for (std::optional<Request> request{ request_queue_.pop() }; request.has_value(); request = request_queue_.pop())
+    {
+        try
+        {
+            // Requests still queued when the server stops are answered right away instead of being solved
+            if (stop_requested_.load())
+            {
+                throw std::runtime_error("Server is stopping");
+            }
+
+            const GameMechanicsExecutor game_mechanics_executor{ TurnExecutor{}, request->position.active_player_index };
+            if (request->time_limit.has_value())
+            {
+                SearchLimits limits{};
+                limits.deadline = std::chrono::steady_clock::now() + request->time_limit.value();
+                request->result.set_value(solver.solveWithLimits(request->position.board_state, game_mechanics_executor, limits));
+            }
+            else
+            {
+                request->result.set_value(solver.solve(request->position.board_state, game_mechanics_executor));
+            }
+        }
+        catch (...)
+        {
+            request->result.set_exception(std::current_exception());
+        }
+    }
+}
@@ -0,0 +1,176 @@
+#include <transposition_table.h>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include <sys/mman.h>
+
+namespace
+{
+
+//! Size of the huge pages on x86-64 and in the default configuration on AArch64
+constexpr std::size_t kHugePageSize{ std::size_t{ 2 } << 20 };
+
+constexpr char kMagic[8]{ 'M', 'N', 'C', 'L', 'T', 'T', 'A', 'B' };
+constexpr std::uint32_t kFormatVersion{ 1 };
+
+struct SavedTableHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint8_t generation;
+    std::uint8_t reserved[3];
+    std::uint64_t num_entries;
+};
+
+static_assert(sizeof(SavedTableHeader) == 24);
+
+//! A saved slot: its key and packed data
+struct SavedEntry
+{
+    std::uint64_t key;
+    std::uint64_t data;
+};
+
+//! Entries written per call to the stream
+constexpr std::size_t kEntriesPerBlock{ 4096 };
+
+} // namespace
+
+TranspositionTable::TranspositionTable(const std::size_t size_bytes, const bool use_huge_pages) :
+            num_buckets_{ getNumBuckets(size_bytes) }, mapping_size_bytes_{ num_buckets_ * sizeof(Bucket) },
+            page_backing_{ PageBacking::kDefault }, buckets_{ nullptr }, bucket_mask_{ num_buckets_ - 1 }
+{
+    void* memory{ MAP_FAILED };
+    if (use_huge_pages)
+    {
+        // `MAP_HUGETLB` mappings must be a whole number of huge pages, and fail unless enough of them are reserved
+        const std::size_t huge_mapping_size_bytes{ (mapping_size_bytes_ + kHugePageSize - 1) / kHugePageSize * kHugePageSize };
+        memory = ::mmap(nullptr, huge_mapping_size_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED)
+        {
+            mapping_size_bytes_ = huge_mapping_size_bytes;
+            page_backing_ = PageBacking::kHugeTlb;
+        }
+    }
+
+    if (memory == MAP_FAILED)
+    {
+        memory = ::mmap(nullptr, mapping_size_bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            throw std::bad_alloc{};
+        }
+
+        if (use_huge_pages && (::madvise(memory, mapping_size_bytes_, MADV_HUGEPAGE) == 0))
+        {
+            page_backing_ = PageBacking::kTransparentHugePages;
+        }
+    }
+
+    // Anonymous mappings are zero-filled, which is already the empty state of every slot, so pages are only committed
+    // once the search touches them
+    buckets_ = static_cast<Bucket*>(memory);
+    for (std::size_t i = 0; i < num_buckets_; ++i)
+    {
+        new (&buckets_[i]) Bucket;
+    }
+}
+
+TranspositionTable::~TranspositionTable()
+{
+    // `Bucket` is trivially destructible, so the mapping can be released directly
+    ::munmap(buckets_, mapping_size_bytes_);
+}
+
+void TranspositionTable::save(std::ostream& output) const
+{
+    SavedTableHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.generation = getGeneration();
+    for (std::size_t i = 0; i < num_buckets_; ++i)
+    {
+        for (const Slot& slot : buckets_[i].slots)
+        {
+            header.num_entries += (slot.data.load(std::memory_order_relaxed) != 0) ? 1 : 0;
+        }
+    }
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Buckets in order and the depth-preferred slot first, so loading into a table of the same size restores the same
+    // layout
+    std::vector<SavedEntry> block{};
+    block.reserve(kEntriesPerBlock);
+    const auto writeBlock{ [&]()
+    {
+        output.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(block.size() * sizeof(SavedEntry)));
+        block.clear();
+    } };
+    for (std::size_t i = 0; i < num_buckets_; ++i)
+    {
+        for (const Slot& slot : buckets_[i].slots)
+        {
+            const std::uint64_t data{ slot.data.load(std::memory_order_relaxed) };
+            if (data == 0)
+            {
+                continue;
+            }
+
+            block.push_back(SavedEntry{ slot.checked_key.load(std::memory_order_relaxed) ^ data, data });
+            if (block.size() == kEntriesPerBlock)
+            {
+                writeBlock();
+            }
+        }
+    }
+    writeBlock();
+
+    if (!output)
+    {
+        throw std::runtime_error("Could not write the transposition table");
+    }
+}
+
+void TranspositionTable::load(std::istream& input)
+{
+    SavedTableHeader header{};
+    input.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if ((static_cast<std::size_t>(input.gcount()) != sizeof(header)) || (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) ||
+        (header.version != kFormatVersion))
+    {
+        throw std::runtime_error("Input is not a saved transposition table");
+    }
+
+    clear();
+    generation_.store(header.generation, std::memory_order_relaxed);
+
+    std::vector<SavedEntry> block(kEntriesPerBlock);
+    for (std::uint64_t num_loaded_entries = 0; num_loaded_entries < header.num_entries;)
+    {
+        const std::size_t num_block_entries{ static_cast<std::size_t>(
+            std::min<std::uint64_t>(kEntriesPerBlock, header.num_entries - num_loaded_entries)) };
+        input.read(reinterpret_cast<char*>(block.data()), static_cast<std::streamsize>(num_block_entries * sizeof(SavedEntry)));
+        if (static_cast<std::size_t>(input.gcount()) != (num_block_entries * sizeof(SavedEntry)))
+        {
+            throw std::runtime_error("Saved transposition table ends early");
+        }
+
+        for (std::size_t e = 0; e < num_block_entries; ++e)
+        {
+            // First free slot of the bucket
+            for (Slot& slot : buckets_[block[e].key & bucket_mask_].slots)
+            {
+                if (slot.data.load(std::memory_order_relaxed) == 0)
+                {
+                    write(slot, unpack(block[e].key, block[e].data));
+                    break;
+                }
+            }
+        }
+        num_loaded_entries += num_block_entries;
+    }
+}